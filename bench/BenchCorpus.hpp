@@ -0,0 +1,336 @@
+/**
+ * @file BenchCorpus.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_BENCH_CORPUS_HPP
+#define INCLUDED_BENCH_CORPUS_HPP
+
+#include <srcSAXEventDispatchUtilities.hpp>
+#include <srcSAXController.hpp>
+#include <srcml.h>
+
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+namespace bench {
+
+    /**
+     * Corpus
+     *
+     * Synthetic C++ corpus rendered to a srcML archive.  Generation is
+     * deterministic for a given shape, scale and seed.
+     *
+     * Shapes:
+     *  - small      many small units (classes with a few members and methods)
+     *  - huge       one unit holding many functions
+     *  - deep       deeply nested namespaces, classes and control flow
+     *  - templates  template classes and functions with nested arguments
+     */
+    struct Corpus {
+        std::string shape;
+        std::size_t units;
+        std::string srcml;
+    };
+
+    class Generator {
+
+    public:
+
+        Generator(unsigned seed) : random(seed) {}
+
+        std::vector<std::string> Sources(const std::string & shape, std::size_t scale) {
+
+            std::vector<std::string> sources;
+
+            if(shape == "small") {
+                for(std::size_t count = 0; count < 200 * scale; ++count)
+                    sources.push_back(SmallUnit(count));
+            } else if(shape == "huge") {
+                std::string source;
+                for(std::size_t count = 0; count < 2000 * scale; ++count)
+                    source += Function("huge" + std::to_string(count));
+                sources.push_back(source);
+            } else if(shape == "deep") {
+                for(std::size_t count = 0; count < 10 * scale; ++count)
+                    sources.push_back(DeepUnit(count, 40));
+            } else if(shape == "templates") {
+                for(std::size_t count = 0; count < 50 * scale; ++count)
+                    sources.push_back(TemplateUnit(count));
+            } else {
+                std::cerr << "unknown corpus shape: " << shape << '\n';
+                std::exit(1);
+            }
+
+            return sources;
+
+        }
+
+    private:
+
+        std::size_t Pick(std::size_t low, std::size_t high) {
+            return low + random() % (high - low + 1);
+        }
+
+        std::string Type() {
+            static const char * types[] = { "int", "double", "std::string", "const char *", "std::vector<int>", "unsigned long", "bool" };
+            return types[Pick(0, sizeof(types) / sizeof(types[0]) - 1)];
+        }
+
+        std::string Statements(std::size_t count) {
+
+            std::string body;
+            for(std::size_t statement = 0; statement < count; ++statement) {
+                std::string var = "v" + std::to_string(statement);
+                switch(Pick(0, 3)) {
+                    case 0: body += "    int " + var + " = a + " + std::to_string(Pick(0, 99)) + ";\n"; break;
+                    case 1: body += "    int " + var + " = 0;\n    " + var + " = b * " + var + " + a;\n"; break;
+                    case 2: body += "    int " + var + " = compute(a, b, \"x<" + std::to_string(statement) + "\");\n"; break;
+                    default: body += "    int " + var + " = 1;\n    if(" + var + " > a) { " + var + " = helper(" + var + ", b); }\n"; break;
+                }
+            }
+            return body;
+
+        }
+
+        // each random draw is its own statement so the output does not depend on evaluation order
+        std::string Function(const std::string & name) {
+            std::string source = "int " + name + "(int a, " + Type() + " b, const std::string & c) {\n";
+            source += Statements(Pick(3, 8));
+            source += "    return a;\n}\n\n";
+            return source;
+        }
+
+        std::string SmallUnit(std::size_t index) {
+
+            std::string name = "Small" + std::to_string(index);
+            std::string source = "class " + name + " {\npublic:\n";
+            for(std::size_t member = 0, members = Pick(2, 5); member < members; ++member)
+                source += "    " + Type() + " m" + std::to_string(member) + ";\n";
+            for(std::size_t method = 0, methods = Pick(1, 3); method < methods; ++method)
+                source += "    void method" + std::to_string(method) + "(int a, int b) { int c = a + b; call(c, \"" + name + "\"); }\n";
+            source += "};\n\n";
+            source += Function("free" + std::to_string(index));
+            return source;
+
+        }
+
+        std::string DeepUnit(std::size_t index, std::size_t depth) {
+
+            // namespaces, then nested structs, then one function nesting control flow
+            std::string source;
+            for(std::size_t level = 0; level < depth; ++level) {
+                std::string var = "d" + std::to_string(level);
+                if(level < depth / 8) source += "namespace n" + std::to_string(index) + "_" + std::to_string(level) + " {\n";
+                else if(level < depth / 4) source += "struct S" + std::to_string(level) + " {\nint " + var + ";\n";
+                else if(level == depth / 4) source += "void deep(int a, int b) {\n";
+                else if(level % 3 == 0) source += "while(a > " + std::to_string(level) + ") {\n";
+                else if(level % 3 == 1) source += "if(a < b) {\nint " + var + " = compute(a, b);\n";
+                else source += "for(int " + var + " = 0; " + var + " < b; ++" + var + ") {\na = a + " + var + ";\n";
+            }
+            for(std::size_t level = depth; level-- > 0;) {
+                if(level < depth / 8) source += "}\n";
+                else if(level < depth / 4) source += "};\n";
+                else source += "}\n";
+            }
+            return source;
+
+        }
+
+        std::string TemplateArgument(std::size_t depth) {
+            if(!depth) return Type();
+            switch(Pick(0, 2)) {
+                case 0: return "std::vector<" + TemplateArgument(depth - 1) + ">";
+                case 1: {
+                    std::string key = TemplateArgument(depth - 1);
+                    return "std::map<" + key + ", " + TemplateArgument(depth - 1) + ">";
+                }
+                default: return "std::pair<" + TemplateArgument(depth - 1) + ", int>";
+            }
+        }
+
+        std::string TemplateUnit(std::size_t index) {
+
+            std::string name = "Box" + std::to_string(index);
+            std::string source = "template<typename T, typename U = " + TemplateArgument(2) + ">\nclass " + name + " : public Base<T, U> {\npublic:\n";
+            for(std::size_t member = 0, members = Pick(3, 6); member < members; ++member)
+                source += "    " + TemplateArgument(Pick(1, 3)) + " m" + std::to_string(member) + ";\n";
+            source += "    template<typename V>\n    " + TemplateArgument(2);
+            source += " get(const V & v, " + TemplateArgument(1) + " w) const { return convert<T, V>(v, w); }\n";
+            source += "};\n\n";
+            source += "template<typename T>\n" + TemplateArgument(2) + " make" + std::to_string(index) + "(T t) {\n";
+            source += "    " + name + "<" + TemplateArgument(2) + "> box;\n";
+            source += "    auto result = box.template get<" + TemplateArgument(1) + ">(t, {});\n";
+            source += "    return result;\n}\n\n";
+            return source;
+
+        }
+
+        std::mt19937 random;
+
+    };
+
+    /**
+     * SourcesToSrcML
+     *
+     * Render sources into a srcML archive with libsrcml, one unit each.
+     */
+    inline std::string SourcesToSrcML(const std::vector<std::string> & sources) {
+
+        struct srcml_archive * archive;
+        struct srcml_unit * unit;
+        char * ch = 0;
+        size_t size = 0;
+
+        archive = srcml_archive_create();
+        srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+        srcml_archive_write_open_memory(archive, &ch, &size);
+
+        for(std::size_t index = 0; index < sources.size(); ++index) {
+
+            unit = srcml_unit_create(archive);
+            srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+            srcml_unit_set_filename(unit, ("bench" + std::to_string(index) + ".cpp").c_str());
+
+            srcml_unit_parse_memory(unit, sources[index].c_str(), sources[index].size());
+            srcml_archive_write_unit(archive, unit);
+            srcml_unit_free(unit);
+
+        }
+
+        srcml_archive_close(archive);
+        srcml_archive_free(archive);
+
+        std::string srcml(ch, size);
+        std::free(ch);
+        return srcml;
+
+    }
+
+    inline Corpus MakeCorpus(const std::string & shape, std::size_t scale, unsigned seed) {
+        Generator generator(seed);
+        std::vector<std::string> sources = generator.Sources(shape, scale);
+        return Corpus{ shape, sources.size(), SourcesToSrcML(sources) };
+    }
+
+    /* discards policy notifications */
+    class NullListener : public srcSAXEventDispatch::PolicyListener {
+    public:
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+    };
+
+    struct Result {
+        double seconds;
+        std::size_t events;
+        std::size_t bytes;
+    };
+
+    /**
+     * Run
+     *
+     * Parse the corpus repeat times with a fresh dispatcher each time and
+     * keep the fastest run.
+     */
+    template <typename Dispatcher>
+    Result Run(const Corpus & corpus, std::size_t repeat) {
+
+        Result best{ 0, 0, corpus.srcml.size() };
+
+        for(std::size_t run = 0; run < repeat; ++run) {
+
+            NullListener listener;
+            Dispatcher dispatcher(&listener);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            srcSAXController control(corpus.srcml);
+            control.parse(&dispatcher);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            double seconds = std::chrono::duration<double>(end - start).count();
+            if(run == 0 || seconds < best.seconds) best.seconds = seconds;
+            best.events = dispatcher.GetStats().eventsDispatched;
+
+        }
+
+        return best;
+
+    }
+
+    inline void ReportHeader(std::ostream & out) {
+        out << std::left << std::setw(18) << "dispatcher" << std::setw(44) << "policies" << std::setw(11) << "corpus"
+            << std::right << std::setw(10) << "MB" << std::setw(12) << "events"
+            << std::setw(14) << "events/sec" << std::setw(10) << "MB/sec" << std::setw(10) << "ns/event" << '\n';
+    }
+
+    inline void Report(std::ostream & out, const std::string & dispatcher, const std::string & policies, const Corpus & corpus, const Result & result) {
+        double megabytes = result.bytes / (1024.0 * 1024.0);
+        out << std::left << std::setw(18) << dispatcher << std::setw(44) << policies << std::setw(11) << corpus.shape
+            << std::right << std::fixed << std::setprecision(2) << std::setw(10) << megabytes
+            << std::setw(12) << result.events
+            << std::setprecision(0) << std::setw(14) << result.events / result.seconds
+            << std::setprecision(2) << std::setw(10) << megabytes / result.seconds
+            << std::setprecision(1) << std::setw(10) << result.seconds * 1e9 / result.events << '\n';
+        out.unsetf(std::ios::floatfield);
+    }
+
+    /**
+     * Options
+     *
+     * Command line: [--scale N] [--repeat N] [--seed N] [--shape NAME]...
+     * Without --shape all shapes are run.
+     */
+    struct Options {
+
+        Options(int argc, char ** argv) : scale(1), repeat(3), seed(1) {
+
+            for(int arg = 1; arg < argc; ++arg) {
+                std::string option = argv[arg];
+                if(arg + 1 >= argc) Usage(argv[0]);
+                if(option == "--scale") scale = std::strtoul(argv[++arg], 0, 10);
+                else if(option == "--repeat") repeat = std::strtoul(argv[++arg], 0, 10);
+                else if(option == "--seed") seed = std::strtoul(argv[++arg], 0, 10);
+                else if(option == "--shape") shapes.push_back(argv[++arg]);
+                else Usage(argv[0]);
+            }
+
+            if(!scale || !repeat) Usage(argv[0]);
+            if(shapes.empty()) shapes = { "small", "huge", "deep", "templates" };
+
+        }
+
+        static void Usage(const char * program) {
+            std::cerr << "usage: " << program << " [--scale N] [--repeat N] [--seed N] [--shape small|huge|deep|templates]...\n";
+            std::exit(1);
+        }
+
+        std::size_t scale;
+        std::size_t repeat;
+        unsigned seed;
+        std::vector<std::string> shapes;
+
+    };
+
+}
+
+#endif
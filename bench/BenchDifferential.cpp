@@ -0,0 +1,129 @@
+/**
+ * @file BenchDifferential.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+    Differential check of dispatch paths against the reference: a fresh
+    srcSAXEventDispatcher.  EventRecorderPolicy records every event each
+    candidate delivers, alongside the full policy set so nested listeners
+    are exercised, over the bench corpora.  The first divergence of each
+    candidate is reported; the exit status is 1 if any candidate diverged.
+
+    Candidates: a dispatcher reused after Reset(), one regenerating the
+    archive, one with a tracer attached, and srcSAXParallelDispatcher
+    (compared unit by unit).  Add new dispatch paths to the table in main.
+*/
+
+#include <BenchCorpus.hpp>
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXParallelDispatcher.hpp>
+#include <srcSAXEventRecorder.hpp>
+#include <srcSAXEventTracer.hpp>
+#include <ClassPolicy.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <DeclTypePolicy.hpp>
+#include <ParamTypePolicy.hpp>
+#include <FunctionCallPolicy.hpp>
+#include <ExprPolicy.hpp>
+
+using namespace srcSAXEventDispatch;
+
+typedef srcSAXEventDispatcher<EventRecorderPolicy, ClassPolicy, FunctionSignaturePolicy, DeclTypePolicy, ParamTypePolicy, CallPolicy, ExprPolicy> Dispatcher;
+typedef srcSAXParallelDispatcher<EventRecorderPolicy, ClassPolicy, FunctionSignaturePolicy, DeclTypePolicy, ParamTypePolicy, CallPolicy, ExprPolicy> ParallelDispatcher;
+
+struct Candidate {
+    std::string name;
+    RecordingComparison comparison;
+    std::function<void(const std::string & srcml, RecordingListener & listener)> run;
+};
+
+static void Reference(const std::string & srcml, RecordingListener & listener) {
+    Dispatcher dispatcher(&listener);
+    srcSAXController control(srcml);
+    control.parse(&dispatcher);
+}
+
+int main(int argc, char ** argv) {
+
+    bench::Options options(argc, argv);
+
+    std::vector<Candidate> candidates = {
+
+        { "reset", RecordingComparison::ordered, [](const std::string & srcml, RecordingListener & listener) {
+            Dispatcher dispatcher(&listener);
+            srcSAXController first(srcml);
+            first.parse(&dispatcher);
+            listener.Clear();
+            dispatcher.Reset();
+            srcSAXController second(srcml);
+            second.parse(&dispatcher);
+        } },
+
+        { "archive", RecordingComparison::ordered, [](const std::string & srcml, RecordingListener & listener) {
+            Dispatcher dispatcher(&listener, true);
+            srcSAXController control(srcml);
+            control.parse(&dispatcher);
+        } },
+
+        { "tracer", RecordingComparison::ordered, [](const std::string & srcml, RecordingListener & listener) {
+            std::ostringstream trace;
+            srcSAXEventTracer tracer(trace);
+            Dispatcher dispatcher(&listener);
+            dispatcher.SetTracer(&tracer);
+            srcSAXController control(srcml);
+            control.parse(&dispatcher);
+        } },
+
+        { "parallel", RecordingComparison::per_unit, [](const std::string & srcml, RecordingListener & listener) {
+            ParallelDispatcher dispatcher(&listener);
+            dispatcher.Parse(srcml);
+        } },
+
+    };
+
+    bool diverged = false;
+    for(const std::string & shape : options.shapes) {
+
+        bench::Corpus corpus = bench::MakeCorpus(shape, options.scale, options.seed);
+
+        RecordingListener reference;
+        Reference(corpus.srcml, reference);
+
+        for(const Candidate & candidate : candidates) {
+
+            RecordingListener recorded;
+            candidate.run(corpus.srcml, recorded);
+
+            std::ostringstream report;
+            bool same = CompareRecordings(reference.recordings, recorded.recordings, candidate.comparison, report);
+            std::cout << std::left << std::setw(11) << shape << std::setw(10) << candidate.name << std::right
+                      << std::setw(12) << reference.NumberEvents() << " events  " << (same ? "ok" : "DIVERGED") << '\n';
+            if(!same) {
+                std::cout << report.str();
+                diverged = true;
+            }
+
+        }
+
+    }
+
+    return diverged ? 1 : 0;
+
+}
@@ -0,0 +1,76 @@
+/**
+ * @file BenchEventDispatcher.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+    Microbenchmarks for srcSAXEventDispatcher: each policy alone, a few
+    common combinations, and the dispatcher with no policies as a baseline.
+*/
+
+#include <BenchCorpus.hpp>
+
+#include <srcSAXEventDispatcher.hpp>
+#include <ClassPolicy.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <DeclTypePolicy.hpp>
+#include <ParamTypePolicy.hpp>
+#include <FunctionCallPolicy.hpp>
+#include <ExprPolicy.hpp>
+#include <CollectNLContext.hpp>
+#include <SNLPolicy.hpp>
+#include <StereotypePolicy.hpp>
+#include <srcSlicePolicy.hpp>
+
+using namespace srcSAXEventDispatch;
+
+template <typename ...policies>
+void Bench(const std::string & name, const bench::Corpus & corpus, const bench::Options & options) {
+    bench::Report(std::cout, "EventDispatcher", name, corpus, bench::Run<srcSAXEventDispatcher<policies...>>(corpus, options.repeat));
+}
+
+int main(int argc, char ** argv) {
+
+    bench::Options options(argc, argv);
+
+    bench::ReportHeader(std::cout);
+    for(const std::string & shape : options.shapes) {
+
+        bench::Corpus corpus = bench::MakeCorpus(shape, options.scale, options.seed);
+
+        Bench<>("(none)", corpus, options);
+
+        Bench<ClassPolicy>("ClassPolicy", corpus, options);
+        Bench<FunctionSignaturePolicy>("FunctionSignaturePolicy", corpus, options);
+        Bench<DeclTypePolicy>("DeclTypePolicy", corpus, options);
+        Bench<ParamTypePolicy>("ParamTypePolicy", corpus, options);
+        Bench<CallPolicy>("CallPolicy", corpus, options);
+        Bench<ExprPolicy>("ExprPolicy", corpus, options);
+        Bench<NLContextPolicy>("NLContextPolicy", corpus, options);
+        Bench<SourceNLPolicy>("SourceNLPolicy", corpus, options);
+        Bench<StereotypePolicy>("StereotypePolicy", corpus, options);
+        Bench<srcSlicePolicy>("srcSlicePolicy", corpus, options);
+
+        Bench<DeclTypePolicy, ParamTypePolicy>("DeclType+ParamType", corpus, options);
+        Bench<FunctionSignaturePolicy, CallPolicy>("FunctionSignature+Call", corpus, options);
+        Bench<DeclTypePolicy, ExprPolicy, CallPolicy>("DeclType+Expr+Call", corpus, options);
+        Bench<ClassPolicy, FunctionSignaturePolicy, DeclTypePolicy, ParamTypePolicy, CallPolicy, ExprPolicy>("Class+FunctionSignature+DeclType+...", corpus, options);
+
+    }
+
+}
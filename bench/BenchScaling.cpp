@@ -0,0 +1,229 @@
+/**
+ * @file BenchScaling.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+    Scaling curves: one policy set over generated corpora of several sizes
+    with 1..N threads (srcSAXParallelDispatcher).  Each configuration runs
+    in a forked child so its peak RSS is its own.  One CSV row per
+    configuration:
+
+    policies,shape,scale,threads,units,corpus_bytes,wall_seconds,events,
+    events_per_sec,baseline_rss_kb,peak_rss_kb,retained_kb
+
+    baseline_rss_kb is the child's RSS before dispatching (mostly the
+    corpus), peak_rss_kb its VmHWM after (the high-water mark is reset
+    first where /proc/self/clear_refs allows), and retained_kb the RSS
+    still held after the dispatcher is destroyed while the listener keeps
+    every policy result.
+*/
+
+#include <BenchCorpus.hpp>
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXParallelDispatcher.hpp>
+#include <ClassPolicy.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <DeclTypePolicy.hpp>
+#include <ParamTypePolicy.hpp>
+#include <FunctionCallPolicy.hpp>
+#include <ExprPolicy.hpp>
+
+#include <fstream>
+#include <cstdio>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace srcSAXEventDispatch;
+
+/* keeps every result the policies hand out, as a real consumer would */
+class RetainingListener : public PolicyListener {
+public:
+    void Notify(const PolicyDispatcher * policy, const srcSAXEventContext & ctx) override {
+        results.push_back(policy->Data<void>());
+    }
+    std::vector<void *> results;
+};
+
+template <typename ...policies>
+DispatchStats Dispatch(const std::string & srcml, std::size_t threads, PolicyListener * listener) {
+    srcSAXParallelDispatcher<policies...> dispatcher(listener, nullptr, threads);
+    dispatcher.Parse(srcml);
+    return dispatcher.GetStats();
+}
+
+typedef DispatchStats (*DispatchFunction)(const std::string & srcml, std::size_t threads, PolicyListener * listener);
+
+static const std::vector<std::pair<std::string, DispatchFunction>> policySets = {
+    { "none",      Dispatch<> },
+    { "class",     Dispatch<ClassPolicy> },
+    { "signature", Dispatch<FunctionSignaturePolicy> },
+    { "decltype",  Dispatch<DeclTypePolicy> },
+    { "call",      Dispatch<CallPolicy> },
+    { "expr",      Dispatch<ExprPolicy> },
+    { "all",       Dispatch<ClassPolicy, FunctionSignaturePolicy, DeclTypePolicy, ParamTypePolicy, CallPolicy, ExprPolicy> },
+};
+
+/* a "Vm...:" field of /proc/self/status in kB, 0 if unavailable */
+static std::size_t ProcStatus(const std::string & field) {
+
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)) {
+        if(line.compare(0, field.size(), field) == 0 && line.size() > field.size() && line[field.size()] == ':')
+            return std::strtoul(line.c_str() + field.size() + 1, 0, 10);
+    }
+    return 0;
+
+}
+
+/* reset VmHWM to the current RSS (Linux 4.0+); best effort */
+static void ResetPeakRSS() {
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+static void Usage(const char * program) {
+    std::cerr << "usage: " << program << " [--policies NAME] [--shape NAME] [--scales 1,10,100] [--threads N] [--seed N] [--output FILE]\n"
+              << "policies:";
+    for(const std::pair<std::string, DispatchFunction> & set : policySets)
+        std::cerr << ' ' << set.first;
+    std::cerr << '\n';
+    std::exit(1);
+}
+
+static std::string RunChild(DispatchFunction dispatch, const std::string & policies, const bench::Corpus & corpus, std::size_t scale, std::size_t threads) {
+
+    ResetPeakRSS();
+    std::size_t baseline = ProcStatus("VmRSS");
+
+    RetainingListener listener;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    DispatchStats stats = dispatch(corpus.srcml, threads, &listener);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t peak = ProcStatus("VmHWM");
+    malloc_trim(0);
+    std::size_t retained = ProcStatus("VmRSS");
+
+    std::ostringstream row;
+    row << policies << ',' << corpus.shape << ',' << scale << ',' << threads << ',' << corpus.units << ',' << corpus.srcml.size() << ','
+        << std::fixed << std::setprecision(6) << seconds << ',' << stats.eventsDispatched << ','
+        << std::setprecision(0) << stats.eventsDispatched / seconds << ','
+        << baseline << ',' << peak << ',' << (retained > baseline ? retained - baseline : 0) << '\n';
+    return row.str();
+
+}
+
+int main(int argc, char ** argv) {
+
+    std::string policies = "class", shape = "small", output;
+    std::vector<std::size_t> scales = { 1, 10, 100 };
+    std::size_t maxThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    unsigned seed = 1;
+
+    for(int arg = 1; arg < argc; ++arg) {
+        std::string option = argv[arg];
+        if(arg + 1 >= argc) Usage(argv[0]);
+        if(option == "--policies") policies = argv[++arg];
+        else if(option == "--shape") shape = argv[++arg];
+        else if(option == "--threads") maxThreads = std::strtoul(argv[++arg], 0, 10);
+        else if(option == "--seed") seed = std::strtoul(argv[++arg], 0, 10);
+        else if(option == "--output") output = argv[++arg];
+        else if(option == "--scales") {
+            scales.clear();
+            std::istringstream list(argv[++arg]);
+            std::string scale;
+            while(std::getline(list, scale, ','))
+                scales.push_back(std::strtoul(scale.c_str(), 0, 10));
+        }
+        else Usage(argv[0]);
+    }
+
+    DispatchFunction dispatch = nullptr;
+    for(const std::pair<std::string, DispatchFunction> & set : policySets) {
+        if(set.first == policies) dispatch = set.second;
+    }
+    if(!dispatch || !maxThreads || scales.empty() || std::find(scales.begin(), scales.end(), 0) != scales.end()) Usage(argv[0]);
+
+    std::ofstream file;
+    if(!output.empty()) {
+        file.open(output.c_str());
+        if(!file) {
+            std::cerr << "unable to open " << output << '\n';
+            return 1;
+        }
+    }
+    std::ostream & out = output.empty() ? std::cout : file;
+
+    out << "policies,shape,scale,threads,units,corpus_bytes,wall_seconds,events,events_per_sec,baseline_rss_kb,peak_rss_kb,retained_kb\n";
+    out.flush();
+
+    for(std::size_t scale : scales) {
+
+        bench::Corpus corpus = bench::MakeCorpus(shape, scale, seed);
+
+        for(std::size_t threads = 1; threads <= maxThreads; ++threads) {
+
+            int channel[2];
+            if(::pipe(channel) != 0) {
+                std::perror("pipe");
+                return 1;
+            }
+
+            std::cout.flush();
+            std::cerr.flush();
+            pid_t child = fork();
+            if(child < 0) {
+                std::perror("fork");
+                return 1;
+            }
+
+            if(child == 0) {
+                ::close(channel[0]);
+                std::string row = RunChild(dispatch, policies, corpus, scale, threads);
+                ssize_t written = ::write(channel[1], row.data(), row.size());
+                _exit(written == ssize_t(row.size()) ? 0 : 1);
+            }
+
+            ::close(channel[1]);
+            std::string row;
+            char buffer[256];
+            ssize_t count;
+            while((count = ::read(channel[0], buffer, sizeof(buffer))) > 0)
+                row.append(buffer, count);
+            ::close(channel[0]);
+
+            int status = 0;
+            waitpid(child, &status, 0);
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || row.empty()) {
+                std::cerr << "configuration " << policies << " scale " << scale << " threads " << threads << " failed\n";
+                continue;
+            }
+
+            out << row;
+            out.flush();
+
+        }
+
+    }
+
+}
@@ -0,0 +1,65 @@
+/**
+ * @file BenchSingleEventDispatcher.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+    Microbenchmarks for srcSAXSingleEventDispatcher.  Only the most recently
+    added listener receives events, so policies are measured one at a time;
+    the combinations are the nested policies each top-level policy pushes
+    (e.g. ClassPolicy runs DeclTypePolicy and FunctionPolicy).
+*/
+
+#include <BenchCorpus.hpp>
+
+#include <srcSAXSingleEventDispatcher.hpp>
+#include <ClassPolicySingleEvent.hpp>
+#include <FunctionPolicySingleEvent.hpp>
+#include <DeclTypePolicySingleEvent.hpp>
+#include <ParamTypePolicySingleEvent.hpp>
+#include <NamePolicySingleEvent.hpp>
+#include <TypePolicySingleEvent.hpp>
+#include <TemplateArgumentPolicySingleEvent.hpp>
+
+using namespace srcSAXEventDispatch;
+
+template <typename policy>
+void Bench(const std::string & name, const bench::Corpus & corpus, const bench::Options & options) {
+    bench::Report(std::cout, "SingleEvent", name, corpus, bench::Run<srcSAXSingleEventDispatcher<policy>>(corpus, options.repeat));
+}
+
+int main(int argc, char ** argv) {
+
+    bench::Options options(argc, argv);
+
+    bench::ReportHeader(std::cout);
+    for(const std::string & shape : options.shapes) {
+
+        bench::Corpus corpus = bench::MakeCorpus(shape, options.scale, options.seed);
+
+        Bench<NamePolicy>("NamePolicy", corpus, options);
+        Bench<TypePolicy>("TypePolicy", corpus, options);
+        Bench<TemplateArgumentPolicy>("TemplateArgumentPolicy", corpus, options);
+        Bench<DeclTypePolicy>("DeclTypePolicy", corpus, options);
+        Bench<ParamTypePolicy>("ParamTypePolicy", corpus, options);
+        Bench<FunctionPolicy>("FunctionPolicy", corpus, options);
+        Bench<ClassPolicy>("ClassPolicy", corpus, options);
+
+    }
+
+}
@@ -0,0 +1,402 @@
+/**
+ * @file srcMLWriter.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCML_WRITER_HPP
+#define INCLUDED_SRCML_WRITER_HPP
+
+#include <srcsax.h>
+#include <srcSAXTextUtilities.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * srcMLWriter
+     *
+     * Minimal XML writer used to regenerate srcML archives.  Output is
+     * byte-identical to libxml2's xmlTextWriter (no indentation) for the
+     * calls the dispatcher makes:
+     *
+     *  - start tags are closed lazily, and elements without content are
+     *    written as empty elements
+     *  - WriteAttributeNS with a namespace URI declares the prefix on the
+     *    element it is written on
+     *  - content is escaped as xmlTextWriterWriteString does, except that
+     *    '"' is not escaped (srcML convention)
+     *
+     * Output is appended to an in-memory buffer.  When a sink is given
+     * (file path, file descriptor or callback), the buffer is handed to it
+     * on Flush, which the dispatcher calls at each unit end and EndDocument
+     * calls, and whenever the buffer grows past flushSize, so memory stays
+     * bounded by the largest unit.
+     *
+     * A sink that fails throws from Flush.  The destructor flushes what is
+     * left but does not throw: a failure there is kept in Error() and
+     * reported on std::cerr, as the output is lost.  Flush before
+     * destroying a writer to handle the error instead.
+     */
+    class srcMLWriter {
+
+    public:
+
+        typedef std::function<void(const char * data, std::size_t size)> Sink;
+
+        /** Keep the whole document in memory. */
+        srcMLWriter()
+            : ownedFd(-1), flushSize(0), fragment(false), depth(0), tagOpen(false), numDecls(0) {}
+
+        /** Stream to a callback. */
+        srcMLWriter(Sink sink, std::size_t flushSize = 1 << 16)
+            : sink(sink), ownedFd(-1), flushSize(flushSize), fragment(false), depth(0), tagOpen(false), numDecls(0) {}
+
+        /** Stream to an open file descriptor.  The descriptor is not closed. */
+        srcMLWriter(int fd, std::size_t flushSize = 1 << 16)
+            : sink(DescriptorSink(fd)), ownedFd(-1), flushSize(flushSize), fragment(false), depth(0), tagOpen(false), numDecls(0) {}
+
+        /** Stream to a file, created or truncated. */
+        srcMLWriter(const std::string & path, std::size_t flushSize = 1 << 16)
+            : ownedFd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), flushSize(flushSize), fragment(false), depth(0), tagOpen(false), numDecls(0) {
+
+            if(ownedFd < 0)
+                throw std::runtime_error("srcMLWriter: unable to open " + path + ": " + std::strerror(errno));
+            sink = DescriptorSink(ownedFd);
+
+        }
+
+        ~srcMLWriter() {
+
+            try {
+                Flush();
+            } catch(const std::exception & exception) {
+                error = exception.what();
+            } catch(...) {
+                error = "srcMLWriter: flush failed";
+            }
+            if(!error.empty()) std::cerr << error << '\n';
+
+            if(ownedFd >= 0) ::close(ownedFd);
+
+        }
+
+        srcMLWriter(const srcMLWriter &) = delete;
+        srcMLWriter & operator=(const srcMLWriter &) = delete;
+
+        /**
+         * SetFragment
+         *
+         * In fragment mode only the content of the root element is written:
+         * no XML declaration, no root start or end tag and no trailing
+         * newline.  Used to render units separately and stitch them together.
+         */
+        void SetFragment(bool isFragment) { fragment = isFragment; }
+
+        void StartDocument() {
+            if(fragment) return;
+            buffer.append("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n");
+        }
+
+        void EndDocument() {
+            while(depth)
+                EndElement();
+            if(!fragment) buffer.push_back('\n');
+            Flush();
+        }
+
+        void StartElement(const char * prefix, const char * localname) {
+
+            CloseStartTag();
+
+            if(depth == elements.size())
+                elements.push_back(std::string());
+
+            std::string & name = elements[depth++];
+            name.clear();
+            if(prefix) {
+                name.append(prefix);
+                name.push_back(':');
+            }
+            name.append(localname);
+
+            if(fragment && depth == 1) return;
+
+            buffer.push_back('<');
+            buffer.append(name);
+            tagOpen = true;
+
+        }
+
+        void EndElement() {
+
+            if(!depth) return;
+
+            --depth;
+            if(fragment && !depth) return;
+
+            if(tagOpen) {
+                WriteDeclarations();
+                buffer.append("/>");
+                tagOpen = false;
+            } else {
+                buffer.append("</");
+                buffer.append(elements[depth]);
+                buffer.push_back('>');
+            }
+
+            if(sink && buffer.size() >= flushSize)
+                Flush();
+
+        }
+
+        void WriteAttribute(const char * name, const char * value) {
+
+            buffer.push_back(' ');
+            buffer.append(name);
+            buffer.append("=\"");
+            WriteEscaped(value, std::strlen(value), true);
+            buffer.push_back('"');
+
+        }
+
+        /**
+         * WriteAttributeNS
+         *
+         * Write prefix:localname="value".  If uri is given, an xmlns
+         * declaration for the prefix is added to the element unless the
+         * element already declares it.
+         */
+        void WriteAttributeNS(const char * prefix, const char * localname, const char * uri, const char * value) {
+
+            buffer.push_back(' ');
+            if(prefix) {
+                buffer.append(prefix);
+                buffer.push_back(':');
+            }
+            buffer.append(localname);
+            buffer.append("=\"");
+            WriteEscaped(value, std::strlen(value), true);
+            buffer.push_back('"');
+
+            if(!uri) return;
+
+            for(std::size_t pos = 0; pos < numDecls; ++pos) {
+                if(SamePrefix(decls[pos].first, prefix))
+                    return;
+            }
+
+            if(numDecls == decls.size())
+                decls.push_back(std::pair<std::string, std::string>());
+
+            std::pair<std::string, std::string> & decl = decls[numDecls++];
+            decl.first.assign("xmlns");
+            if(prefix) {
+                decl.first.push_back(':');
+                decl.first.append(prefix);
+            }
+            decl.second.assign(uri);
+
+        }
+
+        /**
+         * WriteString
+         *
+         * Write element content, escaping <, >, & and carriage return.
+         */
+        void WriteString(const char * text, std::size_t len) {
+            CloseStartTag();
+            WriteEscaped(text, len, false);
+        }
+
+        void WriteString(const std::string & text) {
+            WriteString(text.data(), text.size());
+        }
+
+        void WriteRaw(const char * text, std::size_t len) {
+            CloseStartTag();
+            buffer.append(text, len);
+        }
+
+        /**
+         * WriteStartTag
+         *
+         * Write a start tag from srcSAX start element arguments.  Namespace
+         * declarations are written, but only the line and filename attributes
+         * are kept.
+         */
+        void WriteStartTag(const char * localname, const char * prefix, const char * URI,
+                           int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                           const struct srcsax_attribute * attributes) {
+
+            StartElement(prefix, localname);
+            if(fragment && depth == 1) return;
+
+            for(int pos = 0; pos < num_namespaces; ++pos) {
+                buffer.append(" xmlns");
+                if(namespaces[pos].prefix) {
+                    buffer.push_back(':');
+                    buffer.append(namespaces[pos].prefix);
+                }
+                buffer.append("=\"");
+                WriteEscaped(namespaces[pos].uri, std::strlen(namespaces[pos].uri), true);
+                buffer.push_back('"');
+            }
+
+            for(int pos = 0; pos < num_attributes; ++pos) {
+                if(std::strcmp(attributes[pos].localname, "line") == 0 || std::strcmp(attributes[pos].localname, "filename") == 0) {
+                    WriteAttributeNS(attributes[pos].prefix, attributes[pos].localname, attributes[pos].uri, attributes[pos].value);
+                }
+            }
+
+        }
+
+        /**
+         * Flush
+         *
+         * Hand buffered output to the sink, if there is one.
+         */
+        void Flush() {
+
+            if(!sink || buffer.empty()) return;
+
+            sink(buffer.data(), buffer.size());
+            buffer.clear();
+
+        }
+
+        bool IsStreaming() const { return static_cast<bool>(sink); }
+
+        /** The error of a failed flush in the destructor, empty if none. */
+        const std::string & Error() const { return error; }
+
+        /** Output not yet flushed; the whole document if there is no sink. */
+        const std::string & Buffer() const { return buffer; }
+
+        /** Move the unflushed output into text, leaving the buffer empty. */
+        void TakeBuffer(std::string & text) {
+            text.swap(buffer);
+            buffer.clear();
+        }
+
+        /** Discard all output and open elements, keeping allocated capacity. */
+        void Clear() {
+            buffer.clear();
+            depth = 0;
+            tagOpen = false;
+            numDecls = 0;
+        }
+
+    private:
+
+        static Sink DescriptorSink(int fd) {
+
+            return [fd](const char * data, std::size_t size) {
+
+                std::size_t written = 0;
+                while(written < size) {
+                    ssize_t count = ::write(fd, data + written, size - written);
+                    if(count < 0) {
+                        if(errno == EINTR) continue;
+                        throw std::runtime_error(std::string("srcMLWriter: write failed: ") + std::strerror(errno));
+                    }
+                    written += count;
+                }
+
+            };
+
+        }
+
+        void CloseStartTag() {
+            if(!tagOpen) return;
+            WriteDeclarations();
+            buffer.push_back('>');
+            tagOpen = false;
+        }
+
+        /* xmlTextWriter keeps declarations on a stack, so they come out most recent first */
+        void WriteDeclarations() {
+            while(numDecls) {
+                --numDecls;
+                buffer.push_back(' ');
+                buffer.append(decls[numDecls].first);
+                buffer.append("=\"");
+                WriteEscaped(decls[numDecls].second.data(), decls[numDecls].second.size(), true);
+                buffer.push_back('"');
+            }
+        }
+
+        static bool SamePrefix(const std::string & declaration, const char * prefix) {
+            if(!prefix) return declaration.size() == 5;
+            return declaration.size() >= 6 && declaration.compare(6, std::string::npos, prefix) == 0;
+        }
+
+        void WriteEscaped(const char * text, std::size_t len, bool attribute) {
+
+            while(len) {
+
+                std::size_t run = attribute ? FindAttributeEscape(text, len) : FindContentEscape(text, len);
+                buffer.append(text, run);
+                if(run == len) break;
+
+                switch(text[run]) {
+                    case '<':  buffer.append("&lt;");   break;
+                    case '>':  buffer.append("&gt;");   break;
+                    case '&':  buffer.append("&amp;");  break;
+                    case '"':  buffer.append("&quot;"); break;
+                    case '\n': buffer.append("&#10;");  break;
+                    case '\r': buffer.append("&#13;");  break;
+                    case '\t': buffer.append("&#9;");   break;
+                }
+
+                text += run + 1;
+                len -= run + 1;
+
+            }
+
+        }
+
+        Sink sink;
+        int ownedFd;
+        std::size_t flushSize;
+
+        std::string buffer;
+
+        bool fragment;
+
+        std::vector<std::string> elements;
+        std::size_t depth;
+        bool tagOpen;
+
+        std::vector<std::pair<std::string, std::string>> decls;
+        std::size_t numDecls;
+
+        std::string error;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file srcSAXAllocationHooks.cpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+    Counting replacements of the global operator new and delete, charging
+    each allocation to the thread's current policy (see AllocationScope).
+    Only compiled with SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS.  The
+    dispatchers reference AllocationTracker::HooksInstalled in that
+    configuration so this object is always linked from the static library.
+*/
+
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+
+#include <srcSAXAllocationTracker.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+    void * Allocate(std::size_t size) {
+
+        void * memory = std::malloc(size ? size : 1);
+        if(!memory) return nullptr;
+
+        srcSAXEventDispatch::AllocationCounters * counters = srcSAXEventDispatch::CurrentAllocationCounters();
+        if(counters) {
+            ++counters->allocations;
+            counters->bytes += size;
+        }
+
+        return memory;
+
+    }
+
+    void * AllocateOrThrow(std::size_t size) {
+
+        while(true) {
+
+            void * memory = Allocate(size);
+            if(memory) return memory;
+
+            std::new_handler handler = std::set_new_handler(nullptr);
+            std::set_new_handler(handler);
+            if(!handler) throw std::bad_alloc();
+            handler();
+
+        }
+
+    }
+
+}
+
+bool srcSAXEventDispatch::AllocationTracker::HooksInstalled() {
+    return true;
+}
+
+void * operator new(std::size_t size) {
+    return AllocateOrThrow(size);
+}
+
+void * operator new[](std::size_t size) {
+    return AllocateOrThrow(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void * memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void * memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void * memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+#endif
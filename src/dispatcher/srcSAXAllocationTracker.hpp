@@ -0,0 +1,274 @@
+/**
+ * @file srcSAXAllocationTracker.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_ALLOCATION_TRACKER_HPP
+#define INCLUDED_SRCSAX_ALLOCATION_TRACKER_HPP
+
+#include <srcSAXEventDispatchUtilities.hpp>
+#include <srcSAXDispatchProfile.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    struct AllocationCounters {
+        AllocationCounters() : allocations(0), bytes(0) {}
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+    };
+
+    /**
+     * CurrentAllocationCounters
+     *
+     * The thread's "current policy" marker: counters the allocation hooks
+     * charge every operator new to, or nullptr when no policy is running.
+     */
+    inline AllocationCounters *& CurrentAllocationCounters() {
+        static thread_local AllocationCounters * current = nullptr;
+        return current;
+    }
+
+    /**
+     * AllocationTracker
+     *
+     * Attributes heap allocations made while listeners handle events to
+     * the listener's type and to the unit being parsed.  The dispatchers
+     * keep one when built with SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS (CMake
+     * option of the same name), which also installs counting replacements
+     * of the global operator new and delete (srcSAXAllocationHooks.cpp).
+     *
+     * Allocations are charged to the innermost running listener only, so a
+     * nested policy driven directly by its parent is not counted twice.
+     *
+     * A policy type can be marked allocation-free.  In strict mode, an
+     * allocation-free policy that allocates while handling an event is a
+     * violation: the violation handler is called, which by default prints
+     * the policy and event and aborts.
+     */
+    class AllocationTracker {
+
+    public:
+
+        struct PolicyAllocations {
+            PolicyAllocations(const std::string & name) : name(name), events(0), allocationFree(false), violations(0) {}
+            std::string name;
+            std::uint64_t events;
+            AllocationCounters counters;
+            bool allocationFree;
+            std::uint64_t violations;
+        };
+
+        struct UnitAllocations {
+            std::string filename;
+            AllocationCounters counters;
+        };
+
+        typedef std::function<void(const PolicyAllocations & policy, ParserState pstate, ElementState estate, const AllocationCounters & counters)> ViolationHandler;
+
+        AllocationTracker() : strict(false), inUnit(false) {}
+
+        /** True when the counting operator new is linked in. */
+        static bool HooksInstalled();
+
+        template <typename Policy>
+        void MarkAllocationFree() {
+            MarkAllocationFree(typeid(Policy));
+        }
+
+        void MarkAllocationFree(const std::type_info & policy) {
+            allocationFree.insert(std::type_index(policy));
+            std::unordered_map<std::type_index, std::size_t>::const_iterator index = policyIndex.find(std::type_index(policy));
+            if(index != policyIndex.end()) policies[index->second].allocationFree = true;
+        }
+
+        void SetStrict(bool isStrict) { strict = isStrict; }
+        void SetViolationHandler(const ViolationHandler & handler) { violationHandler = handler; }
+
+        /* called by the dispatchers */
+
+        void UnitStart(const std::string & filename) {
+            unit = UnitAllocations();
+            unit.filename = filename;
+            inUnit = true;
+        }
+
+        void UnitEnd() {
+            if(!inUnit) return;
+            inUnit = false;
+            units.push_back(unit);
+        }
+
+        /** Index of the listener's entry; call outside any scope, it may allocate. */
+        std::size_t PolicyIndex(const EventListener * listener) {
+
+            std::type_index type(typeid(*listener));
+            std::unordered_map<std::type_index, std::size_t>::const_iterator index = policyIndex.find(type);
+            if(index != policyIndex.end()) return index->second;
+
+            policies.push_back(PolicyAllocations(ListenerTypeName(typeid(*listener))));
+            policies.back().allocationFree = allocationFree.count(type) != 0;
+            policyIndex.insert(std::make_pair(type, policies.size() - 1));
+            return policies.size() - 1;
+
+        }
+
+        /** Charge one handled event's allocations. */
+        void Record(std::size_t policy, ParserState pstate, ElementState estate, const AllocationCounters & counters) {
+
+            PolicyAllocations & entry = policies[policy];
+            ++entry.events;
+            entry.counters.allocations += counters.allocations;
+            entry.counters.bytes += counters.bytes;
+
+            if(inUnit) {
+                unit.counters.allocations += counters.allocations;
+                unit.counters.bytes += counters.bytes;
+            }
+
+            if(strict && entry.allocationFree && counters.allocations) {
+                ++entry.violations;
+                if(violationHandler) {
+                    violationHandler(entry, pstate, estate, counters);
+                } else {
+                    std::cerr << "allocation-free policy " << entry.name << " made " << counters.allocations
+                              << " allocation(s) (" << counters.bytes << " bytes) handling "
+                              << ParserStateName(pstate) << (estate == ElementState::open ? " open" : " close") << '\n';
+                    std::abort();
+                }
+            }
+
+        }
+
+        /** Forget counts; marks, strict mode and the handler are kept. */
+        void Clear() {
+            policies.clear();
+            policyIndex.clear();
+            units.clear();
+            inUnit = false;
+        }
+
+        const std::vector<PolicyAllocations> & Policies() const { return policies; }
+        const std::vector<UnitAllocations> & Units() const { return units; }
+
+        /**
+         * WriteReport
+         * @param out stream for the report
+         * @param maxUnits number of units to list, largest first
+         */
+        void WriteReport(std::ostream & out, std::size_t maxUnits = 20) const {
+
+            out << std::left << std::setw(40) << "policy" << std::right
+                << std::setw(12) << "events" << std::setw(14) << "allocations" << std::setw(14) << "bytes"
+                << std::setw(12) << "allocs/ev" << std::setw(12) << "bytes/ev" << '\n';
+            for(const PolicyAllocations & policy : policies) {
+                double events = policy.events ? double(policy.events) : 1.0;
+                out << std::left << std::setw(40) << (policy.allocationFree ? policy.name + " *" : policy.name) << std::right
+                    << std::setw(12) << policy.events << std::setw(14) << policy.counters.allocations << std::setw(14) << policy.counters.bytes
+                    << std::fixed << std::setprecision(3)
+                    << std::setw(12) << policy.counters.allocations / events << std::setw(12) << policy.counters.bytes / events << '\n';
+                out.unsetf(std::ios::floatfield);
+            }
+
+            std::vector<const UnitAllocations *> sorted;
+            for(const UnitAllocations & unit : units)
+                sorted.push_back(&unit);
+            std::sort(sorted.begin(), sorted.end(), [](const UnitAllocations * lhs, const UnitAllocations * rhs) {
+                return lhs->counters.bytes > rhs->counters.bytes;
+            });
+            if(sorted.size() > maxUnits) sorted.resize(maxUnits);
+
+            out << '\n' << std::left << std::setw(52) << "unit" << std::right
+                << std::setw(14) << "allocations" << std::setw(14) << "bytes" << '\n';
+            for(const UnitAllocations * unit : sorted) {
+                out << std::left << std::setw(52) << unit->filename << std::right
+                    << std::setw(14) << unit->counters.allocations << std::setw(14) << unit->counters.bytes << '\n';
+            }
+            if(units.size() > maxUnits) out << "(" << units.size() - maxUnits << " more units)\n";
+
+            bool anyFree = false;
+            for(const PolicyAllocations & policy : policies)
+                anyFree = anyFree || policy.allocationFree;
+            if(anyFree) out << "\n* marked allocation-free\n";
+
+        }
+
+    private:
+
+        bool strict;
+        ViolationHandler violationHandler;
+        std::unordered_set<std::type_index> allocationFree;
+
+        std::vector<PolicyAllocations> policies;
+        std::unordered_map<std::type_index, std::size_t> policyIndex;
+
+        std::vector<UnitAllocations> units;
+        UnitAllocations unit;
+        bool inUnit;
+
+    };
+
+    /**
+     * AllocationScope
+     *
+     * Marks a listener as the thread's current policy for the lifetime of
+     * the scope, then charges what it allocated to the tracker.
+     */
+    class AllocationScope {
+
+    public:
+
+        AllocationScope(AllocationTracker & tracker, const EventListener * listener, ParserState pstate, ElementState estate)
+            : tracker(tracker), policy(tracker.PolicyIndex(listener)), pstate(pstate), estate(estate),
+              previous(CurrentAllocationCounters()) {
+            CurrentAllocationCounters() = &counters;
+        }
+
+        ~AllocationScope() {
+            CurrentAllocationCounters() = previous;
+            tracker.Record(policy, pstate, estate, counters);
+        }
+
+        AllocationScope(const AllocationScope &) = delete;
+        AllocationScope & operator=(const AllocationScope &) = delete;
+
+    private:
+
+        AllocationTracker & tracker;
+        std::size_t policy;
+        ParserState pstate;
+        ElementState estate;
+        AllocationCounters counters;
+        AllocationCounters * previous;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file srcSAXBoundedMap.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_BOUNDED_MAP_HPP
+#define INCLUDED_SRCSAX_BOUNDED_MAP_HPP
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * BoundedMap
+     *
+     * A map holding at most capacity entries (0 for no bound), evicting the
+     * least recently used entry when full.  find and insert count as uses.
+     * For state policies carry across units when results are flushed per
+     * unit, so it stays proportional to the bound rather than the archive.
+     * The interface is the subset of std::map the policies use.
+     */
+    template<typename Key, typename Value>
+    class BoundedMap {
+
+    public:
+
+        typedef std::pair<Key, Value> value_type;
+        typedef typename std::list<value_type>::iterator iterator;
+        typedef typename std::list<value_type>::const_iterator const_iterator;
+
+        BoundedMap(std::size_t capacity = 0) : capacity(capacity), evictions(0) {}
+
+        /** Change the bound, evicting down to it; 0 for no bound. */
+        void SetCapacity(std::size_t newCapacity) {
+            capacity = newCapacity;
+            Trim();
+        }
+        std::size_t GetCapacity() const { return capacity; }
+        /** Entries evicted since construction or clear. */
+        std::size_t Evictions() const { return evictions; }
+
+        iterator find(const Key & key) {
+            typename std::unordered_map<Key, iterator>::iterator entry = index.find(key);
+            if(entry == index.end()) return entries.end();
+            entries.splice(entries.begin(), entries, entry->second);
+            return entry->second;
+        }
+
+        /** Insert if absent, as std::map::insert; the entry becomes the most recently used either way. */
+        std::pair<iterator, bool> insert(const value_type & value) {
+            iterator existing = find(value.first);
+            if(existing != entries.end()) return std::make_pair(existing, false);
+            entries.push_front(value);
+            index[value.first] = entries.begin();
+            Trim();
+            return std::make_pair(entries.begin(), true);
+        }
+
+        Value & operator[](const Key & key) {
+            return insert(value_type(key, Value())).first->second;
+        }
+
+        iterator begin() { return entries.begin(); }
+        iterator end() { return entries.end(); }
+        const_iterator begin() const { return entries.begin(); }
+        const_iterator end() const { return entries.end(); }
+        std::size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+
+        void clear() {
+            entries.clear();
+            index.clear();
+            evictions = 0;
+        }
+
+    private:
+
+        void Trim() {
+            if(!capacity) return;
+            while(entries.size() > capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+                ++evictions;
+            }
+        }
+
+        /* most recently used first */
+        std::list<value_type> entries;
+        std::unordered_map<Key, iterator> index;
+        std::size_t capacity;
+        std::size_t evictions;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+/**
+ * @file srcSAXDispatchProfile.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_DISPATCH_PROFILE_HPP
+#define INCLUDED_SRCSAX_DISPATCH_PROFILE_HPP
+
+#include <srcSAXEventDispatchUtilities.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+namespace srcSAXEventDispatch {
+
+    /** Name of a ParserState, as spelled in the enum. */
+    inline const char * ParserStateName(ParserState state) {
+
+        static const char * names[] = {
+            "decl", "expr", "parameter", "declstmt", "exprstmt", "parameterlist",
+            "argumentlist", "argumentlisttemplate", "call", "templates", "ctrlflow", "endflow", "genericargumentlist",
+            "name", "function", "functiondecl", "constructor", "constructordecl", "destructordecl", "destructor",
+            "argument", "index", "block", "type", "typeprev", "init", "op", "literal", "modifier", "memberlist", "classn", "structn",
+            "super_list", "super", "publicaccess", "privateaccess", "protectedaccess", "preproc", "whilestmt", "forstmt",
+            "ifstmt", "nonterminal", "macro", "classblock", "functionblock", "ifblock", "whileblock", "forblock", "specifier", "typedefexpr",
+            "userdefined", "snoun", "propersnoun", "spronoun", "sadjective", "sverb", "stereotype", "archive", "unit",
+            "xmlattribute", "tokenstring", "empty"
+        };
+        static_assert(sizeof(names) / sizeof(names[0]) == MAXENUMVALUE + 1, "ParserStateName out of sync with ParserState");
+
+        return state <= MAXENUMVALUE ? names[state] : "userdefined";
+
+    }
+
+    /** Readable name of a listener's dynamic type. */
+    inline std::string ListenerTypeName(const std::type_info & type) {
+
+#ifdef __GNUG__
+        int status = 0;
+        char * demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+        if(status == 0 && demangled) {
+            std::string name(demangled);
+            std::free(demangled);
+            return name;
+        }
+#endif
+        return type.name();
+
+    }
+
+    /**
+     * DispatchProfile
+     *
+     * Where time goes inside DispatchEvent.  Collected by the dispatchers
+     * only when built with SRCSAX_EVENT_DISPATCH_PROFILE (CMake option of
+     * the same name); otherwise none of this is compiled into them.
+     *
+     *  - events counts every dispatched event per ParserState and
+     *    ElementState, with the total time spent in listeners for it
+     *  - listeners aggregates per listener type: HandleEvent calls, how
+     *    many found a real handler, a nop handler (NopOpenEvents,
+     *    NopCloseEvents) or no handler at all, how many were suppressed
+     *    because the listener had already seen the event, and the time
+     *    spent in HandleEvent
+     *
+     * Handler time is sampled with steady_clock around each HandleEvent
+     * call, so it includes the handlers' own overhead of two clock reads.
+     */
+    class DispatchProfile {
+
+    public:
+
+        typedef std::chrono::steady_clock Clock;
+
+        struct StateProfile {
+            StateProfile() : count(0), nanoseconds(0) {}
+            std::uint64_t count;
+            std::uint64_t nanoseconds;
+        };
+
+        struct ListenerProfile {
+            ListenerProfile(const std::string & name) : name(name), calls(0), handled(0), nop(0), missing(0), suppressed(0), nanoseconds(0) {}
+            std::string name;
+            std::uint64_t calls;
+            std::uint64_t handled;
+            std::uint64_t nop;
+            std::uint64_t missing;
+            std::uint64_t suppressed;
+            std::uint64_t nanoseconds;
+        };
+
+        /* an in-flight HandleEvent call */
+        struct Sample {
+            std::size_t listener;
+            ParserState pstate;
+            ElementState estate;
+            Clock::time_point start;
+        };
+
+        DispatchProfile() : events(MAXENUMVALUE + 1) {}
+
+        /** Label the rows of a user-defined event (AddEvent) with its element name. */
+        void NameEvent(ParserState pstate, const std::string & name) {
+            eventNames[pstate] = name;
+        }
+
+        /** Count one dispatched event. */
+        void RecordEvent(ParserState pstate, ElementState estate) {
+            if(pstate >= events.size()) events.resize(pstate + 1);
+            ++events[pstate][estate].count;
+        }
+
+        /**
+         * Begin
+         *
+         * Classify what the listener will do with the event and start timing
+         * it.  Call immediately before HandleEvent, with the context depth,
+         * and pass the result to End.
+         */
+        Sample Begin(const EventListener * listener, ParserState pstate, ElementState estate, std::size_t depth) {
+
+            Sample sample;
+            sample.listener = ListenerIndex(listener);
+            sample.pstate = pstate;
+            sample.estate = estate;
+
+            ListenerProfile & profile = listeners[sample.listener];
+            ++profile.calls;
+
+            if(listener->IsDispatched()) {
+                ++profile.suppressed;
+            } else {
+                const EventListener::EventHandler * handler = listener->FindHandler(pstate, estate, depth);
+                if(!handler) ++profile.missing;
+                else if(handler->target_type() == typeid(NopEvent)) ++profile.nop;
+                else ++profile.handled;
+            }
+
+            sample.start = Clock::now();
+            return sample;
+
+        }
+
+        /** Stop timing a HandleEvent call started with Begin. */
+        void End(const Sample & sample) {
+
+            std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sample.start).count();
+            listeners[sample.listener].nanoseconds += nanoseconds;
+            events[sample.pstate][sample.estate].nanoseconds += nanoseconds;
+
+        }
+
+        void Clear() {
+            events.assign(MAXENUMVALUE + 1, std::array<StateProfile, 2>());
+            listeners.clear();
+            listenerIndex.clear();
+        }
+
+        const StateProfile & Event(ParserState pstate, ElementState estate) const {
+            static const StateProfile none;
+            return pstate < events.size() ? events[pstate][estate] : none;
+        }
+
+        /** ParserStateName, or the element name of a user-defined event. */
+        std::string StateName(ParserState pstate) const {
+            std::unordered_map<std::size_t, std::string>::const_iterator name = eventNames.find(pstate);
+            return name != eventNames.end() ? name->second : ParserStateName(pstate);
+        }
+        const std::vector<ListenerProfile> & Listeners() const { return listeners; }
+
+        std::uint64_t TotalEvents() const {
+            std::uint64_t total = 0;
+            for(const std::array<StateProfile, 2> & state : events)
+                total += state[ElementState::open].count + state[ElementState::close].count;
+            return total;
+        }
+
+        std::uint64_t TotalNanoseconds() const {
+            std::uint64_t total = 0;
+            for(const ListenerProfile & listener : listeners)
+                total += listener.nanoseconds;
+            return total;
+        }
+
+        /** Human-readable report: states, then listeners, by decreasing time. */
+        void WriteTable(std::ostream & out) const {
+
+            std::vector<std::size_t> order;
+            for(std::size_t state = 0; state < events.size(); ++state) {
+                if(events[state][ElementState::open].count || events[state][ElementState::close].count)
+                    order.push_back(state);
+            }
+            std::sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) {
+                return events[lhs][0].nanoseconds + events[lhs][1].nanoseconds > events[rhs][0].nanoseconds + events[rhs][1].nanoseconds;
+            });
+
+            out << std::left << std::setw(22) << "state" << std::right
+                << std::setw(12) << "open" << std::setw(12) << "close"
+                << std::setw(14) << "open ns" << std::setw(14) << "close ns" << '\n';
+            for(std::size_t state : order) {
+                out << std::left << std::setw(22) << StateName(ParserState(state)) << std::right
+                    << std::setw(12) << events[state][ElementState::open].count
+                    << std::setw(12) << events[state][ElementState::close].count
+                    << std::setw(14) << events[state][ElementState::open].nanoseconds
+                    << std::setw(14) << events[state][ElementState::close].nanoseconds << '\n';
+            }
+
+            std::vector<const ListenerProfile *> sorted;
+            for(const ListenerProfile & listener : listeners)
+                sorted.push_back(&listener);
+            std::sort(sorted.begin(), sorted.end(), [](const ListenerProfile * lhs, const ListenerProfile * rhs) {
+                return lhs->nanoseconds > rhs->nanoseconds;
+            });
+
+            out << '\n' << std::left << std::setw(40) << "listener" << std::right
+                << std::setw(12) << "calls" << std::setw(12) << "handled" << std::setw(12) << "nop"
+                << std::setw(12) << "missing" << std::setw(12) << "suppressed" << std::setw(14) << "ns" << '\n';
+            for(const ListenerProfile * listener : sorted) {
+                out << std::left << std::setw(40) << listener->name << std::right
+                    << std::setw(12) << listener->calls << std::setw(12) << listener->handled << std::setw(12) << listener->nop
+                    << std::setw(12) << listener->missing << std::setw(12) << listener->suppressed << std::setw(14) << listener->nanoseconds << '\n';
+            }
+
+            out << "\nevents: " << TotalEvents() << "  listener ns: " << TotalNanoseconds() << '\n';
+
+        }
+
+        /** Machine-readable report; states without events are omitted. */
+        void WriteJSON(std::ostream & out) const {
+
+            out << "{\"events\":[";
+            bool first = true;
+            for(std::size_t state = 0; state < events.size(); ++state) {
+                const StateProfile & open = events[state][ElementState::open];
+                const StateProfile & close = events[state][ElementState::close];
+                if(!open.count && !close.count) continue;
+                if(!first) out << ',';
+                first = false;
+                out << "{\"state\":\"" << StateName(ParserState(state)) << "\""
+                    << ",\"open\":" << open.count << ",\"close\":" << close.count
+                    << ",\"open_ns\":" << open.nanoseconds << ",\"close_ns\":" << close.nanoseconds << '}';
+            }
+
+            out << "],\"listeners\":[";
+            for(std::size_t pos = 0; pos < listeners.size(); ++pos) {
+                const ListenerProfile & listener = listeners[pos];
+                if(pos) out << ',';
+                out << "{\"name\":\"" << listener.name << "\""
+                    << ",\"calls\":" << listener.calls << ",\"handled\":" << listener.handled
+                    << ",\"nop\":" << listener.nop << ",\"missing\":" << listener.missing
+                    << ",\"suppressed\":" << listener.suppressed << ",\"ns\":" << listener.nanoseconds << '}';
+            }
+
+            out << "],\"total_events\":" << TotalEvents() << ",\"total_ns\":" << TotalNanoseconds() << "}\n";
+
+        }
+
+    private:
+
+        /* listeners are aggregated by dynamic type; nested policies come and go */
+        std::size_t ListenerIndex(const EventListener * listener) {
+
+            std::type_index type(typeid(*listener));
+            std::unordered_map<std::type_index, std::size_t>::const_iterator index = listenerIndex.find(type);
+            if(index != listenerIndex.end()) return index->second;
+
+            listeners.push_back(ListenerProfile(ListenerTypeName(typeid(*listener))));
+            listenerIndex.insert(std::make_pair(type, listeners.size() - 1));
+            return listeners.size() - 1;
+
+        }
+
+        /* indexed by ParserState; grows for user-defined events */
+        std::vector<std::array<StateProfile, 2>> events;
+        std::unordered_map<std::size_t, std::string> eventNames;
+        std::vector<ListenerProfile> listeners;
+        std::unordered_map<std::type_index, std::size_t> listenerIndex;
+
+    };
+
+}
+
+#endif
@@ -26,15 +26,31 @@
 #include <initializer_list>
 #include <algorithm>
 #include <iostream>
-#include <libxml/xmlwriter.h>
+#include <atomic>
+#include <typeinfo>
 #include <srcSAXHandler.hpp>
+#include <srcMLWriter.hpp>
+#include <libxml/tree.h>
 #ifndef INCLUDED_SRCSAX_EVENT_DISPATCH_UTILITIES_HPP
 #define INCLUDED_SRCSAX_EVENT_DISPATCH_UTILITIES_HPP
 
+#if defined(__GNUC__) || defined(__clang__)
+#define SRCSAX_DEPRECATED(message) __attribute__((deprecated(message)))
+#elif defined(_MSC_VER)
+#define SRCSAX_DEPRECATED(message) __declspec(deprecated(message))
+#else
+#define SRCSAX_DEPRECATED(message)
+#endif
+
 namespace srcSAXEventDispatch{
     class EventDispatcher;            
     enum ElementState {open, close};
-    enum ParserState {decl, expr, parameter, declstmt, exprstmt, parameterlist, 
+    /*
+        ParserState has a fixed underlying type so event ids beyond the
+        listed states are valid values: AddEvent allocates them densely
+        from FIRSTUSEREVENT on, one per user-defined element.
+    */
+    enum ParserState : unsigned short {decl, expr, parameter, declstmt, exprstmt, parameterlist, 
         argumentlist, argumentlisttemplate, call, templates, ctrlflow, endflow, genericargumentlist,
         name, function, functiondecl, constructor, constructordecl, destructordecl, destructor,
         argument, index, block, type, typeprev, init, op, literal, modifier, memberlist, classn, structn,
@@ -43,7 +59,77 @@ namespace srcSAXEventDispatch{
         userdefined, snoun, propersnoun, spronoun, sadjective, sverb, stereotype, archive, unit,
 
         // do not put anything after these
-        xmlattribute, tokenstring, empty, MAXENUMVALUE = empty};
+        xmlattribute, tokenstring, empty, MAXENUMVALUE = empty, FIRSTUSEREVENT};
+
+    /**
+     * ElementId
+     *
+     * Interned srcML element names, kept by the context in a stack parallel
+     * to elementStack so policies can test their surroundings with integer
+     * compares.  Keywords take the ParserState spelling (classn, op, ...).
+     * Names not listed get ids from MAXELEMENTID on, assigned per
+     * dispatcher on first sight.
+     */
+    enum class ElementId : unsigned short {
+        none, unit, decl, decl_stmt, expr, expr_stmt, parameter, parameter_list, argument, argument_list,
+        call, templates, name, function, function_decl, constructor, constructor_decl, destructor, destructor_decl,
+        block, type, init, op, literal, modifier, member_list, classn, class_decl, structn, struct_decl,
+        unionn, union_decl, enumn, super_list, super, publicaccess, privateaccess, protectedaccess,
+        ifstmt, elsestmt, whilestmt, forstmt, dostmt, switchstmt, returnstmt, condition, control, index,
+        specifier, typedefn, macro, comment, namespacen, lambda,
+        noun, propernoun, pronoun, adjective, verb, stereotype, position,
+
+        // do not put anything after this
+        MAXELEMENTID
+    };
+
+    /* element names of the listed ElementIds, indexed by id */
+    inline const std::vector<std::string> & KnownElementNames() {
+        static const std::vector<std::string> names = {
+            "", "unit", "decl", "decl_stmt", "expr", "expr_stmt", "parameter", "parameter_list", "argument", "argument_list",
+            "call", "template", "name", "function", "function_decl", "constructor", "constructor_decl", "destructor", "destructor_decl",
+            "block", "type", "init", "operator", "literal", "modifier", "member_list", "class", "class_decl", "struct", "struct_decl",
+            "union", "union_decl", "enum", "super_list", "super", "public", "private", "protected",
+            "if", "else", "while", "for", "do", "switch", "return", "condition", "control", "index",
+            "specifier", "typedef", "macro", "comment", "namespace", "lambda",
+            "noun", "propernoun", "pronoun", "adjective", "verb", "stereotype", "pos:position",
+        };
+        return names;
+    }
+
+    /**
+     * ElementTable
+     *
+     * Maps qualified element names (prefix:localname) to ElementIds and
+     * back.  Listed names have fixed ids; others are added on first lookup.
+     */
+    class ElementTable {
+
+        public:
+
+            ElementTable() : names(KnownElementNames()) {
+                for(std::size_t id = 1; id < names.size(); ++id)
+                    ids[names[id]] = ElementId(id);
+            }
+
+            ElementId Intern(const std::string & qualifiedName) {
+                std::unordered_map<std::string, ElementId>::const_iterator id = ids.find(qualifiedName);
+                if(id != ids.end()) return id->second;
+                names.push_back(qualifiedName);
+                return ids[qualifiedName] = ElementId(names.size() - 1);
+            }
+
+            const std::string & Name(ElementId id) const {
+                return std::size_t(id) < names.size() ? names[std::size_t(id)] : names[0];
+            }
+
+        private:
+
+            std::vector<std::string> names;
+            std::unordered_map<std::string, ElementId> ids;
+
+    };
+
     class srcSAXEventContext {
         public:
             srcSAXEventContext() = delete;
@@ -56,20 +142,24 @@ namespace srcSAXEventDispatch{
                   isOperator(false),
                   endArchive(false),
                   currentLineNumber{0},
-                  archiveBuffer{0},
-                  writer{0} {}
+                  writer{0},
+                  archiveBuffer{0} {}
             ~srcSAXEventContext(){
                 if(writer){
+                    delete writer;
+                }
+                if(archiveBuffer){
                     xmlBufferFree(archiveBuffer);
-                    xmlFreeTextWriter(writer);
                 }
             }
-            //Objects for writing to archive and obtaining archive post-parse
-            xmlTextWriterPtr writer;
-            xmlBufferPtr archiveBuffer;
+            //Writer for the regenerated archive, null unless generating one
+            srcMLWriter * writer;
 
             EventDispatcher * dispatcher;
             const std::vector<std::string> & elementStack;
+            //Interned ids of elementStack, maintained by the dispatcher
+            std::vector<ElementId> elementIds;
+            ElementTable elementTable;
             std::vector<int> genericDepth;
             unsigned int currentLineNumber;
             std::vector<unsigned short int> triggerField;
@@ -78,6 +168,83 @@ namespace srcSAXEventDispatch{
             std::size_t depth;
             bool isPrev, isOperator, endArchive;
 
+        private:
+            std::string qualifiedName;
+            //copy of the archive handed out by ArchiveBuffer
+            xmlBufferPtr archiveBuffer;
+
+        public:
+
+            /**
+             * Reset
+             *
+             * Restore the context to its just-constructed state for the next
+             * document.  Container capacity is kept.  If an archive is being
+             * generated, the writer is cleared.
+             */
+            void Reset() {
+                std::fill(triggerField.begin(), triggerField.end(), 0);
+                genericDepth.clear();
+                depth = 0;
+                currentLineNumber = 0;
+                isPrev = isOperator = endArchive = false;
+                currentFilePath.clear();
+                currentFileName.clear();
+                currentFileLanguage.clear();
+                currentsrcMLRevision.clear();
+                currentTag.clear();
+                currentToken.clear();
+                currentAttributeName.clear();
+                currentAttributeValue.clear();
+                elementIds.clear();
+                if(writer) {
+                    writer->Clear();
+                }
+            }
+
+            /**
+             * ArchiveBuffer
+             *
+             * Deprecated: the regenerated archive was once kept in a public
+             * xmlBufferPtr archiveBuffer field; use the dispatcher's
+             * GetArchive() or writer->Buffer().  Returns a copy of what has
+             * been written so far, owned by the context and refreshed by each
+             * call, or null if no archive is being generated.
+             */
+            SRCSAX_DEPRECATED("use srcSAXEventDispatcher::GetArchive()") xmlBufferPtr ArchiveBuffer() {
+                if(!writer) return nullptr;
+                if(!archiveBuffer) archiveBuffer = xmlBufferCreate();
+                xmlBufferEmpty(archiveBuffer);
+                xmlBufferAdd(archiveBuffer, (const xmlChar *)writer->Buffer().data(), writer->Buffer().size());
+                return archiveBuffer;
+            }
+
+            /* the current element, i.e. elementStack.back(); ElementId::none outside any element */
+            inline ElementId Element() const {
+                return Parent(0);
+            }
+            /* the k-th enclosing element (Parent(1) is elementStack[size - 2]); ElementId::none past the root */
+            inline ElementId Parent(std::size_t k) const {
+                return k < elementIds.size() ? elementIds[elementIds.size() - 1 - k] : ElementId::none;
+            }
+            inline const std::string & ElementName(ElementId id) const {
+                return elementTable.Name(id);
+            }
+
+            /* called by the dispatcher as srcSAX pushes and pops elementStack */
+            void PushElement(const char * prefix, const char * localname) {
+                qualifiedName.clear();
+                if(prefix) {
+                    qualifiedName += prefix;
+                    qualifiedName += ':';
+                }
+                qualifiedName += localname;
+                elementIds.push_back(elementTable.Intern(qualifiedName));
+            }
+            void PopElement() {
+                if(!elementIds.empty()) elementIds.pop_back();
+            }
+
           /**
             * write_start_tag
             * @param localname the name of the element tag
@@ -96,25 +263,7 @@ namespace srcSAXEventDispatch{
             void write_start_tag(const char* localname, const char* prefix, const char* URI,
                                 int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
                                 const struct srcsax_attribute * attributes) {
-                xmlTextWriterStartElementNS(writer, (const xmlChar *)prefix, (const xmlChar *)localname, 0);
-                bool seenpos = false;
-                for(int pos = 0; pos < num_namespaces; ++pos) {
-                    std::string name = "xmlns";
-                    if(namespaces[pos].prefix) {
-                        name += ":";
-                        name += (const char *)namespaces[pos].prefix;
-    
-                    }
-                    xmlTextWriterWriteAttribute(writer, (const xmlChar *)name.c_str(), (const xmlChar *)namespaces[pos].uri);
-                }
-                for(int pos = 0; pos < num_attributes; ++pos) {
-                    std::string str(attributes[pos].localname);
-                    if(str == "line" || str == "filename"){
-                    xmlTextWriterWriteAttributeNS(writer, (const xmlChar *)attributes[pos].prefix, (const xmlChar *)attributes[pos].localname,
-                        (const xmlChar *)attributes[pos].uri, (const xmlChar *)attributes[pos].value);                    
-                    }
-    
-                }
+                writer->WriteStartTag(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
             }
           /**
             * write_content
@@ -122,29 +271,16 @@ namespace srcSAXEventDispatch{
             *
             * Write out the provided text content, escaping everything but ".
             */
-            void write_content(const std::string &text_content) {        
-                if(!text_content.empty()) {        
-                    /*
-                        Normal output of text is for the most part
-                        identical to what libxml2 provides.  However,
-                        srcML does not escape " while libxml2 does escape
-                        quotations.
-                    */
-                    int ret = 0;
-                    char * text = (char *)text_content.c_str();
-                    for(char * pos = text; *pos; ++pos) {       
-                        if(*pos != '"') continue;       
-                        
-                        *pos = 0;
-                        ret = xmlTextWriterWriteString(writer, (const xmlChar *)text);
-                               
-                        *pos = '\"';
-                        xmlTextWriterWriteRaw(writer, (const xmlChar *)"\"");
-                               
-                        text = pos + 1;     
-                    }       
-                    ret = xmlTextWriterWriteString(writer, (const xmlChar *)text);
-                }  
+            void write_content(const std::string &text_content) {
+                /*
+                    Normal output of text is for the most part
+                    identical to what libxml2 provides.  However,
+                    srcML does not escape " while libxml2 does escape
+                    quotations.
+                */
+                if(!text_content.empty()) {
+                    writer->WriteString(text_content);
+                }
             }
             inline bool And(const std::vector<ParserState> vec) const{
                 for(auto field : vec){
@@ -202,24 +338,79 @@ namespace srcSAXEventDispatch{
             }
     };
 
+    /* handler installed by NopOpenEvents/NopCloseEvents; recognizable through std::function::target_type */
+    struct NopEvent {
+        void operator()(const srcSAXEventContext & ctx) const {}
+    };
+
     class EventListener {
-        typedef std::unordered_map<srcSAXEventDispatch::ParserState, std::function<void(srcSAXEventDispatch::srcSAXEventContext&)>, std::hash<int>> EventMap;
+        public:
+            typedef std::function<void(srcSAXEventDispatch::srcSAXEventContext&)> EventHandler;
+            typedef std::unordered_map<srcSAXEventDispatch::ParserState, EventHandler, std::hash<int>> EventMap;
+            //Handlers subscribed at one absolute depth, keyed by DepthEventKey
+            typedef std::unordered_map<std::size_t, EventHandler> DepthEventMap;
+
         protected:
            bool dispatched;
            EventMap openEventMap, closeEventMap;
+           DepthEventMap openDepthEventMap, closeDepthEventMap;
+           std::size_t depthAnchor;
 
 
         public:
 
-            EventListener() : dispatched(false) {
+            EventListener() : dispatched(false), depthAnchor(0) {
                 DefaultEventHandlers();
             }
 
+            static std::size_t DepthEventKey(ParserState state, std::size_t depth) {
+                return (depth << (8 * sizeof(ParserState))) | state;
+            }
+
             void SetDispatched(bool isDispatched) { dispatched = isDispatched; }
+            bool IsDispatched() const { return dispatched; }
+
+            /**
+             * Reset
+             *
+             * Return the listener to its just-constructed state so its
+             * dispatcher can be reused for another document.  Policies that
+             * keep per-document state override this and call the base.
+             */
+            virtual void Reset() {
+                dispatched = false;
+                ClearDepthEvents();
+            }
 
             virtual const EventMap & GetOpenEventMap() const { return openEventMap; }
             virtual const EventMap & GetCloseEventMap() const { return closeEventMap; }
 
+            /* whether open or close events of state run a handler other than the default no-op */
+            bool Subscribes(ParserState state) const {
+                return IsHandled(GetOpenEventMap(), state) || IsHandled(GetCloseEventMap(), state);
+            }
+
+            /**
+             * FindHandler
+             *
+             * The handler HandleEvent runs for an event at a depth: the one
+             * subscribed at that depth if any, else the unscoped one.
+             * nullptr if there is neither.
+             */
+            const EventHandler * FindHandler(ParserState pstate, ElementState estate, std::size_t depth) const {
+
+                const DepthEventMap & depthHandlers = estate == ElementState::open ? openDepthEventMap : closeDepthEventMap;
+                if(!depthHandlers.empty()) {
+                    DepthEventMap::const_iterator event = depthHandlers.find(DepthEventKey(pstate, depth));
+                    if(event != depthHandlers.end()) return &event->second;
+                }
+
+                const EventMap & handlers = estate == ElementState::open ? openEventMap : closeEventMap;
+                EventMap::const_iterator event = handlers.find(pstate);
+                return event != handlers.end() ? &event->second : nullptr;
+
+            }
+
             virtual void HandleEvent() { dispatched = true; }
             virtual void HandleEvent(srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate, srcSAXEventDispatch::srcSAXEventContext& ctx) {
 
@@ -227,37 +418,53 @@ namespace srcSAXEventDispatch{
 
                 dispatched = true;
 
-                switch(estate){
-
-                    case srcSAXEventDispatch::ElementState::open: {
-                        auto event = openEventMap.find(pstate);
-                        if(event != openEventMap.end()){
-                            event->second(ctx);
-                        }
-                        break;
-                    }
-
-                    case srcSAXEventDispatch::ElementState::close: {
-                        auto event = closeEventMap.find(pstate);
-                        if(event != closeEventMap.end()){
-                            event->second(ctx);
-                        }
-                        break;
-                    }
-
-                    default:
-                        throw std::runtime_error("Something went terribly, terribly wrong");
+                if(estate != srcSAXEventDispatch::ElementState::open && estate != srcSAXEventDispatch::ElementState::close)
+                    throw std::runtime_error("Something went terribly, terribly wrong");
 
+                const EventHandler * event = FindHandler(pstate, estate, ctx.depth);
+                if(event){
+                    (*event)(ctx);
                 }
 
             }
 
         protected:
+
+            /**
+             * Depth-scoped subscriptions
+             *
+             * Instead of guarding a handler with (policyDepth + k) == ctx.depth,
+             * anchor the policy at its start (SetDepthAnchor(ctx.depth)) and
+             * subscribe the handler at relative depth k.  It then runs only for
+             * events at that depth, in place of the unscoped handler; elsewhere
+             * the unscoped handler runs as before.  Subscriptions are dropped by
+             * ClearDepthEvents and Reset.  A running depth-scoped handler must
+             * not clear or remove its own subscription.
+             */
+            void SetDepthAnchor(std::size_t depth) { depthAnchor = depth; }
+            void OpenEventAtDepth(ParserState state, std::size_t relativeDepth, const EventHandler & handler) {
+                openDepthEventMap[DepthEventKey(state, depthAnchor + relativeDepth)] = handler;
+            }
+            void CloseEventAtDepth(ParserState state, std::size_t relativeDepth, const EventHandler & handler) {
+                closeDepthEventMap[DepthEventKey(state, depthAnchor + relativeDepth)] = handler;
+            }
+            void RemoveOpenEventAtDepth(ParserState state, std::size_t relativeDepth) {
+                openDepthEventMap.erase(DepthEventKey(state, depthAnchor + relativeDepth));
+            }
+            void RemoveCloseEventAtDepth(ParserState state, std::size_t relativeDepth) {
+                closeDepthEventMap.erase(DepthEventKey(state, depthAnchor + relativeDepth));
+            }
+            void ClearDepthEvents() {
+                openDepthEventMap.clear();
+                closeDepthEventMap.clear();
+                depthAnchor = 0;
+            }
+
             void NopOpenEvents(std::initializer_list<ParserState> states) {
 
                 for(ParserState state : states) {
 
-                    openEventMap[state] = [this](const srcSAXEventContext& ctx) {};
+                    openEventMap[state] = NopEvent();
 
                 }
 
@@ -266,7 +473,7 @@ namespace srcSAXEventDispatch{
 
                 for(ParserState state : states) {
 
-                    closeEventMap[state] = [this](const srcSAXEventContext& ctx) {};
+                    closeEventMap[state] = NopEvent();
 
                 }
 
@@ -274,6 +481,11 @@ namespace srcSAXEventDispatch{
 
         private:
 
+            static bool IsHandled(const EventMap & handlers, ParserState state) {
+                EventMap::const_iterator event = handlers.find(state);
+                return event != handlers.end() && event->second && event->second.target_type() != typeid(NopEvent);
+            }
+
             void DefaultEventHandlers() {
                 using namespace srcSAXEventDispatch;
 
@@ -383,12 +595,23 @@ namespace srcSAXEventDispatch{
         virtual void RemoveListener(EventListener* l) = 0;
         virtual void RemoveListenerDispatch(EventListener* listener) = 0;
         virtual void RemoveListenerNoDispatch(EventListener* listener) = 0;
+
+        /**
+         * StopParse
+         *
+         * Request that the parse stop at the next element boundary.
+         * May be called by a policy through ctx.dispatcher or by another thread.
+         * Unit and archive close events are still delivered so policies can flush.
+         */
+        void StopParse() { stopRequested = true; }
+        bool IsStopRequested() const { return stopRequested; }
     protected:
         srcSAXEventContext ctx;
         std::list<EventListener*> elementListeners;
+        std::atomic<bool> stopRequested;
 
         EventDispatcher(const std::vector<std::string> & elementStack)
-            : elementListeners(), ctx(this, elementStack) {}
+            : elementListeners(), ctx(this, elementStack), stopRequested(false) {}
         virtual void DispatchEvent(ParserState, ElementState) = 0;
     };
     class PolicyDispatcher;
@@ -400,9 +623,21 @@ namespace srcSAXEventDispatch{
             virtual void Notify(const PolicyDispatcher * policy, const srcSAXEventContext & ctx) = 0;
 
         };
+    /**
+     * FlushMode
+     *
+     * When policies that accumulate results over the archive deliver them.
+     * archive: once, at archive close (the default).  unit: at each unit
+     * close, with that unit's results, which are then released; whatever
+     * they carry across units is kept in explicitly bounded structures, so
+     * memory follows the largest unit rather than the archive.  Policies
+     * that already notify per construct behave the same in both modes.
+     */
+    enum class FlushMode { archive, unit };
+
     class PolicyDispatcher{
     public:
-        PolicyDispatcher(std::initializer_list<PolicyListener *> listeners) : policyListeners(listeners){}
+        PolicyDispatcher(std::initializer_list<PolicyListener *> listeners) : policyListeners(listeners), flushMode(FlushMode::archive){}
         virtual void AddListener(PolicyListener* listener){
             policyListeners.push_back(listener);
         }
@@ -417,8 +652,12 @@ namespace srcSAXEventDispatch{
 
         }
 
+        void SetFlushMode(FlushMode mode) { flushMode = mode; }
+        FlushMode GetFlushMode() const { return flushMode; }
+
     protected:
         std::list<PolicyListener*> policyListeners;
+        FlushMode flushMode;
         virtual void * DataInner() const = 0;
         virtual void NotifyAll(const srcSAXEventContext & ctx) {
             for(std::list<PolicyListener*>::iterator listener = policyListeners.begin(); listener != policyListeners.end(); ++listener){
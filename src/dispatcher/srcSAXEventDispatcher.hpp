@@ -30,8 +30,20 @@
 #include <vector>
 #include <algorithm>
 #include <srcSAXEventDispatchUtilities.hpp>
+#include <srcSAXUnitFilter.hpp>
+#include <srcSAXTextUtilities.hpp>
+#include <srcSAXEventTracer.hpp>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+#include <srcSAXDispatchProfile.hpp>
+#endif
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+#include <srcSAXAllocationTracker.hpp>
+#endif
 
 namespace srcSAXEventDispatch {
 
@@ -62,6 +74,59 @@ namespace srcSAXEventDispatch {
         return listeners;
     }
 
+    /**
+     * DispatchStats
+     *
+     * Counters kept by the dispatcher over a parse.  Events before elision
+     * is what would have been dispatched without whitespace/position elision;
+     * events after elision is what actually was.
+     */
+    struct DispatchStats {
+
+        DispatchStats() : elements(0), textNodes(0), whitespaceElided(0), positionsElided(0),
+                          eventsDispatched(0), eventsElided(0), unitsSkipped(0), unitsOversized(0) {}
+
+        std::size_t elements;
+        std::size_t textNodes;
+        std::size_t whitespaceElided;
+        std::size_t positionsElided;
+        std::size_t eventsDispatched;
+        std::size_t eventsElided;
+        std::size_t unitsSkipped;
+        std::size_t unitsOversized;
+
+        DispatchStats & operator+=(const DispatchStats & other) {
+            elements += other.elements;
+            textNodes += other.textNodes;
+            whitespaceElided += other.whitespaceElided;
+            positionsElided += other.positionsElided;
+            eventsDispatched += other.eventsDispatched;
+            eventsElided += other.eventsElided;
+            unitsSkipped += other.unitsSkipped;
+            unitsOversized += other.unitsOversized;
+            return *this;
+        }
+
+        std::size_t EventsBeforeElision() const { return eventsDispatched + eventsElided; }
+        std::size_t EventsAfterElision() const { return eventsDispatched; }
+
+        friend std::ostream & operator<<(std::ostream & out, const DispatchStats & stats) {
+
+            out << "elements:               " << stats.elements << '\n'
+                << "text nodes:             " << stats.textNodes << '\n'
+                << "whitespace elided:      " << stats.whitespaceElided << '\n'
+                << "positions elided:       " << stats.positionsElided << '\n'
+                << "events before elision:  " << stats.EventsBeforeElision() << '\n'
+                << "events after elision:   " << stats.EventsAfterElision() << '\n'
+                << "units skipped:          " << stats.unitsSkipped << '\n'
+                << "units oversized:        " << stats.unitsOversized << '\n';
+
+            return out;
+
+        }
+
+    };
+
     template <typename ...policies>
     class srcSAXEventDispatcher : public srcSAXHandler, public EventDispatcher {
     #pragma GCC diagnostic push
@@ -69,70 +134,225 @@ namespace srcSAXEventDispatch {
 
     private:
         std::unordered_map< std::string, std::function<void()>> process_map, process_map2;
+        /* user-defined events by element name; see AddEvent */
+        std::unordered_map<std::string, ParserState> userEvents;
         bool classflagopen, functionflagopen, whileflagopen, ifflagopen, elseflagopen, ifelseflagopen, forflagopen, switchflagopen;
 
         bool dispatching;
         bool generateArchive;
+        bool stopped;
         ParserState currentPState;
         ElementState currentEState;
 
         std::size_t numberAllocatedListeners;
 
+        UnitFilter unitFilter;
+        bool skippingUnit;
+        /* a unit under a maximum size is buffered until its close, then replayed */
+        bool bufferingUnit;
+        bool replayingUnit;
+        UnitBuffer unitBuffer;
+        std::vector<std::string> unitStack;
+
+        bool elide;
+
+        std::string textBuffer;
+
     protected:
+        DispatchStats stats;
+
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+        DispatchProfile profile;
+        std::ostream * profileTable = &std::cerr;
+        std::ostream * profileJSON = nullptr;
+#endif
+
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+        AllocationTracker allocations;
+        std::ostream * allocationReport = &std::cerr;
+#endif
+
+        srcSAXEventTracer * tracer = nullptr;
+        unsigned int traceLine = 0;
+
+        /* value of the pos:line attribute, 0 if there is none */
+        static unsigned int LineAttribute(int num_attributes, const struct srcsax_attribute * attributes) {
+            for(int pos = 0; pos < num_attributes; ++pos) {
+                if(attributes[pos].prefix && std::strcmp(attributes[pos].localname, "line") == 0 && std::strcmp(attributes[pos].prefix, "pos") == 0)
+                    return strtoul(attributes[pos].value, NULL, 0);
+            }
+            return 0;
+        }
+
+        /* construct spans open before and close after the listeners see the event, so policy spans nest inside */
+        void TraceBefore(ParserState pstate, ElementState estate) {
+            if(tracer && estate == ElementState::open) tracer->ConstructOpen(pstate, traceLine);
+        }
+        void TraceAfter(ParserState pstate, ElementState estate) {
+            if(tracer && estate == ElementState::close) tracer->ConstructClose(pstate);
+        }
+
+        /*
+            deliver an event to one listener, profiled when built with SRCSAX_EVENT_DISPATCH_PROFILE
+            and with its allocations accounted when built with SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+        */
+        void Deliver(EventListener * listener, ParserState pstate, ElementState estate) {
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            DispatchProfile::Sample sample = profile.Begin(listener, pstate, estate, ctx.depth);
+#endif
+            {
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+                AllocationScope scope(allocations, listener, pstate, estate);
+#endif
+                listener->HandleEvent(pstate, estate, ctx);
+            }
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            profile.End(sample);
+#endif
+        }
+
+        /* write the profiling and allocation reports, if enabled; called at archive close */
+        void ReportProfile() {
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            if(profileTable) profile.WriteTable(*profileTable);
+            if(profileJSON) profile.WriteJSON(*profileJSON);
+#endif
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+            if(allocationReport && AllocationTracker::HooksInstalled()) allocations.WriteReport(*allocationReport);
+#endif
+        }
+
         void DispatchEvent(ParserState pstate, ElementState estate) override {
 
+            ++stats.eventsDispatched;
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            profile.RecordEvent(pstate, estate);
+#endif
             dispatching = true;
             currentPState = pstate;
             currentEState = estate;
 
+            TraceBefore(pstate, estate);
             for(std::list<EventListener*>::iterator listener = elementListeners.begin(); listener != elementListeners.end(); ++listener ){
-                (*listener)->HandleEvent(pstate, estate, ctx);
+                Deliver(*listener, pstate, estate);
             }
             for(std::list<EventListener*>::iterator listener = elementListeners.begin(); listener != elementListeners.end(); ++listener ){
                 (*listener)->SetDispatched(false);
             }
+            TraceAfter(pstate, estate);
 
             dispatching = false;
 
         }
 
-        virtual void AddEvent(const std::string & event) {
+        /**
+         * FlushText
+         *
+         * libxml2 may split one text node over several charactersUnit calls
+         * (entities, input buffer boundaries).  Characters are buffered and
+         * dispatched here, at the next element boundary, as exactly one
+         * tokenstring per contiguous text run.  The buffer is swapped with
+         * ctx.currentToken so both keep their capacity.
+         */
+        void FlushText() {
 
-            std::pair<std::string, std::function<void()>> openEvent(event, [this, event]() {
-                    ctx.currentTag = event; 
-                    ++ctx.triggerField[ParserState::userdefined];
-                    DispatchEvent(ParserState::userdefined, ElementState::open);
-                } );
-            process_map.insert(openEvent);
+            if(textBuffer.empty()) return;
 
-            std::pair<std::string, std::function<void()>> closeEvent(event, [this, event]() {
-                    ctx.currentTag = event;
-                    DispatchEvent(ParserState::userdefined, ElementState::close);
-                    --ctx.triggerField[ParserState::userdefined];
-                } );
+            ++stats.textNodes;
+            ctx.currentToken.swap(textBuffer);
+            textBuffer.clear();
 
-            process_map2.insert(closeEvent);
+            if(elide && IsWhitespace(ctx.currentToken.data(), ctx.currentToken.size())) {
+                ++stats.whitespaceElided;
+                ++stats.eventsElided;
+            } else {
+                std::unordered_map<std::string, std::function<void()>>::const_iterator process = process_map2.find("tokenstring");
+                process->second();
+            }
+
+            if (generateArchive) { ctx.write_content(ctx.currentToken); }
 
         }
 
-        virtual void AddEvents(std::initializer_list<std::string> events) {
+        /**
+         * FlushTextBeforeStart
+         *
+         * srcSAX pushes an element onto srcml_element_stack before
+         * startElement; text ahead of it belongs to the enclosing element,
+         * so it is flushed with the new element taken off the stack.
+         */
+        void FlushTextBeforeStart() {
 
-            for(const std::string & event : events){
-                AddEvent(event);
-            }
+            if(textBuffer.empty() || srcml_element_stack.empty()) return;
+
+            std::string started;
+            started.swap(srcml_element_stack.back());
+            srcml_element_stack.pop_back();
+            FlushText();
+            srcml_element_stack.push_back(std::string());
+            srcml_element_stack.back().swap(started);
 
         }
 
-        virtual void RemoveEvent(const std::string & event) {
-            process_map.erase(event);
-            process_map2.erase(event);
+        /**
+         * FlushTextBeforeEnd
+         * @param localname the name of the element tag being closed
+         * @param prefix the tag prefix
+         *
+         * srcSAX pops an element off srcml_element_stack before endElement
+         * and endUnit; text ahead of the end tag belongs to that element, so
+         * it is flushed with the element put back on the stack.
+         */
+        void FlushTextBeforeEnd(const char * localname, const char * prefix) {
+
+            if(textBuffer.empty()) return;
+
+            srcml_element_stack.push_back(std::string());
+            if(prefix) {
+                srcml_element_stack.back() += prefix;
+                srcml_element_stack.back() += ':';
+            }
+            srcml_element_stack.back() += localname;
+            FlushText();
+            srcml_element_stack.pop_back();
+
         }
 
-        virtual void RemoveEvents(std::initializer_list<std::string> events) {
+        /**
+         * StopIfRequested
+         *
+         * Checked at element boundaries.  When a stop has been requested,
+         * deliver the outstanding unit and archive close events and nothing
+         * else, finish the regenerated archive and stop the libxml2 parse.
+         *
+         * @returns true if the parse is (now) stopped and the caller should do nothing.
+         */
+        bool StopIfRequested() {
 
-            for(const std::string & event : events){
-                RemoveEvent(event);
+            if(stopped) return true;
+            if(!IsStopRequested()) return false;
+
+            stopped = true;
+
+            //text buffered since the request is written to the archive but not dispatched
+            if(!skippingUnit && generateArchive && !textBuffer.empty()) { ctx.write_content(textBuffer); }
+            textBuffer.clear();
+
+            std::unordered_map<std::string, std::function<void()>>::const_iterator process2 = process_map2.find("unit");
+            while(ctx.triggerField[ParserState::unit]) {
+                process2->second();
             }
+            if(tracer) tracer->UnitEnd();
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+            allocations.UnitEnd();
+#endif
+
+            if(generateArchive) { ctx.writer->EndDocument(); }
+
+            ReportProfile();
+
+            stop_parser();
+            return true;
 
         }
 
@@ -144,35 +364,308 @@ namespace srcSAXEventDispatch {
             }
         }
 
-        srcSAXEventDispatcher(PolicyListener * listener, bool genArchive = false) : EventDispatcher(srcml_element_stack) {
+        srcSAXEventDispatcher(PolicyListener * listener, bool genArchive = false)
+            : srcSAXEventDispatcher(listener, genArchive ? new srcMLWriter() : nullptr) {}
+
+        srcSAXEventDispatcher(std::initializer_list<EventListener*> listeners, bool genArchive = false)
+            : srcSAXEventDispatcher(listeners, genArchive ? new srcMLWriter() : nullptr) {}
+
+        /**
+         * srcSAXEventDispatcher
+         * @param listener listener for the policies
+         * @param archiveWriter writer for the regenerated archive (owned), e.g.
+         *        new srcMLWriter("out.xml"), or nullptr for no archive
+         *
+         * The writer is flushed to its sink at each unit end.
+         */
+        srcSAXEventDispatcher(PolicyListener * listener, srcMLWriter * archiveWriter) : EventDispatcher(srcml_element_stack) {
             elementListeners = CreateListeners<policies...>(listener);
             numberAllocatedListeners = elementListeners.size();
             dispatching = false;
-            generateArchive = genArchive;
+            stopped = false;
+            skippingUnit = bufferingUnit = replayingUnit = false;
+            elide = false;
+            generateArchive = archiveWriter != nullptr;
+            ctx.writer = archiveWriter;
             classflagopen = functionflagopen = whileflagopen = ifflagopen = elseflagopen = ifelseflagopen = forflagopen = switchflagopen = false;
-            
-            if(genArchive) {
-                ctx.archiveBuffer = xmlBufferCreate();
-                xmlOutputBufferPtr ob = xmlOutputBufferCreateBuffer (ctx.archiveBuffer, NULL);
-                ctx.writer = xmlNewTextWriter (ob);
-            }
             InitializeHandlers();
         }
 
-        srcSAXEventDispatcher(std::initializer_list<EventListener*> listeners, bool genArchive = false) : EventDispatcher(srcml_element_stack) {
+        srcSAXEventDispatcher(std::initializer_list<EventListener*> listeners, srcMLWriter * archiveWriter) : EventDispatcher(srcml_element_stack) {
             elementListeners = listeners;
             numberAllocatedListeners = elementListeners.size();
             dispatching = false;
-            generateArchive = genArchive;
+            stopped = false;
+            skippingUnit = bufferingUnit = replayingUnit = false;
+            elide = false;
+            generateArchive = archiveWriter != nullptr;
+            ctx.writer = archiveWriter;
             classflagopen = functionflagopen = whileflagopen = ifflagopen = elseflagopen = ifelseflagopen = forflagopen = switchflagopen = false;
-            if(genArchive) {
-                ctx.archiveBuffer = xmlBufferCreate();
-                xmlOutputBufferPtr ob = xmlOutputBufferCreateBuffer (ctx.archiveBuffer, NULL);
-                ctx.writer = xmlNewTextWriter (ob);
-            }
             InitializeHandlers();
         }
+
+        /**
+         * SetArchiveWriter
+         * @param archiveWriter writer for the regenerated archive (owned), or nullptr
+         *
+         * Replace the archive writer, e.g. to point a pooled dispatcher at a
+         * new output between documents.  The previous writer is flushed and
+         * deleted.  If that flush throws, the exception propagates, the
+         * previous writer is kept and archiveWriter is deleted.
+         */
+        void SetArchiveWriter(srcMLWriter * archiveWriter) {
+            std::unique_ptr<srcMLWriter> replacement(archiveWriter);
+            if(ctx.writer) ctx.writer->Flush();
+            delete ctx.writer;
+            ctx.writer = replacement.release();
+            generateArchive = archiveWriter != nullptr;
+        }
+
+        /**
+         * SetUnitFilter
+         * @param filter the filter to evaluate at each startUnit
+         *
+         * Units rejected by the filter are skipped entirely: no element,
+         * tokenstring or unit events are dispatched and nothing is written
+         * to the regenerated archive.  With a maximum unit size, each unit
+         * is buffered and only dispatched at its close, once it is known to
+         * fit; the buffer holds at most one unit of that size.
+         */
+        void SetUnitFilter(const UnitFilter & filter) {
+            unitFilter = filter;
+        }
+
+        /**
+         * SetElision
+         * @param elideEvents whether to elide whitespace and position events
+         *
+         * When on, whitespace-only text is classified once here and not
+         * dispatched as tokenstring (ctx.currentToken is still updated and
+         * the text is still written to the archive), and pos:position only
+         * updates ctx.currentLineNumber without dispatching its attributes.
+         */
+        void SetElision(bool elideEvents) {
+            elide = elideEvents;
+        }
+
+        /**
+         * SetFlushMode
+         * @param mode when the dispatcher's policies deliver accumulated results
+         *
+         * Applies to the policies the dispatcher was created with; see FlushMode.
+         */
+        void SetFlushMode(FlushMode mode) {
+            std::list<EventListener*>::iterator listener = elementListeners.begin();
+            for(std::size_t count = 0; count < numberAllocatedListeners; ++count, ++listener) {
+                PolicyDispatcher * policy = dynamic_cast<PolicyDispatcher *>(*listener);
+                if(policy) policy->SetFlushMode(mode);
+            }
+        }
+
+        const DispatchStats & GetStats() const {
+            return stats;
+        }
+
+        /**
+         * Subscribes
+         * @param state a parser state
+         *
+         * @returns whether any of the dispatcher's policies handles open or
+         * close events of state.
+         */
+        bool Subscribes(ParserState state) const {
+            for(const EventListener * listener : elementListeners) {
+                if(listener->Subscribes(state)) return true;
+            }
+            return false;
+        }
+
+        /**
+         * AddEvent
+         * @param event local name of a srcML element, e.g. comment
+         *
+         * Dispatch open and close events for the element under an event id
+         * of its own.  Ids are allocated densely from FIRSTUSEREVENT on, in
+         * the order events are first added, and each has its own
+         * ctx.triggerField slot; listeners subscribe to them in
+         * openEventMap and closeEventMap like any ParserState.  Adding an
+         * event again, also after RemoveEvent, returns the same id.
+         * Elements with a built-in state cannot be added.  Every added
+         * element is also raised as ParserState::userdefined, inside its own
+         * event, for listeners that tell them apart by ctx.currentTag.
+         *
+         * @returns the event id
+         */
+        virtual ParserState AddEvent(const std::string & event) {
+
+            std::unordered_map<std::string, ParserState>::const_iterator added = userEvents.find(event);
+            ParserState id;
+            if(added != userEvents.end()) {
+                id = added->second;
+            } else {
+                if(process_map.count(event) || process_map2.count(event))
+                    throw std::invalid_argument("AddEvent: " + event + " has a built-in state");
+                if(FIRSTUSEREVENT + userEvents.size() > std::numeric_limits<unsigned short>::max())
+                    throw std::length_error("AddEvent: out of event ids");
+                id = ParserState(FIRSTUSEREVENT + userEvents.size());
+                userEvents.insert(std::make_pair(event, id));
+                if(ctx.triggerField.size() <= id) ctx.triggerField.resize(id + 1, 0);
+            }
+
+            process_map[event] = [this, id]() {
+                ++ctx.triggerField[id];
+                DispatchEvent(id, ElementState::open);
+                ++ctx.triggerField[ParserState::userdefined];
+                DispatchEvent(ParserState::userdefined, ElementState::open);
+            };
+            process_map2[event] = [this, id]() {
+                DispatchEvent(ParserState::userdefined, ElementState::close);
+                --ctx.triggerField[ParserState::userdefined];
+                DispatchEvent(id, ElementState::close);
+                --ctx.triggerField[id];
+            };
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            profile.NameEvent(id, event);
+#endif
+
+            return id;
+
+        }
+
+        /** AddEvent for each event; returns the ids in the same order. */
+        virtual std::vector<ParserState> AddEvents(std::initializer_list<std::string> events) {
+
+            std::vector<ParserState> ids;
+            for(const std::string & event : events){
+                ids.push_back(AddEvent(event));
+            }
+            return ids;
+
+        }
+
+        /** Stop dispatching a user-defined event; its id stays reserved. */
+        virtual void RemoveEvent(const std::string & event) {
+            if(!userEvents.count(event)) return;
+            process_map.erase(event);
+            process_map2.erase(event);
+        }
+
+        virtual void RemoveEvents(std::initializer_list<std::string> events) {
+
+            for(const std::string & event : events){
+                RemoveEvent(event);
+            }
+
+        }
+
+        /** Whether elements of this local name are dispatched, by a built-in state or AddEvent. */
+        bool DispatchesElement(const std::string & element) const {
+            return process_map.count(element) != 0;
+        }
+
+        /** The id AddEvent gave an event, or ParserState::empty if it was never added. */
+        ParserState EventId(const std::string & event) const {
+            std::unordered_map<std::string, ParserState>::const_iterator added = userEvents.find(event);
+            return added != userEvents.end() ? added->second : ParserState::empty;
+        }
+
+        /**
+         * SetTracer
+         * @param eventTracer tracer to record unit, construct and policy spans to, or nullptr
+         *
+         * The tracer is not owned and may be shared between dispatchers.
+         */
+        void SetTracer(srcSAXEventTracer * eventTracer) {
+            tracer = eventTracer;
+        }
+
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+        const DispatchProfile & GetProfile() const {
+            return profile;
+        }
+
+        /**
+         * SetProfileOutput
+         * @param table stream for the table report (default std::cerr), or nullptr
+         * @param json stream for the JSON report (default none), or nullptr
+         *
+         * The reports are written when the archive closes.
+         */
+        void SetProfileOutput(std::ostream * table, std::ostream * json) {
+            profileTable = table;
+            profileJSON = json;
+        }
+#endif
+
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+        /** Allocation accounting; mark allocation-free policies and set strict mode here. */
+        AllocationTracker & GetAllocations() {
+            return allocations;
+        }
+
+        /**
+         * SetAllocationReport
+         * @param out stream for the allocation report written at archive close (default std::cerr), or nullptr
+         */
+        void SetAllocationReport(std::ostream * out) {
+            allocationReport = out;
+        }
+#endif
+
+        /**
+         * GetArchive
+         *
+         * The regenerated archive, or an empty string if the dispatcher
+         * was not asked to generate one.  When the writer streams to a
+         * sink, only output not yet flushed.
+         */
+        const std::string & GetArchive() const {
+            static const std::string empty;
+            return generateArchive ? ctx.writer->Buffer() : empty;
+        }
+
+        /**
+         * Reset
+         *
+         * Prepare the dispatcher for another document without rebuilding the
+         * handler maps or reallocating policies.  Listeners attached by
+         * policies during the last document are detached, every allocated
+         * listener is reset, and the context, flags and statistics are
+         * restored.  The unit filter, elision setting and user-defined
+         * events are configuration and are kept.
+         */
+        virtual void Reset() {
+
+            while(elementListeners.size() > numberAllocatedListeners) {
+                elementListeners.pop_back();
+            }
+            for(std::list<EventListener*>::iterator listener = elementListeners.begin(); listener != elementListeners.end(); ++listener ){
+                (*listener)->Reset();
+            }
+
+            srcml_element_stack.clear();
+            ctx.Reset();
+
+            classflagopen = functionflagopen = whileflagopen = ifflagopen = elseflagopen = ifelseflagopen = forflagopen = switchflagopen = false;
+            dispatching = false;
+            stopped = false;
+            stopRequested = false;
+            skippingUnit = bufferingUnit = replayingUnit = false;
+            textBuffer.clear();
+            unitBuffer.clear();
+            stats = DispatchStats();
+            traceLine = 0;
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            profile.Clear();
+#endif
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+            allocations.Clear();
+#endif
+
+        }
+
         void AddListener(EventListener* listener) override {
+            if(tracer) tracer->ListenerAdded(listener, traceLine);
             elementListeners.push_back(listener);
         }
         void AddListenerDispatch(EventListener* listener) override {
@@ -188,6 +681,7 @@ namespace srcSAXEventDispatch {
             AddListener(listener);
         }
         void RemoveListener(EventListener* listener) override {
+            if(tracer) tracer->ListenerRemoved(listener);
             elementListeners.erase(std::find(elementListeners.begin(), elementListeners.end(), listener));
         }
         void RemoveListenerDispatch(EventListener* listener) override {
@@ -513,6 +1007,7 @@ namespace srcSAXEventDispatch {
                     --ctx.triggerField[ParserState::classn];
                 } },
                 { "struct", [this](){
+                    --ctx.triggerField[ParserState::classblock];
                     DispatchEvent(ParserState::structn, ElementState::close);
                     --ctx.triggerField[ParserState::classn];
                 } },
@@ -650,10 +1145,11 @@ namespace srcSAXEventDispatch {
         }
 
         virtual void startDocument() {
-            if (generateArchive) { xmlTextWriterStartDocument(ctx.writer, "1.0", "UTF-8", "yes"); }
+            if (generateArchive) { ctx.writer->StartDocument(); }
         }
         virtual void endDocument() {
-            if (generateArchive) { xmlTextWriterEndDocument(ctx.writer); }
+            if(StopIfRequested()) return;
+            if (generateArchive) { ctx.writer->EndDocument(); }
         }
     
         /**
@@ -674,9 +1170,12 @@ namespace srcSAXEventDispatch {
         virtual void startRoot(const char * localname, const char * prefix, const char * URI,
                             int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
                             const struct srcsax_attribute * attributes) override {
+            if(StopIfRequested()) return;
             if(is_archive && generateArchive){
                 ctx.write_start_tag(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
             }
+            ctx.PushElement(prefix, localname);
+            ctx.currentTag = localname;
             std::unordered_map<std::string, std::function<void()>>::const_iterator process = process_map.find("unit");
             if (process != process_map.end()) {
                 process->second();
@@ -700,10 +1199,42 @@ namespace srcSAXEventDispatch {
         virtual void startUnit(const char * localname, const char * prefix, const char * URI,
                             int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
                             const struct srcsax_attribute * attributes) override {
-    
+
+            if(StopIfRequested()) return;
+
+            std::string filename, language;
+            for(int pos = 0; pos < num_attributes; ++pos) {
+                if(attributes[pos].prefix) continue;
+                if(std::strcmp(attributes[pos].localname, "filename") == 0)
+                    filename = attributes[pos].value;
+                else if(std::strcmp(attributes[pos].localname, "language") == 0)
+                    language = attributes[pos].value;
+            }
+
+            if(!unitFilter.Empty() && !unitFilter.Accept(filename, language)) {
+                ++stats.unitsSkipped;
+                skippingUnit = true;
+                return;
+            }
+
+            if(unitFilter.GetMaxUnitSize() && !replayingUnit) {
+                unitBuffer.clear();
+                unitBuffer.Start(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+                unitStack = srcml_element_stack;
+                bufferingUnit = true;
+                return;
+            }
+
+            if(tracer) tracer->UnitStart(filename, language);
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+            allocations.UnitStart(filename);
+#endif
+
             if (generateArchive){
                 ctx.write_start_tag(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
             }
+            if(is_archive) ctx.PushElement(prefix, localname);
+            ctx.currentTag = localname;
             std::unordered_map<std::string, std::function<void()>>::const_iterator process = process_map.find("unit");
             if (process != process_map.end()) {
                 process->second();
@@ -732,12 +1263,37 @@ namespace srcSAXEventDispatch {
         virtual void startElement(const char * localname, const char * prefix, const char * URI,
                                     int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
                                     const struct srcsax_attribute * attributes) override {
-            
+
+            if(StopIfRequested()) return;
+            if(skippingUnit) return;
+            if(bufferingUnit) {
+                unitBuffer.Start(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+                return;
+            }
+
+            FlushTextBeforeStart();
+
             if(generateArchive){
                 ctx.write_start_tag(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
             }
             
             ++ctx.depth;
+            ++stats.elements;
+            ctx.PushElement(prefix, localname);
+
+            if(tracer) {
+                unsigned int line = LineAttribute(num_attributes, attributes);
+                if(line) traceLine = line;
+            }
+
+            if(elide && prefix && std::strcmp(localname, "position") == 0 && std::strcmp(prefix, "pos") == 0) {
+                if(num_attributes) {
+                    ctx.currentLineNumber = strtoul(attributes[0].value, NULL, 0);
+                }
+                ++stats.positionsElided;
+                stats.eventsElided += num_attributes;
+                return;
+            }
 
             std::string localName;
             if(prefix) {
@@ -799,34 +1355,87 @@ namespace srcSAXEventDispatch {
         * Overide for desired behaviour.
         */
         virtual void charactersUnit(const char * ch, int len) override {
-            ctx.currentToken.clear();
-            ctx.currentToken.append(ch, len);
-            std::unordered_map<std::string, std::function<void()>>::const_iterator process = process_map2.find("tokenstring");
-            process->second();
-            if (generateArchive) { ctx.write_content(ctx.currentToken); }
+            if(StopIfRequested()) return;
+            if(skippingUnit) return;
+            if(bufferingUnit) {
+                unitBuffer.Characters(ch, len);
+                if(unitBuffer.TextSize() > unitFilter.GetMaxUnitSize()) {
+                    ++stats.unitsOversized;
+                    unitBuffer.clear();
+                    bufferingUnit = false;
+                    skippingUnit = true;
+                }
+                return;
+            }
+            textBuffer.append(ch, len);
         }
     
         // end elements may need to be used if you want to collect only on per file basis or some other granularity.
         virtual void endRoot(const char * localname, const char * prefix, const char * URI) override {
+            if(StopIfRequested()) return;
+            FlushTextBeforeEnd(localname, prefix);
+            if(is_archive) ctx.PopElement();
             std::unordered_map<std::string, std::function<void()>>::const_iterator process2 = process_map2.find("unit");
             if (process2 != process_map2.end()) {
                 process2->second();
             }
             if(is_archive && generateArchive) {
-                xmlTextWriterEndElement(ctx.writer);
-            }            
+                ctx.writer->EndElement();
+            }
+            ReportProfile();
         }
         virtual void endUnit(const char * localname, const char * prefix, const char * URI) override {
+            if(StopIfRequested()) return;
+            if(skippingUnit) {
+                skippingUnit = false;
+                return;
+            }
+            if(bufferingUnit) {
+                //the unit fits: dispatch it as if it were being parsed now
+                bufferingUnit = false;
+                replayingUnit = true;
+                unitStack.swap(srcml_element_stack);
+                unitBuffer.Replay(*this, srcml_element_stack);
+                unitStack.swap(srcml_element_stack);
+                replayingUnit = false;
+                unitBuffer.clear();
+                if(StopIfRequested()) return;
+            }
+            FlushTextBeforeEnd(localname, prefix);
+            ctx.PopElement();
             std::unordered_map<std::string, std::function<void()>>::const_iterator process2 = process_map2.find("unit");
             if (process2 != process_map2.end()) {
                 process2->second();
             }
+            if(tracer) tracer->UnitEnd();
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+            allocations.UnitEnd();
+#endif
 
-            if (generateArchive) { xmlTextWriterEndElement(ctx.writer); }
+            if (generateArchive) {
+                ctx.writer->EndElement();
+                ctx.writer->Flush();
+            }
         }
     
         virtual void endElement(const char * localname, const char * prefix, const char * URI) override {
 
+            if(StopIfRequested()) return;
+            if(skippingUnit) return;
+            if(bufferingUnit) {
+                unitBuffer.End(localname, prefix, URI);
+                return;
+            }
+
+            FlushTextBeforeEnd(localname, prefix);
+            ctx.PopElement();
+
+            if(elide && prefix && std::strcmp(localname, "position") == 0 && std::strcmp(prefix, "pos") == 0) {
+                --ctx.depth;
+                if (generateArchive) { ctx.writer->EndElement(); }
+                return;
+            }
+
             std::string localName;
             if(prefix) {
                 localName += prefix;
@@ -843,7 +1452,7 @@ namespace srcSAXEventDispatch {
 
             --ctx.depth;
 
-            if (generateArchive) { xmlTextWriterEndElement(ctx.writer); }
+            if (generateArchive) { ctx.writer->EndElement(); }
         }
     #pragma GCC diagnostic pop
     
@@ -0,0 +1,151 @@
+/**
+ * @file srcSAXEventDispatcherPool.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_EVENT_DISPATCHER_POOL_HPP
+#define INCLUDED_SRCSAX_EVENT_DISPATCHER_POOL_HPP
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * srcSAXEventDispatcherPool
+     *
+     * Keeps constructed dispatchers (handler maps and policies included)
+     * around between documents.  Acquire hands out an idle dispatcher, or
+     * builds one with the factory if none is idle; the returned lease gives
+     * it back on destruction, after calling its Reset().
+     *
+     * Acquire and release are thread safe.  A leased dispatcher is used by
+     * one thread at a time.
+     *
+     *     srcSAXEventDispatcherPool<srcSAXEventDispatcher<ClassPolicy>> pool(
+     *         [&listener]() { return new srcSAXEventDispatcher<ClassPolicy>(&listener); });
+     *
+     *     auto dispatcher = pool.Acquire();
+     *     srcSAXController control(srcml);
+     *     control.parse(dispatcher.get());
+     */
+    template <typename Dispatcher>
+    class srcSAXEventDispatcherPool {
+
+    public:
+
+        typedef std::function<Dispatcher * ()> Factory;
+
+        class Lease {
+
+        public:
+
+            Lease(srcSAXEventDispatcherPool * pool, Dispatcher * dispatcher) : pool(pool), dispatcher(dispatcher) {}
+            Lease(Lease && other) : pool(other.pool), dispatcher(other.dispatcher) {
+                other.dispatcher = nullptr;
+            }
+            Lease(const Lease &) = delete;
+            Lease & operator=(const Lease &) = delete;
+
+            ~Lease() {
+                if(dispatcher) pool->Release(dispatcher);
+            }
+
+            Dispatcher * get() const { return dispatcher; }
+            Dispatcher * operator->() const { return dispatcher; }
+            Dispatcher & operator*() const { return *dispatcher; }
+
+        private:
+
+            srcSAXEventDispatcherPool * pool;
+            Dispatcher * dispatcher;
+
+        };
+
+        /**
+         * srcSAXEventDispatcherPool
+         * @param factory creates a new dispatcher when none is idle
+         * @param reserve number of dispatchers to build up front
+         */
+        srcSAXEventDispatcherPool(Factory factory, std::size_t reserve = 0) : factory(factory) {
+
+            for(std::size_t count = 0; count < reserve; ++count) {
+                Dispatcher * dispatcher = factory();
+                dispatchers.push_back(std::unique_ptr<Dispatcher>(dispatcher));
+                idle.push_back(dispatcher);
+            }
+
+        }
+
+        srcSAXEventDispatcherPool(const srcSAXEventDispatcherPool &) = delete;
+        srcSAXEventDispatcherPool & operator=(const srcSAXEventDispatcherPool &) = delete;
+
+        Lease Acquire() {
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!idle.empty()) {
+                    Dispatcher * dispatcher = idle.back();
+                    idle.pop_back();
+                    return Lease(this, dispatcher);
+                }
+            }
+
+            Dispatcher * dispatcher = factory();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            dispatchers.push_back(std::unique_ptr<Dispatcher>(dispatcher));
+            return Lease(this, dispatcher);
+
+        }
+
+        /** Number of dispatchers owned by the pool, leased or idle. */
+        std::size_t Size() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return dispatchers.size();
+        }
+
+        /** Number of idle dispatchers. */
+        std::size_t Idle() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return idle.size();
+        }
+
+    private:
+
+        void Release(Dispatcher * dispatcher) {
+
+            dispatcher->Reset();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(dispatcher);
+
+        }
+
+        Factory factory;
+
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<Dispatcher>> dispatchers;
+        std::vector<Dispatcher *> idle;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,290 @@
+/**
+ * @file srcSAXEventRecorder.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_EVENT_RECORDER_HPP
+#define INCLUDED_SRCSAX_EVENT_RECORDER_HPP
+
+#include <srcSAXEventDispatchUtilities.hpp>
+#include <srcSAXDispatchProfile.hpp>
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * RecordedEvent
+     *
+     * One event as a listener saw it: the state, the element depth, a
+     * snapshot of ctx.triggerField and the token (the text for tokenstring,
+     * name=value for xmlattribute, the tag otherwise).
+     */
+    struct RecordedEvent {
+
+        ParserState pstate;
+        ElementState estate;
+        std::size_t depth;
+        std::vector<unsigned short int> triggerField;
+        std::string token;
+
+        bool operator==(const RecordedEvent & other) const {
+            return pstate == other.pstate && estate == other.estate && depth == other.depth
+                && token == other.token && triggerField == other.triggerField;
+        }
+        bool operator!=(const RecordedEvent & other) const { return !(*this == other); }
+
+    };
+
+    inline std::ostream & operator<<(std::ostream & out, const RecordedEvent & event) {
+
+        out << ParserStateName(event.pstate) << (event.estate == ElementState::open ? " open" : " close")
+            << " depth=" << event.depth << " token=\"" << event.token << "\" open={";
+        bool first = true;
+        for(std::size_t state = 0; state < event.triggerField.size(); ++state) {
+            if(!event.triggerField[state]) continue;
+            out << (first ? "" : " ") << ParserStateName(ParserState(state)) << '=' << event.triggerField[state];
+            first = false;
+        }
+        return out << '}';
+
+    }
+
+    /**
+     * UnitRecording
+     *
+     * The events of one unit, from its open to its close, without those of
+     * nested units.  Events outside every unit (archive open and close)
+     * form a recording of their own.  A leaf recording is a unit with no
+     * nested unit, i.e. a source file.
+     */
+    struct UnitRecording {
+        UnitRecording(bool leaf = true) : leaf(leaf) {}
+        std::string filename;
+        bool leaf;
+        std::vector<RecordedEvent> events;
+    };
+
+    /**
+     * EventRecorderPolicy
+     *
+     * Records every event it is dispatched.  Put it first in the policy
+     * list so it sees the context before other policies handle the event.
+     * Listeners are notified as each recording completes, at unit close
+     * and at archive close; Data<UnitRecording>() is the completed
+     * recording and is valid during the notification only.
+     */
+    class EventRecorderPolicy : public EventListener, public PolicyDispatcher {
+
+    public:
+
+        EventRecorderPolicy(std::initializer_list<PolicyListener *> listeners = {}) : PolicyDispatcher(listeners) {
+            recordings.push_back(UnitRecording(false));
+        }
+
+        void Reset() override {
+            EventListener::Reset();
+            recordings.assign(1, UnitRecording(false));
+            completed = UnitRecording();
+        }
+
+        void HandleEvent(ParserState pstate, ElementState estate, srcSAXEventContext & ctx) override {
+
+            if(dispatched) return;
+            dispatched = true;
+
+            if(pstate == ParserState::unit && estate == ElementState::open) {
+                recordings.back().leaf = false;
+                recordings.push_back(UnitRecording());
+            }
+
+            RecordedEvent event;
+            event.pstate = pstate;
+            event.estate = estate;
+            event.depth = ctx.depth;
+            event.triggerField = ctx.triggerField;
+            if(pstate == ParserState::tokenstring)
+                event.token = ctx.currentToken;
+            else if(pstate == ParserState::xmlattribute)
+                event.token = ctx.currentAttributeName + '=' + ctx.currentAttributeValue;
+            else
+                event.token = ctx.currentTag;
+            recordings.back().events.push_back(event);
+
+            if(pstate == ParserState::unit && estate == ElementState::close && recordings.size() > 1) {
+                recordings.back().filename = ctx.currentFilePath;
+                Complete(ctx);
+            } else if(pstate == ParserState::archive && estate == ElementState::close) {
+                Complete(ctx);
+                recordings.assign(1, UnitRecording(false));
+            }
+
+        }
+
+    protected:
+
+        void * DataInner() const override {
+            return (void *)&completed;
+        }
+
+    private:
+
+        void Complete(const srcSAXEventContext & ctx) {
+            completed.filename.swap(recordings.back().filename);
+            completed.leaf = recordings.back().leaf;
+            completed.events.swap(recordings.back().events);
+            recordings.pop_back();
+            NotifyAll(ctx);
+            completed.events.clear();
+        }
+
+        /* open recordings, outermost (archive level) first */
+        std::vector<UnitRecording> recordings;
+        UnitRecording completed;
+
+    };
+
+    /**
+     * RecordingListener
+     *
+     * Collects the recordings of EventRecorderPolicy, in completion order.
+     * Notifications from other policies are ignored, so it can listen to a
+     * whole policy set.
+     */
+    class RecordingListener : public PolicyListener {
+
+    public:
+
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventContext & ctx) override {
+            if(!dynamic_cast<const EventRecorderPolicy *>(policy)) return;
+            recordings.push_back(*policy->Data<UnitRecording>());
+        }
+
+        void Clear() { recordings.clear(); }
+
+        std::size_t NumberEvents() const {
+            std::size_t count = 0;
+            for(const UnitRecording & recording : recordings)
+                count += recording.events.size();
+            return count;
+        }
+
+        std::vector<UnitRecording> recordings;
+
+    };
+
+    /**
+     * RecordingComparison
+     *
+     * ordered:  every recording, in order; for serial dispatch paths.
+     * per_unit: leaf recordings matched by filename (and occurrence), in
+     *           any order; for drivers that parse units separately, such
+     *           as srcSAXParallelDispatcher, where archive-level events
+     *           repeat per unit.
+     */
+    enum class RecordingComparison { ordered, per_unit };
+
+    namespace detail {
+
+        inline bool CompareEvents(const UnitRecording & reference, const UnitRecording & candidate, std::size_t recording, std::ostream & report) {
+
+            std::size_t size = std::min(reference.events.size(), candidate.events.size());
+            std::size_t event = 0;
+            while(event < size && reference.events[event] == candidate.events[event])
+                ++event;
+            if(event == size && reference.events.size() == candidate.events.size()) return true;
+
+            report << "first divergence in recording " << recording
+                   << " (" << (reference.filename.empty() ? "archive" : reference.filename) << ") at event " << event << '\n';
+            for(std::size_t before = event < 3 ? 0 : event - 3; before < event; ++before)
+                report << "  same:      " << reference.events[before] << '\n';
+            if(event < reference.events.size()) report << "  reference: " << reference.events[event] << '\n';
+            else report << "  reference: (end of unit)\n";
+            if(event < candidate.events.size()) report << "  candidate: " << candidate.events[event] << '\n';
+            else report << "  candidate: (end of unit)\n";
+            return false;
+
+        }
+
+    }
+
+    /**
+     * CompareRecordings
+     * @param reference recordings of the reference dispatcher
+     * @param candidate recordings of the dispatcher under test
+     * @param comparison how recordings are matched up
+     * @param report stream the first divergence is described on
+     *
+     * Returns true if the candidate saw exactly the reference's events.
+     */
+    inline bool CompareRecordings(const std::vector<UnitRecording> & reference, const std::vector<UnitRecording> & candidate,
+                                  RecordingComparison comparison, std::ostream & report) {
+
+        if(comparison == RecordingComparison::ordered) {
+
+            std::size_t size = std::min(reference.size(), candidate.size());
+            for(std::size_t recording = 0; recording < size; ++recording) {
+                if(!detail::CompareEvents(reference[recording], candidate[recording], recording, report)) return false;
+            }
+            if(reference.size() != candidate.size()) {
+                report << "reference has " << reference.size() << " recordings, candidate " << candidate.size() << '\n';
+                return false;
+            }
+            return true;
+
+        }
+
+        /* key leaf recordings by filename and occurrence of that filename */
+        std::map<std::string, const UnitRecording *> candidates;
+        std::map<std::string, std::size_t> occurrences;
+        for(const UnitRecording & recording : candidate) {
+            if(!recording.leaf) continue;
+            candidates[recording.filename + '#' + std::to_string(occurrences[recording.filename]++)] = &recording;
+        }
+
+        occurrences.clear();
+        std::size_t matched = 0;
+        for(std::size_t recording = 0; recording < reference.size(); ++recording) {
+
+            if(!reference[recording].leaf) continue;
+
+            std::string key = reference[recording].filename + '#' + std::to_string(occurrences[reference[recording].filename]++);
+            std::map<std::string, const UnitRecording *>::const_iterator match = candidates.find(key);
+            if(match == candidates.end()) {
+                report << "unit " << key << " (recording " << recording << ") missing from candidate\n";
+                return false;
+            }
+            if(!detail::CompareEvents(reference[recording], *match->second, recording, report)) return false;
+            ++matched;
+
+        }
+
+        if(matched != candidates.size()) {
+            report << "candidate has " << candidates.size() - matched << " unit(s) not in the reference\n";
+            return false;
+        }
+        return true;
+
+    }
+
+}
+
+#endif
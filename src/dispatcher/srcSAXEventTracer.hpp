@@ -0,0 +1,298 @@
+/**
+ * @file srcSAXEventTracer.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_EVENT_TRACER_HPP
+#define INCLUDED_SRCSAX_EVENT_TRACER_HPP
+
+#include <srcSAXEventDispatchUtilities.hpp>
+#include <srcSAXDispatchProfile.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * srcSAXEventTracer
+     *
+     * Writes a Chrome trace-event JSON file (chrome://tracing, Perfetto,
+     * speedscope) of a dispatch run.  Attach with the dispatcher's
+     * SetTracer; one tracer may be shared by several dispatchers, each
+     * thread getting its own track.  Spans are complete ("X") events:
+     *
+     *  - unit      one per unit, named by its filename
+     *  - construct one per class, struct, function, constructor, destructor,
+     *              their declarations and decl_stmt, opened before and closed
+     *              after the listeners handle the element
+     *  - policy    one per listener attached during the parse (nested
+     *              policies pushed by ClassPolicy, FunctionPolicy, ...),
+     *              from AddListener to RemoveListener, named by its type
+     *
+     * Every span carries the filename and the line it started on
+     * (from pos:line, so parse with position information).
+     */
+    class srcSAXEventTracer {
+
+    public:
+
+        /** Trace to a file, created or truncated. */
+        srcSAXEventTracer(const std::string & path)
+            : file(new std::ofstream(path.c_str())), out(*file), first(true), closed(false), start(Clock::now()) {
+
+            if(!*file)
+                throw std::runtime_error("srcSAXEventTracer: unable to open " + path);
+            out << "{\"traceEvents\":[";
+
+        }
+
+        /** Trace to a stream, which must outlive the tracer. */
+        srcSAXEventTracer(std::ostream & out)
+            : file(nullptr), out(out), first(true), closed(false), start(Clock::now()) {
+            out << "{\"traceEvents\":[";
+        }
+
+        ~srcSAXEventTracer() {
+            Close();
+            delete file;
+        }
+
+        srcSAXEventTracer(const srcSAXEventTracer &) = delete;
+        srcSAXEventTracer & operator=(const srcSAXEventTracer &) = delete;
+
+        /** Finish the JSON document.  Spans still open are dropped. */
+        void Close() {
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if(closed) return;
+            closed = true;
+
+            out << "],\"displayTimeUnit\":\"ns\"}\n";
+            out.flush();
+
+        }
+
+        /* called by the dispatchers */
+
+        void UnitStart(const std::string & filename, const std::string & language) {
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+
+            Track & track = CurrentTrack();
+            track.constructs.clear();
+            track.listeners.clear();
+            track.unit = Span{ filename.empty() ? "unit" : filename, "unit", 0, now };
+            track.filename = filename;
+            track.language = language;
+            track.inUnit = true;
+
+        }
+
+        void UnitEnd() {
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+
+            Track & track = CurrentTrack();
+            if(!track.inUnit) return;
+            track.inUnit = false;
+
+            Write(track, track.unit, now, "\"language\":\"" + Escape(track.language) + "\"");
+
+        }
+
+        void ConstructOpen(ParserState pstate, unsigned int line) {
+
+            const char * name = ConstructName(pstate);
+            if(!name) return;
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+            CurrentTrack().constructs.push_back(Span{ name, "construct", line, now });
+
+        }
+
+        void ConstructClose(ParserState pstate) {
+
+            if(!ConstructName(pstate)) return;
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+
+            Track & track = CurrentTrack();
+            if(track.constructs.empty()) return;
+            Write(track, track.constructs.back(), now, "");
+            track.constructs.pop_back();
+
+        }
+
+        void ListenerAdded(const EventListener * listener, unsigned int line) {
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+            CurrentTrack().listeners[listener] = Span{ ListenerName(listener), "policy", line, now };
+
+        }
+
+        void ListenerRemoved(const EventListener * listener) {
+
+            double now = Now();
+            std::lock_guard<std::mutex> lock(mutex);
+
+            Track & track = CurrentTrack();
+            std::unordered_map<const EventListener *, Span>::iterator span = track.listeners.find(listener);
+            if(span == track.listeners.end()) return;
+            Write(track, span->second, now, "");
+            track.listeners.erase(span);
+
+        }
+
+    private:
+
+        typedef std::chrono::steady_clock Clock;
+
+        struct Span {
+            std::string name;
+            const char * category;
+            unsigned int line;
+            double start;
+        };
+
+        /* open spans of one thread */
+        struct Track {
+            int tid;
+            std::string filename, language;
+            bool inUnit;
+            Span unit;
+            std::vector<Span> constructs;
+            std::unordered_map<const EventListener *, Span> listeners;
+        };
+
+        static const char * ConstructName(ParserState pstate) {
+            switch(pstate) {
+                case ParserState::classn:          return "class";
+                case ParserState::structn:         return "struct";
+                case ParserState::function:        return "function";
+                case ParserState::functiondecl:    return "function_decl";
+                case ParserState::constructor:     return "constructor";
+                case ParserState::constructordecl: return "constructor_decl";
+                case ParserState::destructor:      return "destructor";
+                case ParserState::destructordecl:  return "destructor_decl";
+                case ParserState::declstmt:        return "decl_stmt";
+                default:                           return nullptr;
+            }
+        }
+
+        /* microseconds since the tracer was created */
+        double Now() const {
+            return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        }
+
+        Track & CurrentTrack() {
+
+            std::unordered_map<std::thread::id, Track>::iterator track = tracks.find(std::this_thread::get_id());
+            if(track != tracks.end()) return track->second;
+
+            Track & added = tracks[std::this_thread::get_id()];
+            added.tid = tracks.size();
+            added.inUnit = false;
+
+            Separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << added.tid
+                << ",\"args\":{\"name\":\"dispatcher " << added.tid << "\"}}";
+
+            return added;
+
+        }
+
+        const std::string & ListenerName(const EventListener * listener) {
+
+            std::type_index type(typeid(*listener));
+            std::unordered_map<std::type_index, std::string>::const_iterator name = listenerNames.find(type);
+            if(name != listenerNames.end()) return name->second;
+
+            return listenerNames[type] = ListenerTypeName(typeid(*listener));
+
+        }
+
+        void Write(const Track & track, const Span & span, double end, const std::string & args) {
+
+            if(closed) return;
+
+            char times[64];
+            std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", span.start, end - span.start);
+
+            Separator();
+            out << "{\"name\":\"" << Escape(span.name) << "\",\"cat\":\"" << span.category << "\",\"ph\":\"X\","
+                << times << ",\"pid\":1,\"tid\":" << track.tid
+                << ",\"args\":{\"file\":\"" << Escape(track.filename) << "\"";
+            if(span.line) out << ",\"line\":" << span.line;
+            if(!args.empty()) out << ',' << args;
+            out << "}}";
+
+        }
+
+        void Separator() {
+            if(!first) out << ",\n";
+            first = false;
+        }
+
+        static std::string Escape(const std::string & text) {
+
+            std::string escaped;
+            for(char ch : text) {
+                if(ch == '"' || ch == '\\') {
+                    escaped.push_back('\\');
+                    escaped.push_back(ch);
+                } else if(static_cast<unsigned char>(ch) < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", ch);
+                    escaped.append(code);
+                } else {
+                    escaped.push_back(ch);
+                }
+            }
+            return escaped;
+
+        }
+
+        std::ofstream * file;
+        std::ostream & out;
+        bool first;
+        bool closed;
+        Clock::time_point start;
+
+        std::mutex mutex;
+        std::unordered_map<std::thread::id, Track> tracks;
+        std::unordered_map<std::type_index, std::string> listenerNames;
+
+    };
+
+}
+
+#endif
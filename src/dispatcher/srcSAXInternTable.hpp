@@ -0,0 +1,109 @@
+/**
+ * @file srcSAXInternTable.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_INTERN_TABLE_HPP
+#define INCLUDED_SRCSAX_INTERN_TABLE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * InternTable
+     *
+     * Maps strings to dense ids 0, 1, 2, ... in order of first appearance,
+     * so per-string state can live in plain vectors indexed by id.  An
+     * open-addressing table with linear probing; the hash of each string is
+     * kept so probes and growth compare strings only on a hash match.
+     */
+    class InternTable {
+
+    public:
+
+        static const unsigned int npos = ~0u;
+
+        InternTable() : slots(16, 0) {}
+
+        /** The id of name, adding it if new. */
+        unsigned int Intern(const std::string & name) {
+
+            std::size_t hash = hasher(name);
+            std::size_t slot = Probe(name, hash);
+            if(slots[slot]) return slots[slot] - 1;
+
+            names.push_back(name);
+            hashes.push_back(hash);
+            slots[slot] = names.size();
+            if(2 * names.size() > slots.size()) Grow();
+            return names.size() - 1;
+
+        }
+
+        /** The id of name, npos if it has not been interned. */
+        unsigned int Find(const std::string & name) const {
+            std::size_t slot = Probe(name, hasher(name));
+            return slots[slot] ? slots[slot] - 1 : npos;
+        }
+
+        const std::string & Name(unsigned int id) const { return names[id]; }
+        std::size_t size() const { return names.size(); }
+
+        /** Forget all strings; ids restart from 0. */
+        void clear() {
+            names.clear();
+            hashes.clear();
+            std::vector<unsigned int>(16, 0).swap(slots);
+        }
+
+    private:
+
+        /* the slot holding name, or the empty slot where it belongs */
+        std::size_t Probe(const std::string & name, std::size_t hash) const {
+            std::size_t mask = slots.size() - 1;
+            std::size_t slot = hash & mask;
+            while(slots[slot] && (hashes[slots[slot] - 1] != hash || names[slots[slot] - 1] != name))
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+
+        void Grow() {
+            std::vector<unsigned int> grown(2 * slots.size(), 0);
+            std::size_t mask = grown.size() - 1;
+            for(std::size_t id = 0; id < names.size(); ++id) {
+                std::size_t slot = hashes[id] & mask;
+                while(grown[slot]) slot = (slot + 1) & mask;
+                grown[slot] = id + 1;
+            }
+            slots.swap(grown);
+        }
+
+        std::hash<std::string> hasher;
+        std::vector<std::string> names;
+        std::vector<std::size_t> hashes;
+        /* id + 1, 0 for empty; size is a power of two at most half full */
+        std::vector<unsigned int> slots;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,451 @@
+/**
+ * @file srcSAXParallelDispatcher.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_PARALLEL_DISPATCHER_HPP
+#define INCLUDED_SRCSAX_PARALLEL_DISPATCHER_HPP
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXController.hpp>
+#include <srcMLWriter.hpp>
+
+#include <libxml/parser.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * SynchronizedPolicyListener
+     *
+     * Forwards notifications to a listener under a mutex, so one listener
+     * can be shared by dispatchers running on several threads.
+     */
+    class SynchronizedPolicyListener : public PolicyListener {
+
+    public:
+
+        SynchronizedPolicyListener(PolicyListener * listener) : listener(listener) {}
+
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventContext & ctx) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            listener->Notify(policy, ctx);
+        }
+
+    private:
+
+        PolicyListener * listener;
+        std::mutex mutex;
+
+    };
+
+    /**
+     * srcSAXParallelDispatcher
+     *
+     * Per-unit parallel driver.  The units of a srcML archive are split
+     * textually and parsed on a pool of worker threads, each with its own
+     * srcSAXEventDispatcher<policies...> (reused across units via Reset()).
+     * Every unit is parsed as an archive holding just that unit, so archive
+     * events would fire once per unit: Parse throws std::runtime_error
+     * before dispatching anything if a policy handles archive events, as
+     * its archive-wide results would silently cover one unit.  Notifications
+     * are serialized, but arrive in completion order, not archive order.
+     *
+     * With an archive writer, each worker renders its unit into its own
+     * buffer and an ordered committer appends the buffers, in archive
+     * order, under the root element.  One worker at a time writes to the
+     * sink, outside the commit lock, so a slow sink does not hold up the
+     * others.  The result is identical to a serial run of
+     * srcSAXEventDispatcher with the same writer.
+     *
+     * Documents that are not archives are parsed serially, and may use
+     * any policy.
+     */
+    template <typename ...policies>
+    class srcSAXParallelDispatcher {
+
+    public:
+
+        /**
+         * srcSAXParallelDispatcher
+         * @param listener listener for the policies, shared by all workers
+         * @param archiveWriter writer for the regenerated archive (owned), or nullptr
+         * @param numThreads number of workers, 0 for one per hardware thread
+         */
+        srcSAXParallelDispatcher(PolicyListener * listener, srcMLWriter * archiveWriter = nullptr, std::size_t numThreads = 0)
+            : listener(listener), archiveWriter(archiveWriter), numThreads(numThreads), elide(false), tracer(nullptr) {
+
+            if(!this->numThreads) this->numThreads = std::thread::hardware_concurrency();
+            if(!this->numThreads) this->numThreads = 1;
+
+        }
+
+        ~srcSAXParallelDispatcher() {
+            delete archiveWriter;
+        }
+
+        void SetUnitFilter(const UnitFilter & filter) { unitFilter = filter; }
+        void SetElision(bool elideEvents) { elide = elideEvents; }
+        /** Trace all workers to one tracer (not owned); each worker gets its own track. */
+        void SetTracer(srcSAXEventTracer * eventTracer) { tracer = eventTracer; }
+
+        /**
+         * AddEvent
+         * @param event local name of a srcML element
+         *
+         * Add a user-defined event to every worker's dispatcher.  Workers
+         * add events in the same order, so the id returned here is the one
+         * every worker dispatches.
+         */
+        ParserState AddEvent(const std::string & event) {
+            std::vector<std::string>::const_iterator added = std::find(userEvents.begin(), userEvents.end(), event);
+            if(added == userEvents.end()) added = userEvents.insert(userEvents.end(), event);
+            return ParserState(FIRSTUSEREVENT + (added - userEvents.begin()));
+        }
+
+        /** Statistics of the last Parse, summed over all units. */
+        const DispatchStats & GetStats() const { return stats; }
+
+        /** The regenerated archive; only output not yet flushed when streaming to a sink. */
+        const std::string & GetArchive() const {
+            static const std::string empty;
+            return archiveWriter ? archiveWriter->Buffer() : empty;
+        }
+
+        /**
+         * Parse
+         * @param srcml srcML document
+         *
+         * Dispatch all units of the document.  Exceptions thrown by a worker
+         * are rethrown here after all workers finish.  Throws
+         * std::runtime_error for an archive if a policy handles archive
+         * events.
+         */
+        void Parse(const std::string & srcml) {
+
+            std::string prefix;
+            std::vector<std::pair<std::size_t, std::size_t>> units;
+
+            stats = DispatchStats();
+
+            if(!SplitArchive(srcml, prefix, units)) {
+                ParseSerial(srcml);
+                return;
+            }
+
+            {
+                srcSAXEventDispatcher<policies...> probe(listener, nullptr);
+                if(probe.Subscribes(ParserState::archive))
+                    throw std::runtime_error("srcSAXParallelDispatcher: a policy handles archive events, which would fire once per unit");
+            }
+
+            if(archiveWriter) WriteHeader(prefix);
+
+            slots.assign(units.size(), std::string());
+            done.assign(units.size(), 0);
+            nextCommit = 0;
+            writing = false;
+            nextUnit = 0;
+            error = nullptr;
+            failed = false;
+
+            xmlInitParser();
+
+            SynchronizedPolicyListener synchronized(listener);
+
+            std::vector<std::thread> workers;
+            std::size_t count = std::min(numThreads, units.size());
+            for(std::size_t worker = 0; worker < count; ++worker) {
+                workers.push_back(std::thread(&srcSAXParallelDispatcher::Work, this, std::cref(srcml), std::cref(prefix), std::cref(units), &synchronized));
+            }
+            for(std::thread & worker : workers) {
+                worker.join();
+            }
+
+            if(error) std::rethrow_exception(error);
+
+            if(archiveWriter) {
+                archiveWriter->EndElement();
+                archiveWriter->EndDocument();
+            }
+
+        }
+
+        /**
+         * SplitArchive
+         * @param srcml srcML document
+         * @param prefix set to the document text up to and including the root start tag
+         * @param units set to the [begin, end) offsets of each unit in the root
+         *
+         * Textual split of an archive into its units.  srcML escapes '<' in
+         * text and units do not nest, so a unit ends at the first </unit>
+         * after it starts.
+         *
+         * @returns false if the document is not an archive (or holds anything
+         * other than units and whitespace in the root).
+         */
+        static bool SplitArchive(const std::string & srcml, std::string & prefix, std::vector<std::pair<std::size_t, std::size_t>> & units) {
+
+            static const std::string unitEnd = "</unit>";
+
+            std::size_t pos = 0;
+            while(true) {
+                pos = srcml.find('<', pos);
+                if(pos == std::string::npos) return false;
+                if(srcml.compare(pos, 2, "<?") != 0 && srcml.compare(pos, 2, "<!") != 0) break;
+                pos = srcml.find('>', pos);
+                if(pos == std::string::npos) return false;
+            }
+
+            if(!IsUnitStart(srcml, pos)) return false;
+
+            std::size_t rootEnd = TagEnd(srcml, pos);
+            if(rootEnd == std::string::npos || srcml[rootEnd - 2] == '/') return false;
+            prefix.assign(srcml, 0, rootEnd);
+
+            units.clear();
+            pos = rootEnd;
+            while(true) {
+
+                pos = srcml.find('<', pos);
+                if(pos == std::string::npos) return false;
+
+                if(srcml.compare(pos, unitEnd.size(), unitEnd) == 0) break;
+                if(!IsUnitStart(srcml, pos)) return false;
+
+                std::size_t end = TagEnd(srcml, pos);
+                if(end == std::string::npos) return false;
+                if(srcml[end - 2] != '/') {
+                    end = srcml.find(unitEnd, end);
+                    if(end == std::string::npos) return false;
+                    end += unitEnd.size();
+                }
+
+                units.push_back(std::make_pair(pos, end));
+                pos = end;
+
+            }
+
+            return !units.empty();
+
+        }
+
+    private:
+
+        static bool IsUnitStart(const std::string & srcml, std::size_t pos) {
+            if(srcml.compare(pos, 5, "<unit") != 0 || pos + 5 >= srcml.size()) return false;
+            char next = srcml[pos + 5];
+            return next == ' ' || next == '>' || next == '/' || next == '\n' || next == '\t' || next == '\r';
+        }
+
+        /* one past the '>' ending the tag starting at pos, skipping quoted attribute values */
+        static std::size_t TagEnd(const std::string & srcml, std::size_t pos) {
+            char quote = 0;
+            for(; pos < srcml.size(); ++pos) {
+                char ch = srcml[pos];
+                if(quote) {
+                    if(ch == quote) quote = 0;
+                } else if(ch == '"' || ch == '\'') {
+                    quote = ch;
+                } else if(ch == '>') {
+                    return pos + 1;
+                }
+            }
+            return std::string::npos;
+        }
+
+        /* renders the XML declaration and root start tag with the archive writer */
+        class HeaderHandler : public srcSAXHandler {
+
+        public:
+
+            HeaderHandler(srcMLWriter * writer) : writer(writer), seenRoot(false) {}
+
+            virtual void startDocument() override {
+                writer->StartDocument();
+            }
+
+            virtual void startRoot(const char * localname, const char * prefix, const char * URI,
+                                   int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                                   const struct srcsax_attribute * attributes) override {
+                if(seenRoot) return;
+                seenRoot = true;
+                writer->WriteStartTag(localname, prefix, URI, num_namespaces, namespaces, num_attributes, attributes);
+            }
+
+        private:
+
+            srcMLWriter * writer;
+            bool seenRoot;
+
+        };
+
+        void WriteHeader(const std::string & prefix) {
+            HeaderHandler handler(archiveWriter);
+            srcSAXController control(prefix + "</unit>");
+            control.parse(&handler);
+        }
+
+        void ParseSerial(const std::string & srcml) {
+
+            srcSAXEventDispatcher<policies...> dispatcher(listener, archiveWriter ? new srcMLWriter() : nullptr);
+            dispatcher.SetUnitFilter(unitFilter);
+            dispatcher.SetElision(elide);
+            dispatcher.SetTracer(tracer);
+            for(const std::string & event : userEvents)
+                dispatcher.AddEvent(event);
+
+            srcSAXController control(srcml);
+            control.parse(&dispatcher);
+            stats = dispatcher.GetStats();
+
+            if(archiveWriter) {
+                const std::string & archive = dispatcher.GetArchive();
+                archiveWriter->WriteRaw(archive.data(), archive.size());
+                archiveWriter->Flush();
+            }
+
+        }
+
+        void Work(const std::string & srcml, const std::string & prefix,
+                  const std::vector<std::pair<std::size_t, std::size_t>> & units, PolicyListener * synchronized) {
+
+            try {
+
+                srcMLWriter * writer = nullptr;
+                if(archiveWriter) {
+                    writer = new srcMLWriter();
+                    writer->SetFragment(true);
+                }
+
+                srcSAXEventDispatcher<policies...> dispatcher(synchronized, writer);
+                dispatcher.SetUnitFilter(unitFilter);
+                dispatcher.SetElision(elide);
+                dispatcher.SetTracer(tracer);
+                for(const std::string & event : userEvents)
+                    dispatcher.AddEvent(event);
+
+                std::string document, text;
+                for(std::size_t index = nextUnit++; index < units.size() && !failed; index = nextUnit++) {
+
+                    document.assign(prefix);
+                    document.append(srcml, units[index].first, units[index].second - units[index].first);
+                    document.append("</unit>");
+
+                    srcSAXController control(document);
+                    control.parse(&dispatcher);
+
+                    if(writer) writer->TakeBuffer(text);
+                    Commit(index, text, dispatcher.GetStats());
+
+                    dispatcher.Reset();
+
+                }
+
+            } catch(...) {
+
+                std::lock_guard<std::mutex> lock(commitMutex);
+                if(!error) error = std::current_exception();
+                failed = true;
+
+            }
+
+        }
+
+        /*
+         * ordered committer: append every finished unit that has no unfinished unit before it.
+         * The worker that finds no writer becomes it and writes outside the lock until nothing
+         * is ready; the others leave their units to it.
+         */
+        void Commit(std::size_t index, std::string & text, const DispatchStats & unitStats) {
+
+            {
+                std::lock_guard<std::mutex> lock(commitMutex);
+
+                stats += unitStats;
+                slots[index].swap(text);
+                done[index] = 1;
+
+                if(!archiveWriter || writing) return;
+                writing = true;
+            }
+
+            std::vector<std::string> ready;
+            try {
+                while(TakeReady(ready)) {
+                    for(const std::string & unit : ready) {
+                        archiveWriter->WriteRaw(unit.data(), unit.size());
+                    }
+                    archiveWriter->Flush();
+                }
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(commitMutex);
+                writing = false;
+                throw;
+            }
+
+        }
+
+        /* moves the units ready to be written, in order, into ready; when there are none, gives up writing */
+        bool TakeReady(std::vector<std::string> & ready) {
+
+            std::lock_guard<std::mutex> lock(commitMutex);
+
+            ready.clear();
+            for(; !failed && nextCommit < slots.size() && done[nextCommit]; ++nextCommit) {
+                if(slots[nextCommit].empty()) continue;
+                ready.push_back(std::string());
+                ready.back().swap(slots[nextCommit]);
+            }
+
+            if(ready.empty()) writing = false;
+            return !ready.empty();
+
+        }
+
+        PolicyListener * listener;
+        srcMLWriter * archiveWriter;
+        std::size_t numThreads;
+
+        UnitFilter unitFilter;
+        bool elide;
+        srcSAXEventTracer * tracer;
+        std::vector<std::string> userEvents;
+
+        std::atomic<std::size_t> nextUnit;
+        std::mutex commitMutex;
+        std::vector<std::string> slots;
+        std::vector<char> done;
+        std::size_t nextCommit;
+        //a worker is writing committed units to the archive writer
+        bool writing;
+        std::exception_ptr error;
+        std::atomic<bool> failed;
+        DispatchStats stats;
+
+    };
+
+}
+
+#endif
@@ -32,7 +32,12 @@ namespace srcSAXEventDispatch {
     public:
 
        srcSAXSingleEventDispatcher(PolicyListener * listener) : srcSAXEventDispatcher<policies...>(listener), dispatched(false) {}
+        virtual void Reset() override {
+            srcSAXEventDispatcher<policies...>::Reset();
+            dispatched = false;
+        }
         virtual void AddListener(EventListener * listener) override {
+            if(srcSAXEventDispatcher<policies...>::tracer) srcSAXEventDispatcher<policies...>::tracer->ListenerAdded(listener, srcSAXEventDispatcher<policies...>::traceLine);
             EventDispatcher::elementListeners.back()->SetDispatched(false);
             EventDispatcher::elementListeners.push_back(listener);
         }
@@ -44,6 +49,7 @@ namespace srcSAXEventDispatch {
             AddListener(listener);
         }
         virtual void RemoveListener(EventListener * listener) override {
+            if(srcSAXEventDispatcher<policies...>::tracer) srcSAXEventDispatcher<policies...>::tracer->ListenerRemoved(EventDispatcher::elementListeners.back());
             EventDispatcher::elementListeners.back()->SetDispatched(false);
             EventDispatcher::elementListeners.pop_back();
         }
@@ -57,16 +63,23 @@ namespace srcSAXEventDispatch {
     protected:
         virtual void DispatchEvent(srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate) override {
 
+            ++srcSAXEventDispatcher<policies...>::stats.eventsDispatched;
+#ifdef SRCSAX_EVENT_DISPATCH_PROFILE
+            srcSAXEventDispatcher<policies...>::profile.RecordEvent(pstate, estate);
+#endif
+
+            srcSAXEventDispatcher<policies...>::TraceBefore(pstate, estate);
             while(!dispatched) {
 
                 dispatched = true;
 
-                EventDispatcher::elementListeners.back()->HandleEvent(pstate, estate, EventDispatcher::ctx);
+                srcSAXEventDispatcher<policies...>::Deliver(EventDispatcher::elementListeners.back(), pstate, estate);
                 EventDispatcher::elementListeners.back()->SetDispatched(false);
 
             }
 
             dispatched = false;
+            srcSAXEventDispatcher<policies...>::TraceAfter(pstate, estate);
 
         }
 
@@ -0,0 +1,123 @@
+/**
+ * @file srcSAXSmallSortedSet.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_SMALL_SORTED_SET_HPP
+#define INCLUDED_SRCSAX_SMALL_SORTED_SET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * SmallSortedSet
+     *
+     * A set kept as a sorted array, held inline up to N elements and on the
+     * heap beyond.  For the handful of line numbers a policy records per
+     * identifier, where a std::set costs a node allocation per element.
+     * The interface is the subset of std::set the policies use.
+     */
+    template<typename T, std::size_t N = 4>
+    class SmallSortedSet {
+
+    public:
+
+        typedef const T * const_iterator;
+        typedef const_iterator iterator;
+
+        SmallSortedSet() : inlineSize(0) {}
+
+        /** Insert if absent; true if inserted. */
+        bool insert(const T & value) {
+
+            T * first = data();
+            T * last = first + size();
+            T * position = std::lower_bound(first, last, value);
+            if(position != last && !(value < *position)) return false;
+
+            if(!heap.empty()) {
+                heap.insert(heap.begin() + (position - first), value);
+            } else if(inlineSize < N) {
+                std::copy_backward(position, last, last + 1);
+                *position = value;
+                ++inlineSize;
+            } else {
+                heap.reserve(2 * N);
+                heap.assign(first, position);
+                heap.push_back(value);
+                heap.insert(heap.end(), position, last);
+                inlineSize = 0;
+            }
+            return true;
+
+        }
+
+        /** Remove if present; the number removed. */
+        std::size_t erase(const T & value) {
+
+            T * first = data();
+            T * last = first + size();
+            T * position = std::lower_bound(first, last, value);
+            if(position == last || value < *position) return 0;
+
+            if(!heap.empty()) {
+                heap.erase(heap.begin() + (position - first));
+            } else {
+                std::copy(position + 1, last, position);
+                --inlineSize;
+            }
+            return 1;
+
+        }
+
+        std::size_t count(const T & value) const {
+            return std::binary_search(begin(), end(), value) ? 1 : 0;
+        }
+
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + size(); }
+        std::size_t size() const { return heap.empty() ? inlineSize : heap.size(); }
+        bool empty() const { return size() == 0; }
+
+        void clear() {
+            heap.clear();
+            inlineSize = 0;
+        }
+
+        bool operator==(const SmallSortedSet & other) const {
+            return size() == other.size() && std::equal(begin(), end(), other.begin());
+        }
+        bool operator!=(const SmallSortedSet & other) const { return !(*this == other); }
+
+    private:
+
+        /* the heap holds every element once used, until emptied */
+        T * data() { return heap.empty() ? items : heap.data(); }
+        const T * data() const { return heap.empty() ? items : heap.data(); }
+
+        T items[N];
+        std::size_t inlineSize;
+        std::vector<T> heap;
+
+    };
+
+}
+
+#endif
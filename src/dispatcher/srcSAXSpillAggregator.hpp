@@ -0,0 +1,349 @@
+/**
+ * @file srcSAXSpillAggregator.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_SPILL_AGGREGATOR_HPP
+#define INCLUDED_SRCSAX_SPILL_AGGREGATOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * SpillTraits
+     *
+     * How a SpillAggregator value is written to and read from a run, and
+     * roughly how much memory it holds.  Specialize for other value types.
+     */
+    template<typename Value>
+    struct SpillTraits;
+
+    template<>
+    struct SpillTraits<std::string> {
+        static void Write(std::ostream & out, const std::string & value) {
+            std::uint32_t size = value.size();
+            out.write((const char *)&size, sizeof(size));
+            out.write(value.data(), size);
+        }
+        static bool Read(std::istream & in, std::string & value) {
+            std::uint32_t size = 0;
+            if(!in.read((char *)&size, sizeof(size))) return false;
+            value.resize(size);
+            return size == 0 || bool(in.read(&value[0], size));
+        }
+        static std::size_t Size(const std::string & value) {
+            return value.capacity();
+        }
+    };
+
+    /**
+     * SpillAggregator
+     *
+     * A key to value aggregation for policies that must see the whole
+     * archive, bounded by a memory budget.  Values added under the same
+     * key are folded with the combiner.  When the in-memory table
+     * exceeds the budget it is sorted and written to a run file (spilled);
+     * Read merges the runs and the table into one stream sorted by key,
+     * folding each key's values in the order they were added, so the
+     * result is the same as with an unbounded map.
+     *
+     * Runs are temporary files in the given directory ($TMPDIR or /tmp by
+     * default), removed by Clear and the destructor.  I/O errors throw
+     * std::runtime_error.
+     */
+    template<typename Value, typename Traits = SpillTraits<Value>>
+    class SpillAggregator {
+
+    public:
+
+        typedef std::function<void(Value & into, const Value & from)> Combiner;
+
+        /* runs merged at once; more are first merged down */
+        static const std::size_t FAN_IN = 64;
+
+        /**
+         * SpillAggregator
+         * @param memoryBudget bytes the in-memory table may hold before spilling
+         * @param combine folds a later value for a key into the earlier one
+         * @param directory where runs are written, empty for $TMPDIR or /tmp
+         */
+        SpillAggregator(std::size_t memoryBudget, Combiner combine, const std::string & directory = "")
+            : memoryBudget(memoryBudget), combine(combine), directory(directory), memoryUsed(0), spilledBytes(0) {
+            if(this->directory.empty()) {
+                const char * tmp = std::getenv("TMPDIR");
+                this->directory = tmp && *tmp ? tmp : "/tmp";
+            }
+        }
+
+        SpillAggregator(const SpillAggregator &) = delete;
+        SpillAggregator & operator=(const SpillAggregator &) = delete;
+
+        ~SpillAggregator() {
+            RemoveRuns();
+        }
+
+        void Add(const std::string & key, const Value & value) {
+
+            typename std::unordered_map<std::string, Value>::iterator entry = table.find(key);
+            if(entry == table.end()) {
+                memoryUsed += EntryOverhead + key.capacity() + Traits::Size(value);
+                table.insert(std::make_pair(key, value));
+            } else {
+                memoryUsed -= Traits::Size(entry->second);
+                combine(entry->second, value);
+                memoryUsed += Traits::Size(entry->second);
+            }
+
+            if(memoryUsed > memoryBudget) Spill();
+
+        }
+
+        std::size_t Runs() const { return runs.size(); }
+        std::size_t SpilledBytes() const { return spilledBytes; }
+        std::size_t MemoryUsed() const { return memoryUsed; }
+        bool Empty() const { return table.empty() && runs.empty(); }
+
+        /** Drop everything, including the runs. */
+        void Clear() {
+            table.clear();
+            memoryUsed = 0;
+            spilledBytes = 0;
+            RemoveRuns();
+        }
+
+        /**
+         * Reader
+         *
+         * The aggregated entries in key order.  Reading does not consume
+         * the aggregator; Add after Read is not seen by the reader.
+         */
+        class Reader {
+
+        public:
+
+            /** The next entry; false at the end. */
+            bool Next(std::string & key, Value & value) {
+
+                if(heap.empty()) return false;
+
+                std::size_t source = heap.top().second;
+                heap.pop();
+                key.swap(sources[source]->key);
+                value = std::move(sources[source]->value);
+                Advance(source);
+
+                while(!heap.empty() && sources[heap.top().second]->key == key) {
+                    std::size_t next = heap.top().second;
+                    heap.pop();
+                    aggregator->combine(value, sources[next]->value);
+                    Advance(next);
+                }
+
+                return true;
+
+            }
+
+        private:
+
+            friend class SpillAggregator;
+
+            /* a run file or the sorted table; sources are numbered in the order their values were added */
+            struct Source {
+                virtual ~Source() {}
+                virtual bool Load() = 0;
+                std::string key;
+                Value value;
+            };
+
+            struct RunSource : public Source {
+                RunSource(const std::string & path) : in(path.c_str(), std::ios::binary) {
+                    if(!in) throw std::runtime_error("SpillAggregator: unable to read run " + path);
+                }
+                bool Load() override {
+                    std::uint32_t size = 0;
+                    if(!in.read((char *)&size, sizeof(size))) return false;
+                    this->key.resize(size);
+                    if(size && !in.read(&this->key[0], size)) throw std::runtime_error("SpillAggregator: truncated run");
+                    if(!Traits::Read(in, this->value)) throw std::runtime_error("SpillAggregator: truncated run");
+                    return true;
+                }
+                std::ifstream in;
+            };
+
+            struct TableSource : public Source {
+                TableSource(const std::unordered_map<std::string, Value> & table) : next(0) {
+                    for(typename std::unordered_map<std::string, Value>::const_iterator entry = table.begin(); entry != table.end(); ++entry)
+                        entries.push_back(&*entry);
+                    std::sort(entries.begin(), entries.end(), [](const std::pair<const std::string, Value> * lhs, const std::pair<const std::string, Value> * rhs) {
+                        return lhs->first < rhs->first;
+                    });
+                }
+                bool Load() override {
+                    if(next == entries.size()) return false;
+                    this->key = entries[next]->first;
+                    this->value = entries[next]->second;
+                    ++next;
+                    return true;
+                }
+                std::vector<const std::pair<const std::string, Value> *> entries;
+                std::size_t next;
+            };
+
+            /* smallest key on top; equal keys in source order */
+            struct Greater {
+                bool operator()(const std::pair<const std::string *, std::size_t> & lhs, const std::pair<const std::string *, std::size_t> & rhs) const {
+                    int order = lhs.first->compare(*rhs.first);
+                    return order != 0 ? order > 0 : lhs.second > rhs.second;
+                }
+            };
+            typedef std::priority_queue<std::pair<const std::string *, std::size_t>, std::vector<std::pair<const std::string *, std::size_t>>, Greater> Heap;
+
+            Reader(SpillAggregator * aggregator, std::vector<std::unique_ptr<Source>> && readSources)
+                : aggregator(aggregator), sources(std::move(readSources)), heap(Greater()) {
+                for(std::size_t source = 0; source < sources.size(); ++source)
+                    Advance(source);
+            }
+
+            void Advance(std::size_t source) {
+                if(sources[source]->Load()) heap.push(std::make_pair(&sources[source]->key, source));
+            }
+
+            SpillAggregator * aggregator;
+            std::vector<std::unique_ptr<Source>> sources;
+            Heap heap;
+
+        };
+
+        /** Merge the runs and the in-memory table; see Reader. */
+        std::unique_ptr<Reader> Read() {
+
+            while(runs.size() >= FAN_IN) MergeRuns();
+
+            std::vector<std::unique_ptr<typename Reader::Source>> sources;
+            for(const std::string & run : runs)
+                sources.emplace_back(new typename Reader::RunSource(run));
+            sources.emplace_back(new typename Reader::TableSource(table));
+            return std::unique_ptr<Reader>(new Reader(this, std::move(sources)));
+
+        }
+
+    private:
+
+        /* rough per-entry cost of the hash table beyond key and value */
+        static const std::size_t EntryOverhead = 64;
+
+        std::string NewRunPath() {
+            std::string path = directory + "/srcsax-spill-XXXXXX";
+            std::vector<char> name(path.begin(), path.end());
+            name.push_back('\0');
+            int fd = mkstemp(name.data());
+            if(fd < 0) throw std::runtime_error("SpillAggregator: unable to create a run in " + directory);
+            ::close(fd);
+            return std::string(name.data());
+        }
+
+        void WriteEntry(std::ofstream & out, const std::string & key, const Value & value) {
+            std::uint32_t size = key.size();
+            out.write((const char *)&size, sizeof(size));
+            out.write(key.data(), size);
+            Traits::Write(out, value);
+        }
+
+        void Spill() {
+
+            std::vector<typename std::unordered_map<std::string, Value>::const_iterator> entries;
+            entries.reserve(table.size());
+            for(typename std::unordered_map<std::string, Value>::const_iterator entry = table.begin(); entry != table.end(); ++entry)
+                entries.push_back(entry);
+            std::sort(entries.begin(), entries.end(), [](const typename std::unordered_map<std::string, Value>::const_iterator & lhs,
+                                                          const typename std::unordered_map<std::string, Value>::const_iterator & rhs) {
+                return lhs->first < rhs->first;
+            });
+
+            std::string path = NewRunPath();
+            runs.push_back(path);
+            std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+            for(const typename std::unordered_map<std::string, Value>::const_iterator & entry : entries)
+                WriteEntry(out, entry->first, entry->second);
+            out.flush();
+            if(!out) throw std::runtime_error("SpillAggregator: unable to write run " + path);
+            spilledBytes += out.tellp();
+
+            std::unordered_map<std::string, Value>().swap(table);
+            memoryUsed = 0;
+
+        }
+
+        /* merge the oldest FAN_IN runs into one, kept in their place so value order is preserved */
+        void MergeRuns() {
+
+            std::vector<std::unique_ptr<typename Reader::Source>> sources;
+            for(std::size_t run = 0; run < FAN_IN; ++run)
+                sources.emplace_back(new typename Reader::RunSource(runs[run]));
+            Reader reader(this, std::move(sources));
+
+            std::string path = NewRunPath();
+            std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+            std::string key;
+            Value value;
+            while(reader.Next(key, value))
+                WriteEntry(out, key, value);
+            out.flush();
+            if(!out) throw std::runtime_error("SpillAggregator: unable to write run " + path);
+
+            for(std::size_t run = 0; run < FAN_IN; ++run)
+                std::remove(runs[run].c_str());
+            runs.erase(runs.begin() + 1, runs.begin() + FAN_IN);
+            runs.front() = path;
+
+        }
+
+        void RemoveRuns() {
+            for(const std::string & run : runs)
+                std::remove(run.c_str());
+            runs.clear();
+        }
+
+        std::size_t memoryBudget;
+        Combiner combine;
+        std::string directory;
+
+        std::unordered_map<std::string, Value> table;
+        std::size_t memoryUsed;
+        /* oldest first */
+        std::vector<std::string> runs;
+        std::size_t spilledBytes;
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file srcSAXTextUtilities.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_TEXT_UTILITIES_HPP
+#define INCLUDED_SRCSAX_TEXT_UTILITIES_HPP
+
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace srcSAXEventDispatch {
+
+    inline bool IsWhitespaceChar(char ch) {
+        return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r';
+    }
+
+    /**
+     * IsWhitespace
+     * @param text the characters
+     * @param len number of characters
+     *
+     * True if text consists only of XML whitespace (space, tab, CR, LF).
+     * Empty text counts as whitespace.  Uses SSE2 16 bytes at a time when
+     * available.
+     */
+    inline bool IsWhitespace(const char * text, std::size_t len) {
+
+        std::size_t pos = 0;
+
+#if defined(__SSE2__)
+        const __m128i space   = _mm_set1_epi8(' ');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i tab     = _mm_set1_epi8('\t');
+        const __m128i cr      = _mm_set1_epi8('\r');
+
+        for(; pos + 16 <= len; pos += 16) {
+
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+            __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, cr)));
+            if(_mm_movemask_epi8(match) != 0xFFFF)
+                return false;
+
+        }
+#endif
+
+        for(; pos < len; ++pos) {
+            if(!IsWhitespaceChar(text[pos]))
+                return false;
+        }
+
+        return true;
+
+    }
+
+    /**
+     * FindFirstOf
+     * @param text the characters
+     * @param len number of characters
+     * @param set characters to search for
+     *
+     * Index of the first character of text that is in set, or len if there
+     * is none.  Uses SSE2 16 bytes at a time when available.
+     */
+    template <std::size_t N>
+    inline std::size_t FindFirstOf(const char * text, std::size_t len, const char (&set)[N]) {
+
+        std::size_t pos = 0;
+
+#if defined(__SSE2__)
+        for(; pos + 16 <= len; pos += 16) {
+
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+            __m128i match = _mm_setzero_si128();
+            for(std::size_t i = 0; i < N - 1; ++i)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(set[i])));
+
+            int mask = _mm_movemask_epi8(match);
+            if(mask)
+                return pos + __builtin_ctz(mask);
+
+        }
+#endif
+
+        for(; pos < len; ++pos) {
+            for(std::size_t i = 0; i < N - 1; ++i)
+                if(text[pos] == set[i])
+                    return pos;
+        }
+
+        return len;
+
+    }
+
+    /**
+     * FindContentEscape
+     *
+     * First character that must be escaped in srcML element content.
+     * srcML does not escape '"' in content.
+     */
+    inline std::size_t FindContentEscape(const char * text, std::size_t len) {
+        return FindFirstOf(text, len, "<>&\r");
+    }
+
+    /**
+     * FindAttributeEscape
+     *
+     * First character that must be escaped in an attribute value.
+     */
+    inline std::size_t FindAttributeEscape(const char * text, std::size_t len) {
+        return FindFirstOf(text, len, "<>&\"\n\r\t");
+    }
+
+}
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file srcSAXUnitFilter.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SRCSAX_UNIT_FILTER_HPP
+#define INCLUDED_SRCSAX_UNIT_FILTER_HPP
+
+#include <srcSAXHandler.hpp>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <initializer_list>
+
+namespace srcSAXEventDispatch {
+
+    /**
+     * UnitFilter
+     *
+     * Pre-dispatch filter evaluated by the dispatcher at startUnit.
+     * A unit is accepted when its filename matches one of the include globs
+     * (or there are none), matches none of the exclude globs, and its
+     * language is in the language set (or the set is empty).
+     *
+     * Globs support '*' (any run of characters, including '/') and '?'.
+     *
+     * The maximum unit size applies to the unit's text.  The size is not
+     * known until the unit has been read, so the dispatcher buffers a unit
+     * (see UnitBuffer) and dispatches it at its close if it fits; a larger
+     * unit is dropped as soon as its text exceeds the maximum.
+     */
+    class UnitFilter {
+
+    public:
+
+        UnitFilter() : maxUnitSize(0) {}
+
+        UnitFilter & Include(std::initializer_list<std::string> globs) {
+            includeGlobs.insert(includeGlobs.end(), globs.begin(), globs.end());
+            return *this;
+        }
+
+        UnitFilter & Exclude(std::initializer_list<std::string> globs) {
+            excludeGlobs.insert(excludeGlobs.end(), globs.begin(), globs.end());
+            return *this;
+        }
+
+        UnitFilter & Languages(std::initializer_list<std::string> langs) {
+            languages.insert(langs.begin(), langs.end());
+            return *this;
+        }
+
+        UnitFilter & MaxUnitSize(std::size_t size) {
+            maxUnitSize = size;
+            return *this;
+        }
+
+        std::size_t GetMaxUnitSize() const { return maxUnitSize; }
+
+        bool Empty() const {
+            return includeGlobs.empty() && excludeGlobs.empty() && languages.empty() && !maxUnitSize;
+        }
+
+        bool Accept(const std::string & filename, const std::string & language) const {
+
+            if(!languages.empty() && languages.find(language) == languages.end())
+                return false;
+
+            if(!includeGlobs.empty()) {
+
+                bool included = false;
+                for(const std::string & glob : includeGlobs) {
+                    if(GlobMatch(glob.c_str(), filename.c_str())) {
+                        included = true;
+                        break;
+                    }
+                }
+
+                if(!included) return false;
+
+            }
+
+            for(const std::string & glob : excludeGlobs) {
+                if(GlobMatch(glob.c_str(), filename.c_str()))
+                    return false;
+            }
+
+            return true;
+
+        }
+
+        /**
+         * GlobMatch
+         * @param pattern glob with '*' and '?' wildcards
+         * @param str string to match
+         *
+         * Iterative wildcard match with single backtrack point.
+         */
+        static bool GlobMatch(const char * pattern, const char * str) {
+
+            const char * star = nullptr;
+            const char * resume = nullptr;
+
+            while(*str) {
+
+                if(*pattern == '*') {
+                    star = pattern++;
+                    resume = str;
+                } else if(*pattern == '?' || *pattern == *str) {
+                    ++pattern;
+                    ++str;
+                } else if(star) {
+                    pattern = star + 1;
+                    str = ++resume;
+                } else {
+                    return false;
+                }
+
+            }
+
+            while(*pattern == '*') ++pattern;
+
+            return !*pattern;
+
+        }
+
+    private:
+
+        std::vector<std::string> includeGlobs;
+        std::vector<std::string> excludeGlobs;
+        std::unordered_set<std::string> languages;
+        std::size_t maxUnitSize;
+
+    };
+
+    /**
+     * UnitBuffer
+     *
+     * The SAX callbacks of one unit, from its start tag on, with copies of
+     * their strings, so the unit can be replayed through a handler once it
+     * is known to be wanted.  Strings are kept in one pool and referred to
+     * by offset; pointers are only formed during Replay.
+     */
+    class UnitBuffer {
+
+    public:
+
+        UnitBuffer() : textSize(0) {}
+
+        void Start(const char * localname, const char * prefix, const char * URI,
+                   int num_namespaces, const struct srcsax_namespace * namespaces, int num_attributes,
+                   const struct srcsax_attribute * attributes) {
+
+            Event event = { Event::start, Add(localname), Add(prefix), Add(URI), num_namespaces, num_attributes, fields.size() };
+            for(int pos = 0; pos < num_namespaces; ++pos) {
+                fields.push_back(Add(namespaces[pos].prefix));
+                fields.push_back(Add(namespaces[pos].uri));
+            }
+            for(int pos = 0; pos < num_attributes; ++pos) {
+                fields.push_back(Add(attributes[pos].localname));
+                fields.push_back(Add(attributes[pos].prefix));
+                fields.push_back(Add(attributes[pos].uri));
+                fields.push_back(Add(attributes[pos].value));
+            }
+            events.push_back(event);
+
+        }
+
+        void Characters(const char * ch, int len) {
+            Event event = { Event::characters, strings.size(), npos, npos, 0, len, 0 };
+            strings.append(ch, len);
+            textSize += len;
+            events.push_back(event);
+        }
+
+        void End(const char * localname, const char * prefix, const char * URI) {
+            Event event = { Event::end, Add(localname), Add(prefix), Add(URI), 0, 0, 0 };
+            events.push_back(event);
+        }
+
+        /* characters buffered so far */
+        std::size_t TextSize() const { return textSize; }
+        bool Empty() const { return events.empty(); }
+
+        /**
+         * Replay
+         * @param handler handler to receive the unit
+         * @param stack srcSAX element stack as it was at the unit's start tag
+         *
+         * The first start is replayed as startUnit, the rest as startElement,
+         * charactersUnit and endElement.  The element stack is pushed and
+         * popped around them as srcSAX does.
+         */
+        void Replay(srcSAXHandler & handler, std::vector<std::string> & stack) const {
+
+            std::vector<srcsax_namespace> namespaces;
+            std::vector<srcsax_attribute> attributes;
+            for(std::vector<Event>::const_iterator event = events.begin(); event != events.end(); ++event) {
+
+                if(event->kind == Event::characters) {
+                    handler.charactersUnit(strings.data() + event->localname, event->count);
+                    continue;
+                }
+
+                if(event->kind == Event::end) {
+                    stack.pop_back();
+                    handler.endElement(String(event->localname), String(event->prefix), String(event->URI));
+                    continue;
+                }
+
+                namespaces.clear();
+                attributes.clear();
+                std::size_t field = event->first;
+                for(int pos = 0; pos < event->numNamespaces; ++pos, field += 2) {
+                    srcsax_namespace ns = { String(fields[field]), String(fields[field + 1]) };
+                    namespaces.push_back(ns);
+                }
+                for(int pos = 0; pos < event->count; ++pos, field += 4) {
+                    srcsax_attribute attribute = { String(fields[field]), String(fields[field + 1]), String(fields[field + 2]), String(fields[field + 3]) };
+                    attributes.push_back(attribute);
+                }
+
+                if(event == events.begin()) {
+                    handler.startUnit(String(event->localname), String(event->prefix), String(event->URI),
+                                      event->numNamespaces, namespaces.data(), event->count, attributes.data());
+                } else {
+                    stack.push_back(event->prefix == npos ? String(event->localname) : std::string(String(event->prefix)) + ':' + String(event->localname));
+                    handler.startElement(String(event->localname), String(event->prefix), String(event->URI),
+                                         event->numNamespaces, namespaces.data(), event->count, attributes.data());
+                }
+
+            }
+
+        }
+
+        void clear() {
+            events.clear();
+            fields.clear();
+            strings.clear();
+            textSize = 0;
+        }
+
+    private:
+
+        static const std::size_t npos = std::size_t(-1);
+
+        /* strings are pool offsets, npos for a null pointer; characters keep their offset in localname and length in count */
+        struct Event {
+            enum Kind { start, characters, end } kind;
+            std::size_t localname, prefix, URI;
+            /* attributes of a start */
+            int numNamespaces, count;
+            /* first namespace field; namespaces take two fields, attributes four */
+            std::size_t first;
+        };
+
+        std::size_t Add(const char * str) {
+            if(!str) return npos;
+            std::size_t offset = strings.size();
+            strings.append(str);
+            strings.push_back('\0');
+            return offset;
+        }
+        const char * String(std::size_t offset) const {
+            return offset == npos ? nullptr : strings.data() + offset;
+        }
+
+        std::vector<Event> events;
+        std::vector<std::size_t> fields;
+        std::string strings;
+        std::size_t textSize;
+
+    };
+
+}
+
+#endif
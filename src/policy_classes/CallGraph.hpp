@@ -0,0 +1,198 @@
+/**
+ * @file CallGraph.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_CALL_GRAPH_HPP
+#define INCLUDED_CALL_GRAPH_HPP
+
+#include <srcSAXInternTable.hpp>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * CallGraph
+ *
+ * Caller to callee edges between interned function names.  AddCall only
+ * records the pair; Build sorts the calls into compressed sparse row
+ * form, one row of distinct callees per caller and one of distinct
+ * callers per callee, with the number of calls on each edge.  Queries
+ * see the calls added up to the last Build, and run in time linear in
+ * what they visit.
+ */
+class CallGraph {
+
+    public:
+
+        static const unsigned int npos = srcSAXEventDispatch::InternTable::npos;
+
+        CallGraph() : built(true) {
+            Clear(out);
+            Clear(in);
+        }
+
+        void AddCall(const std::string & caller, const std::string & callee){
+            unsigned int from = nodes.Intern(caller), to = nodes.Intern(callee);
+            calls.push_back(std::make_pair(from, to));
+            built = false;
+        }
+
+        /* counting sort of the calls into the out and in rows */
+        void Build(){
+            if(built) return;
+            Fill(out, calls, false);
+            Fill(in, calls, true);
+            built = true;
+        }
+
+        std::size_t NumberNodes() const { return nodes.size(); }
+        /* distinct edges, as of the last Build */
+        std::size_t NumberEdges() const { return out.targets.size(); }
+
+        unsigned int Node(const std::string & name) const { return nodes.Find(name); }
+        const std::string & Name(unsigned int node) const { return nodes.Name(node); }
+
+        std::size_t FanOut(const std::string & function) const { return Degree(out, Node(function)); }
+        std::size_t FanIn(const std::string & function) const { return Degree(in, Node(function)); }
+        std::vector<std::string> Callees(const std::string & function) const { return Names(out, Node(function)); }
+        std::vector<std::string> Callers(const std::string & function) const { return Names(in, Node(function)); }
+        /* calls from caller to callee, 0 if none */
+        std::size_t Calls(const std::string & caller, const std::string & callee) const {
+            unsigned int from = Node(caller), to = Node(callee);
+            if(!InGraph(out, from) || to == npos) return 0;
+            std::vector<unsigned int>::const_iterator begin = out.targets.begin() + out.offsets[from], end = out.targets.begin() + out.offsets[from + 1];
+            std::vector<unsigned int>::const_iterator found = std::lower_bound(begin, end, to);
+            return found != end && *found == to ? out.weights[found - out.targets.begin()] : 0;
+        }
+
+        /**
+         * Reachable
+         * @param node start of the search
+         * @param reverse follow callers instead of callees
+         *
+         * The nodes reachable over one or more edges, in breadth-first
+         * order; node itself only if it is on a cycle.
+         */
+        std::vector<unsigned int> Reachable(unsigned int node, bool reverse = false) const {
+            const Rows & rows = reverse ? in : out;
+            std::vector<unsigned int> reached;
+            if(!InGraph(rows, node)) return reached;
+            std::vector<bool> seen(rows.offsets.size() - 1, false);
+            std::size_t next = 0;
+            Visit(rows, node, seen, reached);
+            while(next < reached.size()){
+                Visit(rows, reached[next++], seen, reached);
+            }
+            return reached;
+        }
+        std::vector<std::string> Reachable(const std::string & function, bool reverse = false) const {
+            std::vector<std::string> names;
+            for(unsigned int node : Reachable(Node(function), reverse)){
+                names.push_back(nodes.Name(node));
+            }
+            return names;
+        }
+
+        void clear(){
+            nodes.clear();
+            calls.clear();
+            Clear(out);
+            Clear(in);
+            built = true;
+        }
+
+    private:
+
+        /* row i is targets[offsets[i], offsets[i + 1]), sorted, with the calls on each edge in weights */
+        struct Rows {
+            std::vector<unsigned int> offsets, targets, weights;
+        };
+
+        static void Clear(Rows & rows){
+            rows.offsets.assign(1, 0);
+            rows.targets.clear();
+            rows.weights.clear();
+        }
+
+        void Fill(Rows & rows, const std::vector<std::pair<unsigned int, unsigned int>> & edges, bool reverse) const {
+
+            std::size_t numberNodes = nodes.size();
+            std::vector<unsigned int> start(numberNodes + 1, 0);
+            for(const std::pair<unsigned int, unsigned int> & edge : edges){
+                ++start[(reverse ? edge.second : edge.first) + 1];
+            }
+            for(std::size_t node = 0; node < numberNodes; ++node){
+                start[node + 1] += start[node];
+            }
+            std::vector<unsigned int> targets(edges.size()), position(start.begin(), start.end() - 1);
+            for(const std::pair<unsigned int, unsigned int> & edge : edges){
+                targets[position[reverse ? edge.second : edge.first]++] = reverse ? edge.first : edge.second;
+            }
+
+            //rows are sorted in place, then repeated targets folded into weights
+            rows.offsets.assign(1, 0);
+            rows.targets.clear();
+            rows.weights.clear();
+            for(std::size_t node = 0; node < numberNodes; ++node){
+                std::sort(targets.begin() + start[node], targets.begin() + start[node + 1]);
+                for(unsigned int target = start[node]; target < start[node + 1]; ++target){
+                    if(rows.targets.size() > rows.offsets.back() && rows.targets.back() == targets[target]){
+                        ++rows.weights.back();
+                    }else{
+                        rows.targets.push_back(targets[target]);
+                        rows.weights.push_back(1);
+                    }
+                }
+                rows.offsets.push_back(rows.targets.size());
+            }
+
+        }
+
+        static bool InGraph(const Rows & rows, unsigned int node){
+            return node != npos && node + 1 < rows.offsets.size();
+        }
+        static std::size_t Degree(const Rows & rows, unsigned int node){
+            return InGraph(rows, node) ? rows.offsets[node + 1] - rows.offsets[node] : 0;
+        }
+        std::vector<std::string> Names(const Rows & rows, unsigned int node) const {
+            std::vector<std::string> names;
+            if(!InGraph(rows, node)) return names;
+            for(unsigned int target = rows.offsets[node]; target < rows.offsets[node + 1]; ++target){
+                names.push_back(nodes.Name(rows.targets[target]));
+            }
+            return names;
+        }
+        static void Visit(const Rows & rows, unsigned int node, std::vector<bool> & seen, std::vector<unsigned int> & reached){
+            for(unsigned int target = rows.offsets[node]; target < rows.offsets[node + 1]; ++target){
+                if(!seen[rows.targets[target]]){
+                    seen[rows.targets[target]] = true;
+                    reached.push_back(rows.targets[target]);
+                }
+            }
+        }
+
+        srcSAXEventDispatch::InternTable nodes;
+        /* (caller, callee) as added */
+        std::vector<std::pair<unsigned int, unsigned int>> calls;
+        Rows out, in;
+        bool built;
+
+};
+
+#endif
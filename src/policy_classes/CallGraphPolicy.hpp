@@ -0,0 +1,168 @@
+/**
+ * @file CallGraphPolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_CALL_GRAPH_POLICY_HPP
+#define INCLUDED_CALL_GRAPH_POLICY_HPP
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <CallGraph.hpp>
+#include <FunctionCallPolicy.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * CallGraphPolicy
+ *
+ * Builds a CallGraph from the calls in function bodies: CallPolicy
+ * reports each outermost call with its nested calls, and every call in
+ * it becomes an edge from the enclosing function, named as
+ * FunctionSignaturePolicy reports it.  Nodes are unqualified names, and a
+ * callee is reduced to its last component (f of N::f, a.f and p->f), so
+ * overloads and same-named methods share a node.  Constructors and
+ * destructors, which FunctionSignaturePolicy does not report, are named
+ * from their own name element the same way (Foo, ~Foo).
+ *
+ * Listeners are notified with the built graph at archive close, or with
+ * each unit's part at unit close under FlushMode::unit.  Data returns a
+ * view valid during Notify; do not delete it.
+ */
+class CallGraphPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener {
+    public:
+        ~CallGraphPolicy(){}
+        CallGraphPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners){
+            callpolicy.AddListener(this);
+            signaturepolicy.AddListener(this);
+            InitializeEventHandlers();
+        }
+        void Reset() override {
+            EventListener::Reset();
+            callpolicy.Reset();
+            signaturepolicy.Reset();
+            graph.clear();
+            functions.clear();
+        }
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            if(policy == &signaturepolicy){
+                FunctionSignaturePolicy::SignatureData * signature = policy->Data<FunctionSignaturePolicy::SignatureData>();
+                //also sent for constructors and destructors, unnamed; they keep their own name
+                if(!functions.empty() && functions.back().name.empty()) functions.back().name = signature->name;
+                delete signature;
+                return;
+            }
+            CallPolicy::CallData * call = policy->Data<CallPolicy::CallData>();
+            if(!functions.empty() && !functions.back().name.empty()){
+                //each "(" is followed by the name of a call, nested calls included
+                bool callee = false;
+                for(const std::string & token : call->callargumentlist){
+                    if(callee && !token.empty()) graph.AddCall(functions.back().name, LastComponent(token));
+                    callee = token == "(";
+                }
+            }
+            delete call;
+        }
+        const CallGraph & Graph() const {
+            return graph;
+        }
+    protected:
+        void * DataInner() const override {
+            return (void *)&graph;
+        }
+    private:
+        struct Function{
+            Function() : nameDepth(0) {}
+            std::string name;
+            //depth of a constructor's or destructor's name element while it is open, 0 otherwise
+            std::size_t nameDepth;
+        };
+        CallPolicy callpolicy;
+        FunctionSignaturePolicy signaturepolicy;
+        CallGraph graph;
+        //enclosing functions, innermost last; "" until the name is seen
+        std::vector<Function> functions;
+
+        static std::string LastComponent(const std::string & name){
+            std::size_t scope = name.rfind("::"), member = name.rfind('.'), arrow = name.rfind("->");
+            std::size_t start = 0;
+            if(scope != std::string::npos) start = std::max(start, scope + 2);
+            if(member != std::string::npos) start = std::max(start, member + 1);
+            if(arrow != std::string::npos) start = std::max(start, arrow + 2);
+            return name.substr(start);
+        }
+
+        void InitializeEventHandlers(){
+            using namespace srcSAXEventDispatch;
+            //sub-policies are attached for the outermost function only, so nested functions do not add them twice
+            std::function<void(srcSAXEventContext&)> openFunction = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()){
+                    ctx.dispatcher->AddListenerDispatch(&signaturepolicy);
+                    ctx.dispatcher->AddListenerDispatch(&callpolicy);
+                }
+                functions.push_back(Function());
+            };
+            std::function<void(srcSAXEventContext&)> closeFunction = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()) return;
+                functions.pop_back();
+                if(functions.empty()){
+                    ctx.dispatcher->RemoveListenerDispatch(&callpolicy);
+                    ctx.dispatcher->RemoveListenerDispatch(&signaturepolicy);
+                }
+            };
+            openEventMap[ParserState::function] = openFunction;
+            openEventMap[ParserState::constructor] = openFunction;
+            openEventMap[ParserState::destructor] = openFunction;
+            closeEventMap[ParserState::function] = closeFunction;
+            closeEventMap[ParserState::constructor] = closeFunction;
+            closeEventMap[ParserState::destructor] = closeFunction;
+
+            //a constructor's or destructor's name: the tokens of the name directly under it, outside template arguments
+            openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || !functions.back().name.empty() || functions.back().nameDepth) return;
+                if(ctx.Parent(1) == ElementId::constructor || ctx.Parent(1) == ElementId::destructor) functions.back().nameDepth = ctx.depth;
+            };
+            closeEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || functions.back().nameDepth != ctx.depth) return;
+                functions.back().name = LastComponent(functions.back().name);
+                functions.back().nameDepth = 0;
+            };
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && functions.back().nameDepth && ctx.IsClosed(ParserState::genericargumentlist)) functions.back().name += ctx.currentToken;
+            };
+
+            closeEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx) {
+                //the document root closing leaves no unit open; source units have been flushed by then
+                if(flushMode == FlushMode::unit && ctx.triggerField[ParserState::unit]){
+                    graph.Build();
+                    NotifyAll(ctx);
+                    graph.clear();
+                }
+            };
+            closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx) {
+                if(flushMode == FlushMode::archive){
+                    graph.Build();
+                    NotifyAll(ctx);
+                }
+            };
+        }
+};
+
+#endif
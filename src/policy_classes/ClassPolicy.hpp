@@ -59,6 +59,15 @@ class ClassPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEven
             InitializeEventHandlers();
         }
 
+        void Reset() override {
+            EventListener::Reset();
+            funcSigPolicy->Reset();
+            declTypePolicy->Reset();
+            while(!data_stack.empty()) data_stack.pop();
+            data.clear();
+            gotClassName = true;
+        }
+
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
             if (typeid(FunctionSignaturePolicy) == typeid(*policy)) {
                 FunctionSignaturePolicy::SignatureData signatureData = *policy->Data<FunctionSignaturePolicy::SignatureData>();
@@ -102,6 +102,23 @@ public:
 
     }
 
+    void Reset() override {
+
+        EventListener::Reset();
+
+        if(namePolicy)     namePolicy->Reset();
+        if(declPolicy)     declPolicy->Reset();
+        if(functionPolicy) functionPolicy->Reset();
+        if(classPolicy)    classPolicy->Reset();
+
+        data = ClassData{};
+        classDepth = 0;
+        currentRegion = PUBLIC;
+
+        InitializeClassPolicyHandlers();
+
+    }
+
     void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
 
         if(typeid(NamePolicy) == typeid(*policy)) {
@@ -161,9 +178,9 @@ private:
                 classDepth = ctx.depth;
 
                 data = ClassData{};
-                if(ctx.elementStack.back() == "class")
+                if(ctx.Element() == ElementId::classn)
                     data.type = CLASS;
-                else if(ctx.elementStack.back() == "struct")
+                else if(ctx.Element() == ElementId::structn)
                     data.type = STRUCT;
 
                 data.name = nullptr;
@@ -19,11 +19,15 @@
  */
 #include <srcSAXEventDispatcher.hpp>
 #include <srcSAXHandler.hpp>
+#include <srcSAXBoundedMap.hpp>
+#include <srcSAXSpillAggregator.hpp>
 #include <exception>
 #include <SNLPolicy.hpp>
 #include <ExprPolicy.hpp>
 #include <StereotypePolicy.hpp>
 #include <stack>
+#include <memory>
+#include <sstream>
 
 #ifndef NLCONTEXTPOLICY
 #define NLCONTEXTPOLICY
@@ -51,15 +55,65 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
             std::string identifiername;
             std::list<NLSet> nlsetmap;
         };
-        std::map<std::string, std::string> identifierposmap;
+        //category of each declared identifier; in FlushMode::unit only the identifierCapacity most recently used are kept across units
+        srcSAXEventDispatch::BoundedMap<std::string, std::string> identifierposmap;
         NLContextData data;
         ~NLContextPolicy(){}
-        NLContextPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners){
+        NLContextPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners), identifierCapacity(1 << 16), spillBatchSize(0), sequence(0){
             sourcenlpolicy.AddListener(this);
             exprpolicy.AddListener(this);
             stereotypepolicy.AddListener(this);
             InitializeEventHandlers();
         }
+        void Reset() override {
+            EventListener::Reset();
+            sourcenlpolicy.Reset();
+            exprpolicy.Reset();
+            stereotypepolicy.Reset();
+            identifierposmap.clear();
+            if(declarations) declarations->Clear();
+            if(uses) uses->Clear();
+            if(matches) matches->Clear();
+            sequence = 0;
+            data.clear();
+            data.nlsetmap.clear();
+            stereotype.stereotypes.clear();
+            while(!context.empty()) context.pop();
+        }
+        void SetIdentifierCapacity(std::size_t capacity){
+            identifierCapacity = capacity;
+        }
+        /**
+         * SetSpill
+         * @param memoryBudget bytes the archive-wide tables may hold in memory, 0 to keep them in memory (the default)
+         * @param directory where spilled runs are written, empty for $TMPDIR or /tmp
+         * @param batchSize NLSets per notification at archive close, 0 for one notification
+         *
+         * For FlushMode::archive over archives too large to hold.  Declarations
+         * and uses are numbered in the order they are seen, aggregated by
+         * identifier in SpillAggregators and joined at archive close: a use
+         * takes the category of the declarations before it, as in memory,
+         * and the sets are put back in the order of their uses.  With the
+         * default batchSize the listeners see exactly what they would see
+         * without spilling; a batchSize splits the same sets over several
+         * notifications.
+         */
+        void SetSpill(std::size_t memoryBudget, const std::string & directory = "", std::size_t batchSize = 0){
+            if(!memoryBudget){
+                declarations.reset();
+                uses.reset();
+                matches.reset();
+                return;
+            }
+            srcSAXEventDispatch::SpillAggregator<std::string>::Combiner append = [](std::string & records, const std::string & other){
+                records += other;
+            };
+            declarations.reset(new srcSAXEventDispatch::SpillAggregator<std::string>(memoryBudget / 3, append, directory));
+            uses.reset(new srcSAXEventDispatch::SpillAggregator<std::string>(memoryBudget / 3, append, directory));
+            matches.reset(new srcSAXEventDispatch::SpillAggregator<std::string>(memoryBudget / 3, append, directory));
+            spillBatchSize = batchSize;
+            sequence = 0;
+        }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
             using namespace srcSAXEventDispatch;
             if(ctx.IsOpen(ParserState::declstmt) && ctx.IsClosed(ParserState::exprstmt)){
@@ -68,6 +122,10 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
                 if(!context.empty()){
                     top = context.top();
                 }
+                if(Spilling()){
+                    declarations->Add(sourcenlpdata.identifiername, std::to_string(sequence++) + '\t' + sourcenlpdata.category + '\n');
+                    return;
+                }
                 auto it = identifierposmap.find(sourcenlpdata.identifiername);
                 if(it == identifierposmap.end()){
                     identifierposmap.insert(std::make_pair(sourcenlpdata.identifiername, sourcenlpdata.category));
@@ -78,7 +136,7 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
                 }
                 //std::cerr<<"Def: "<<sourcenlpdata.identifiername<<std::endl;
             }else if(ctx.IsOpen(ParserState::exprstmt) && ctx.IsClosed(ParserState::declstmt)){
-                exprdata = *policy->Data<ExprPolicy::ExprDataSet>();
+                const ExprPolicy::ExprDataSet & exprdata = *policy->Data<ExprPolicy::ExprDataSet>();
                 std::string top;
                 if(!context.empty()){
                     top = context.top();
@@ -91,8 +149,12 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
                 }else{
                     stereo = "none";
                 }
-                for(auto deal : exprdata.dataset){
-                    auto it = identifierposmap.find(deal.second.nameofidentifier);
+                for(const ExprPolicy::ExprData & deal : exprdata){
+                    if(Spilling()){
+                        uses->Add(deal.nameofidentifier, std::to_string(sequence++) + '\t' + top + '\t' + stereo + '\n');
+                        continue;
+                    }
+                    auto it = identifierposmap.find(deal.nameofidentifier);
                     if(it != identifierposmap.end()){
                         std::string categorystr;
                         if(it->second.empty()){
@@ -100,7 +162,7 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
                         }else{
                             categorystr = it->second;
                         }
-                        NLSet nlset = NLSet(deal.second.nameofidentifier,categorystr,top,stereo);
+                        NLSet nlset = NLSet(deal.nameofidentifier,categorystr,top,stereo);
                         data.nlsetmap.push_back(nlset);
                     }
                 }
@@ -118,11 +180,90 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
         SourceNLPolicy sourcenlpolicy;
         SourceNLPolicy::SourceNLData sourcenlpdata;
         ExprPolicy exprpolicy;
-        ExprPolicy::ExprDataSet exprdata;
         StereotypePolicy stereotypepolicy;
         StereotypePolicy::StereotypeData stereotype;
         std::string currentTypeName, currentDeclName, currentModifier, currentSpecifier;
         std::stack<std::string> context;
+        std::size_t identifierCapacity;
+        //identifier -> "number\tcategory\n" and identifier -> "number\tcontext\tstereotype\n" records, when spilling;
+        //matches holds the joined sets by the number of their use
+        std::unique_ptr<srcSAXEventDispatch::SpillAggregator<std::string>> declarations, uses, matches;
+        std::size_t spillBatchSize;
+        //numbers declarations and uses in the order they are seen
+        unsigned long long sequence;
+        //in FlushMode::unit results are per unit and identifierposmap is already bounded
+        bool Spilling() const {
+            return declarations && flushMode == srcSAXEventDispatch::FlushMode::archive;
+        }
+        /* fixed width, so keys sort in number order */
+        static std::string SequenceKey(unsigned long long number){
+            static const char digits[] = "0123456789abcdef";
+            std::string key(16, '0');
+            for(std::size_t pos = 16; pos-- > 0 && number; number >>= 4){
+                key[pos] = digits[number & 0xf];
+            }
+            return key;
+        }
+        /* one identifier's uses, each with the category the declarations before it give, as identifierposmap would */
+        void Match(const std::string & identifier, const std::string & declared, const std::string & used){
+            std::istringstream declLines(declared), useLines(used);
+            std::string declNumber, category, useNumber, top, stereo, current;
+            bool haveDecl = std::getline(declLines, declNumber, '\t') && std::getline(declLines, category);
+            bool seen = false;
+            while(std::getline(useLines, useNumber, '\t') && std::getline(useLines, top, '\t') && std::getline(useLines, stereo)){
+                unsigned long long use = std::stoull(useNumber);
+                while(haveDecl && std::stoull(declNumber) < use){
+                    if(!seen) current = category;
+                    else if(current != category) current = "multiple";
+                    seen = true;
+                    haveDecl = std::getline(declLines, declNumber, '\t') && std::getline(declLines, category);
+                }
+                if(!seen) continue;
+                matches->Add(SequenceKey(use), identifier + '\t' + (current.empty() ? "none" : current) + '\t' + top + '\t' + stereo);
+            }
+        }
+        void JoinSpilled(const srcSAXEventDispatch::srcSAXEventContext & ctx){
+            {
+                std::unique_ptr<srcSAXEventDispatch::SpillAggregator<std::string>::Reader> declared = declarations->Read(), used = uses->Read();
+                std::string declKey, declRecords, useKey, useRecords;
+                bool haveDecl = declared->Next(declKey, declRecords);
+                bool haveUse = used->Next(useKey, useRecords);
+                while(haveDecl && haveUse){
+                    if(declKey < useKey){
+                        haveDecl = declared->Next(declKey, declRecords);
+                    }else if(useKey < declKey){
+                        haveUse = used->Next(useKey, useRecords);
+                    }else{
+                        Match(useKey, declRecords, useRecords);
+                        haveUse = used->Next(useKey, useRecords);
+                    }
+                }
+            }
+            declarations->Clear();
+            uses->Clear();
+
+            std::unique_ptr<srcSAXEventDispatch::SpillAggregator<std::string>::Reader> matched = matches->Read();
+            std::string number, set, name, category, top, stereo;
+            bool notified = false;
+            while(matched->Next(number, set)){
+                std::istringstream fields(set);
+                std::getline(fields, name, '\t');
+                std::getline(fields, category, '\t');
+                std::getline(fields, top, '\t');
+                std::getline(fields, stereo);
+                data.nlsetmap.push_back(NLSet(name, category, top, stereo));
+                if(data.nlsetmap.size() == spillBatchSize){
+                    NotifyAll(ctx);
+                    data.nlsetmap.clear();
+                    notified = true;
+                }
+            }
+            matched.reset();
+            if(!notified || !data.nlsetmap.empty()) NotifyAll(ctx);
+            data.nlsetmap.clear();
+            matches->Clear();
+            sequence = 0;
+        }
         void InitializeEventHandlers(){
             using namespace srcSAXEventDispatch;
             openEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx) {
@@ -170,8 +311,21 @@ class NLContextPolicy : public srcSAXEventDispatch::EventListener, public srcSAX
             closeEventMap[ParserState::ifstmt] = [this](srcSAXEventContext& ctx){
                 context.pop();
             };
+            openEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx){
+                identifierposmap.SetCapacity(flushMode == FlushMode::unit ? identifierCapacity : 0);
+            };
+            closeEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx){
+                //the document root closing leaves no unit open; source units have been flushed by then
+                if(flushMode == FlushMode::unit && ctx.triggerField[ParserState::unit]){
+                    NotifyAll(ctx);
+                    data.nlsetmap.clear();
+                }
+            };
             closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx){
-                NotifyAll(ctx);
+                if(flushMode == FlushMode::archive){
+                    if(Spilling()) JoinSpilled(ctx);
+                    else NotifyAll(ctx);
+                }
             };
 
         }
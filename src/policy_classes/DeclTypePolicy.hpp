@@ -32,6 +32,14 @@ class DeclTypePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+        void Reset() override {
+            EventListener::Reset();
+            data = DeclData();
+            currentTypeName.clear();
+            currentDeclName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+        }
     protected:
         void * DataInner() const override {
             return new DeclData(data);
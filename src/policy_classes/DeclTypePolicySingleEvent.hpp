@@ -84,6 +84,22 @@ public:
 
     }
 
+    void Reset() override {
+
+        EventListener::Reset();
+
+        if(typePolicy) typePolicy->Reset();
+        if(namePolicy) namePolicy->Reset();
+
+        data.clear();
+        declDepth = 0;
+        isStatic = false;
+        type.reset();
+
+        InitializeDeclTypePolicyHandlers();
+
+    }
+
 protected:
     void * DataInner() const override {
 
@@ -0,0 +1,332 @@
+/**
+ * @file DefUseIndex.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_DEF_USE_INDEX_HPP
+#define INCLUDED_DEF_USE_INDEX_HPP
+
+#include <srcSAXInternTable.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * DefUseIndex
+ *
+ * Definition and use lines of identifiers, keyed by (file, function,
+ * identifier); the function is "" outside any function.  File, function
+ * and identifier names are interned, and each line list is kept as
+ * varint-encoded zigzag deltas, so an entry costs a few bytes per line.
+ * Lines are kept in the order they were added, repeats of the previous
+ * line dropped.
+ *
+ * Save and Load write and read a binary image, so an index built in one
+ * pass can be queried later without parsing again.  Load throws
+ * std::runtime_error on a malformed image, checking each size it reads
+ * against what is left of the stream before allocating for it.
+ */
+class DefUseIndex {
+
+    public:
+
+        DefUseIndex() : postingBytes(0) {}
+
+        void AddDefinition(const std::string & file, const std::string & function, const std::string & identifier, unsigned int line){
+            Append(entries[Entry(file, function, identifier)].defs, line);
+        }
+        void AddUse(const std::string & file, const std::string & function, const std::string & identifier, unsigned int line){
+            Append(entries[Entry(file, function, identifier)].uses, line);
+        }
+
+        bool Contains(const std::string & file, const std::string & function, const std::string & identifier) const {
+            return Find(file, function, identifier) != nullptr;
+        }
+        /* lines defining identifier, in the order added; empty if not indexed */
+        std::vector<unsigned int> Definitions(const std::string & file, const std::string & function, const std::string & identifier) const {
+            const Postings * postings = Find(file, function, identifier);
+            return postings ? Decode(postings->defs) : std::vector<unsigned int>();
+        }
+        std::vector<unsigned int> Uses(const std::string & file, const std::string & function, const std::string & identifier) const {
+            const Postings * postings = Find(file, function, identifier);
+            return postings ? Decode(postings->uses) : std::vector<unsigned int>();
+        }
+        /* identifiers indexed in a function, in order of first appearance */
+        std::vector<std::string> Identifiers(const std::string & file, const std::string & function) const {
+            std::vector<std::string> names;
+            unsigned int fileId = files.Find(file), functionId = functions.Find(function);
+            if(fileId == srcSAXEventDispatch::InternTable::npos || functionId == srcSAXEventDispatch::InternTable::npos) return names;
+            std::unordered_map<std::uint64_t, std::vector<unsigned int>>::const_iterator scope = scopes.find(ScopeKey(fileId, functionId));
+            if(scope == scopes.end()) return names;
+            for(unsigned int entry : scope->second){
+                names.push_back(identifiers.Name(keys[entry].identifier));
+            }
+            return names;
+        }
+        /* functions with indexed identifiers in a file, in order of first appearance */
+        std::vector<std::string> Functions(const std::string & file) const {
+            std::vector<std::string> names;
+            unsigned int fileId = files.Find(file);
+            if(fileId == srcSAXEventDispatch::InternTable::npos) return names;
+            for(const Key & key : scopeOrder){
+                if(key.file == fileId) names.push_back(functions.Name(key.function));
+            }
+            return names;
+        }
+
+        std::size_t size() const { return keys.size(); }
+        bool empty() const { return keys.empty(); }
+        /* bytes held by the encoded line lists */
+        std::size_t PostingBytes() const { return postingBytes; }
+
+        void clear(){
+            files.clear();
+            functions.clear();
+            identifiers.clear();
+            keys.clear();
+            entries.clear();
+            index.clear();
+            scopes.clear();
+            scopeOrder.clear();
+            postingBytes = 0;
+        }
+
+        void Save(std::ostream & out) const {
+            out.write(Magic(), 4);
+            WriteVarint(out, Version);
+            SaveNames(out, files);
+            SaveNames(out, functions);
+            SaveNames(out, identifiers);
+            WriteVarint(out, keys.size());
+            for(std::size_t entry = 0; entry < keys.size(); ++entry){
+                WriteVarint(out, keys[entry].file);
+                WriteVarint(out, keys[entry].function);
+                WriteVarint(out, keys[entry].identifier);
+                SaveList(out, entries[entry].defs);
+                SaveList(out, entries[entry].uses);
+            }
+            if(!out) throw std::runtime_error("DefUseIndex: unable to write index");
+        }
+
+        /* replaces the contents */
+        void Load(std::istream & in){
+            clear();
+            char magic[4];
+            if(!in.read(magic, 4) || std::string(magic, 4) != Magic())
+                throw std::runtime_error("DefUseIndex: not an index");
+            if(ReadVarint(in) != Version) throw std::runtime_error("DefUseIndex: unsupported index version");
+            std::uint64_t end = End(in);
+            std::vector<std::string> fileNames = LoadNames(in, end), functionNames = LoadNames(in, end), identifierNames = LoadNames(in, end);
+            //three ids and two lists of two sizes each
+            std::uint64_t count = ReadSize(in, end, 7);
+            for(std::uint64_t entry = 0; entry < count; ++entry){
+                std::uint64_t file = ReadVarint(in), function = ReadVarint(in), identifier = ReadVarint(in);
+                if(file >= fileNames.size() || function >= functionNames.size() || identifier >= identifierNames.size())
+                    throw std::runtime_error("DefUseIndex: corrupt index");
+                Postings & postings = entries[Entry(fileNames[file], functionNames[function], identifierNames[identifier])];
+                LoadList(in, end, postings.defs);
+                LoadList(in, end, postings.uses);
+            }
+        }
+
+    private:
+
+        struct Key {
+            unsigned int file, function, identifier;
+            bool operator==(const Key & other) const {
+                return file == other.file && function == other.function && identifier == other.identifier;
+            }
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key & key) const {
+                return std::hash<std::uint64_t>()((std::uint64_t(key.file) << 42) ^ (std::uint64_t(key.function) << 21) ^ key.identifier);
+            }
+        };
+        struct LineList {
+            LineList() : count(0), last(0) {}
+            std::vector<unsigned char> bytes;
+            std::size_t count;
+            unsigned int last;
+        };
+        struct Postings {
+            LineList defs, uses;
+        };
+
+        static const char * Magic() { return "DUIX"; }
+        static const std::uint64_t Version = 1;
+
+        static std::uint64_t ScopeKey(unsigned int file, unsigned int function){
+            return (std::uint64_t(file) << 32) | function;
+        }
+
+        /* the index of the entry for (file, function, identifier), added if new */
+        std::size_t Entry(const std::string & file, const std::string & function, const std::string & identifier){
+            Key key = { files.Intern(file), functions.Intern(function), identifiers.Intern(identifier) };
+            std::pair<std::unordered_map<Key, std::size_t, KeyHash>::iterator, bool> found = index.insert(std::make_pair(key, keys.size()));
+            if(found.second){
+                keys.push_back(key);
+                entries.push_back(Postings());
+                std::vector<unsigned int> & scope = scopes[ScopeKey(key.file, key.function)];
+                if(scope.empty()){
+                    Key scopeKey = { key.file, key.function, 0 };
+                    scopeOrder.push_back(scopeKey);
+                }
+                scope.push_back(found.first->second);
+            }
+            return found.first->second;
+        }
+
+        const Postings * Find(const std::string & file, const std::string & function, const std::string & identifier) const {
+            Key key = { files.Find(file), functions.Find(function), identifiers.Find(identifier) };
+            if(key.file == srcSAXEventDispatch::InternTable::npos || key.function == srcSAXEventDispatch::InternTable::npos
+               || key.identifier == srcSAXEventDispatch::InternTable::npos) return nullptr;
+            std::unordered_map<Key, std::size_t, KeyHash>::const_iterator found = index.find(key);
+            return found == index.end() ? nullptr : &entries[found->second];
+        }
+
+        void Append(LineList & list, unsigned int line){
+            if(list.count && list.last == line) return;
+            std::int64_t delta = std::int64_t(line) - list.last;
+            std::uint64_t zigzag = delta < 0 ? ((std::uint64_t(-delta) << 1) - 1) : (std::uint64_t(delta) << 1);
+            std::size_t before = list.bytes.size();
+            do {
+                unsigned char byte = zigzag & 0x7f;
+                zigzag >>= 7;
+                list.bytes.push_back(zigzag ? byte | 0x80 : byte);
+            } while(zigzag);
+            postingBytes += list.bytes.size() - before;
+            list.last = line;
+            ++list.count;
+        }
+
+        static std::vector<unsigned int> Decode(const LineList & list){
+            std::vector<unsigned int> lines;
+            lines.reserve(list.count);
+            std::int64_t line = 0;
+            std::size_t position = 0;
+            while(position < list.bytes.size()){
+                std::uint64_t zigzag = 0;
+                for(unsigned int shift = 0; ; shift += 7){
+                    if(position == list.bytes.size() || shift >= 64) throw std::runtime_error("DefUseIndex: corrupt index");
+                    unsigned char byte = list.bytes[position++];
+                    zigzag |= std::uint64_t(byte & 0x7f) << shift;
+                    if(!(byte & 0x80)) break;
+                }
+                line += (zigzag & 1) ? -std::int64_t((zigzag + 1) >> 1) : std::int64_t(zigzag >> 1);
+                lines.push_back(line);
+            }
+            return lines;
+        }
+
+        static void WriteVarint(std::ostream & out, std::uint64_t value){
+            do {
+                unsigned char byte = value & 0x7f;
+                value >>= 7;
+                out.put(value ? byte | 0x80 : byte);
+            } while(value);
+        }
+        static std::uint64_t ReadVarint(std::istream & in){
+            std::uint64_t value = 0;
+            for(unsigned int shift = 0; shift < 64; shift += 7){
+                int byte = in.get();
+                if(byte == std::char_traits<char>::eof()) throw std::runtime_error("DefUseIndex: truncated index");
+                value |= std::uint64_t(byte & 0x7f) << shift;
+                if(!(byte & 0x80)) return value;
+            }
+            throw std::runtime_error("DefUseIndex: corrupt index");
+        }
+        /* offset of the end of the stream, or the largest offset if it cannot seek */
+        static std::uint64_t End(std::istream & in){
+            std::istream::pos_type here = in.tellg();
+            if(here == std::istream::pos_type(-1)) return std::numeric_limits<std::uint64_t>::max();
+            std::istream::pos_type end = in.seekg(0, std::ios::end).tellg();
+            in.clear();
+            in.seekg(here);
+            return end == std::istream::pos_type(-1) ? std::numeric_limits<std::uint64_t>::max() : std::uint64_t(end);
+        }
+        /* a size of things taking at least unit bytes each, checked against what is left before end */
+        static std::uint64_t ReadSize(std::istream & in, std::uint64_t end, std::uint64_t unit){
+            std::uint64_t size = ReadVarint(in);
+            std::istream::pos_type here = in.tellg();
+            std::uint64_t left = here == std::istream::pos_type(-1) ? end : end - std::min(end, std::uint64_t(here));
+            if(size > left / unit) throw std::runtime_error("DefUseIndex: corrupt index");
+            return size;
+        }
+        /* size bytes read in bounded chunks, so a stream that cannot seek runs out before a bad size is allocated */
+        template<typename Bytes>
+        static void ReadBytes(std::istream & in, std::uint64_t size, Bytes & bytes){
+            bytes.clear();
+            while(size){
+                std::size_t chunk = std::min<std::uint64_t>(size, 1 << 16), at = bytes.size();
+                bytes.resize(at + chunk);
+                if(!in.read((char *)&bytes[at], chunk)) throw std::runtime_error("DefUseIndex: truncated index");
+                size -= chunk;
+            }
+        }
+
+        static void SaveNames(std::ostream & out, const srcSAXEventDispatch::InternTable & names){
+            WriteVarint(out, names.size());
+            for(std::size_t id = 0; id < names.size(); ++id){
+                WriteVarint(out, names.Name(id).size());
+                out.write(names.Name(id).data(), names.Name(id).size());
+            }
+        }
+        static std::vector<std::string> LoadNames(std::istream & in, std::uint64_t end){
+            std::vector<std::string> names;
+            for(std::uint64_t count = ReadSize(in, end, 1); count; --count){
+                names.push_back(std::string());
+                ReadBytes(in, ReadSize(in, end, 1), names.back());
+            }
+            return names;
+        }
+
+        static void SaveList(std::ostream & out, const LineList & list){
+            WriteVarint(out, list.count);
+            WriteVarint(out, list.bytes.size());
+            out.write((const char *)list.bytes.data(), list.bytes.size());
+        }
+        void LoadList(std::istream & in, std::uint64_t end, LineList & list){
+            list.count = ReadVarint(in);
+            ReadBytes(in, ReadSize(in, end, 1), list.bytes);
+            //a line takes at least a byte
+            if(list.count > list.bytes.size()) throw std::runtime_error("DefUseIndex: corrupt index");
+            std::vector<unsigned int> lines = Decode(list);
+            if(lines.size() != list.count) throw std::runtime_error("DefUseIndex: corrupt index");
+            list.last = lines.empty() ? 0 : lines.back();
+            postingBytes += list.bytes.size();
+        }
+
+        srcSAXEventDispatch::InternTable files, functions, identifiers;
+        /* entry i is (keys[i], entries[i]) */
+        std::vector<Key> keys;
+        std::vector<Postings> entries;
+        std::unordered_map<Key, std::size_t, KeyHash> index;
+        /* entries of each (file, function), and the (file, function) pairs in order of first appearance */
+        std::unordered_map<std::uint64_t, std::vector<unsigned int>> scopes;
+        std::vector<Key> scopeOrder;
+        std::size_t postingBytes;
+
+};
+
+#endif
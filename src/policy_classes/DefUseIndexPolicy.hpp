@@ -0,0 +1,184 @@
+/**
+ * @file DefUseIndexPolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_DEF_USE_INDEX_POLICY_HPP
+#define INCLUDED_DEF_USE_INDEX_POLICY_HPP
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <DefUseIndex.hpp>
+#include <ExprPolicy.hpp>
+#include <DeclTypePolicy.hpp>
+#include <ParamTypePolicy.hpp>
+#include <vector>
+
+/**
+ * DefUseIndexPolicy
+ *
+ * Builds a DefUseIndex in one pass: identifiers of expression
+ * statements (ExprPolicy), declarations (DeclTypePolicy) and parameters
+ * (ParamTypePolicy) are recorded under the unit's file and the enclosing
+ * function.  A declaration or parameter counts as a definition.  The
+ * function is the name element of the function, constructor or
+ * destructor as written, qualification included; "" outside any
+ * function.
+ *
+ * Listeners are notified with the index at archive close, or with each
+ * unit's part at unit close under FlushMode::unit.  Data returns a view
+ * of the index valid during Notify; do not delete it.  Index() gives the
+ * index after parsing, e.g. to Save it.
+ */
+class DefUseIndexPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener {
+    public:
+        ~DefUseIndexPolicy(){}
+        DefUseIndexPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners){
+            exprpolicy.AddListener(this);
+            decltypepolicy.AddListener(this);
+            paramtypepolicy.AddListener(this);
+            InitializeEventHandlers();
+        }
+        void Reset() override {
+            EventListener::Reset();
+            exprpolicy.Reset();
+            decltypepolicy.Reset();
+            paramtypepolicy.Reset();
+            index.clear();
+            functions.clear();
+        }
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            const std::string & function = functions.empty() ? NoFunction() : functions.back().name;
+            if(policy == &exprpolicy){
+                const ExprPolicy::ExprDataSet & exprdata = *policy->Data<ExprPolicy::ExprDataSet>();
+                for(const ExprPolicy::ExprData & entry : exprdata){
+                    for(unsigned int line : entry.def){
+                        index.AddDefinition(ctx.currentFilePath, function, entry.nameofidentifier, line);
+                    }
+                    for(unsigned int line : entry.use){
+                        index.AddUse(ctx.currentFilePath, function, entry.nameofidentifier, line);
+                    }
+                }
+            }else{
+                DeclData * decldata = policy->Data<DeclData>();
+                if(!decldata->nameofidentifier.empty()){
+                    index.AddDefinition(ctx.currentFilePath, function, decldata->nameofidentifier, decldata->linenumber);
+                }
+                delete decldata;
+            }
+        }
+        const DefUseIndex & Index() const {
+            return index;
+        }
+    protected:
+        void * DataInner() const override {
+            return (void *)&index;
+        }
+    private:
+        struct Function{
+            Function() : nameDepth(0), inBody(false), inParameters(false) {}
+            std::string name;
+            //depth of the function's own name element while it is open, 0 otherwise
+            std::size_t nameDepth;
+            bool inBody, inParameters;
+        };
+        static const std::string & NoFunction(){
+            static const std::string none;
+            return none;
+        }
+        ExprPolicy exprpolicy;
+        DeclTypePolicy decltypepolicy;
+        ParamTypePolicy paramtypepolicy;
+        DefUseIndex index;
+        //enclosing functions, innermost last
+        std::vector<Function> functions;
+        void InitializeEventHandlers(){
+            using namespace srcSAXEventDispatch;
+            //sub-policies are attached for the outermost statement only, so nested statements do not add them twice
+            openEventMap[ParserState::exprstmt] = [this](srcSAXEventContext& ctx) {
+                if(ctx.triggerField[ParserState::exprstmt] == 1) ctx.dispatcher->AddListenerDispatch(&exprpolicy);
+            };
+            closeEventMap[ParserState::exprstmt] = [this](srcSAXEventContext& ctx) {
+                if(ctx.triggerField[ParserState::exprstmt] == 1) ctx.dispatcher->RemoveListenerDispatch(&exprpolicy);
+            };
+            openEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx) {
+                if(ctx.triggerField[ParserState::declstmt] == 1) ctx.dispatcher->AddListenerDispatch(&decltypepolicy);
+            };
+            closeEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx) {
+                if(ctx.triggerField[ParserState::declstmt] == 1) ctx.dispatcher->RemoveListenerDispatch(&decltypepolicy);
+            };
+            //only a function's own parameters; those of declarations and lambdas define nothing here
+            openEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && !functions.back().inBody && !functions.back().inParameters){
+                    functions.back().inParameters = true;
+                    ctx.dispatcher->AddListenerDispatch(&paramtypepolicy);
+                }
+            };
+            closeEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && functions.back().inParameters && ctx.triggerField[ParserState::parameterlist] == 1){
+                    functions.back().inParameters = false;
+                    ctx.dispatcher->RemoveListenerDispatch(&paramtypepolicy);
+                }
+            };
+
+            std::function<void(srcSAXEventContext&)> openFunction = [this](srcSAXEventContext& ctx) {
+                functions.push_back(Function());
+            };
+            std::function<void(srcSAXEventContext&)> closeFunction = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty()) functions.pop_back();
+            };
+            openEventMap[ParserState::function] = openFunction;
+            openEventMap[ParserState::constructor] = openFunction;
+            openEventMap[ParserState::destructor] = openFunction;
+            closeEventMap[ParserState::function] = closeFunction;
+            closeEventMap[ParserState::constructor] = closeFunction;
+            closeEventMap[ParserState::destructor] = closeFunction;
+            openEventMap[ParserState::functionblock] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty()) functions.back().inBody = true;
+            };
+            //the function's name: the tokens of the name directly under it, outside template arguments
+            openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || functions.back().inBody || functions.back().nameDepth) return;
+                if(ctx.Parent(1) == ElementId::function || ctx.Parent(1) == ElementId::constructor || ctx.Parent(1) == ElementId::destructor){
+                    functions.back().name.clear();
+                    functions.back().nameDepth = ctx.depth;
+                }
+            };
+            closeEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && functions.back().nameDepth == ctx.depth) functions.back().nameDepth = 0;
+            };
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || !functions.back().nameDepth) return;
+                if(ctx.IsClosed(ParserState::genericargumentlist)) functions.back().name += ctx.currentToken;
+            };
+
+            closeEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx) {
+                //the document root closing leaves no unit open; source units have been flushed by then
+                if(flushMode == FlushMode::unit && ctx.triggerField[ParserState::unit]){
+                    NotifyAll(ctx);
+                    index.clear();
+                }
+            };
+            closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx) {
+                if(flushMode == FlushMode::archive){
+                    NotifyAll(ctx);
+                }
+            };
+        }
+};
+
+#endif
@@ -19,13 +19,15 @@
  */
 #include <srcSAXEventDispatcher.hpp>
 #include <srcSAXHandler.hpp>
+#include <srcSAXInternTable.hpp>
+#include <srcSAXSmallSortedSet.hpp>
 #include <exception>
-#include <set>
 #include <vector>
 #ifndef EXPRPOLICY
 #define EXPRPOLICY
 class ExprPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener {
     public:
+        typedef srcSAXEventDispatch::SmallSortedSet<unsigned int> LineSet;
         struct ExprData{
             ExprData() {}
             void clear(){
@@ -33,43 +35,95 @@ class ExprPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEvent
                use.clear();
             }
             std::string nameofidentifier;
-            std::set<unsigned int> def;
-            std::set<unsigned int> use; //could be used multiple times in same expr
+            LineSet def;
+            LineSet use; //could be used multiple times in same expr
         };
+        /**
+         * ExprDataSet
+         *
+         * The identifiers of one expr_stmt in order of first appearance.
+         * Only the entries are kept here, so a copy costs what the statement
+         * holds; the policy finds an entry by interned identifier id
+         * through its own table.
+         */
         struct ExprDataSet{
+           typedef std::vector<ExprData>::const_iterator const_iterator;
            ExprDataSet() = default;
-           ExprDataSet(std::map<std::string, ExprData> dat){
-            dataset = dat;
+           const ExprData * find(const std::string & name) const {
+            for(const ExprData & entry : dataset){
+                if(entry.nameofidentifier == name) return &entry;
+            }
+            return nullptr;
            }
+           const_iterator begin() const { return dataset.begin(); }
+           const_iterator end() const { return dataset.end(); }
+           std::size_t size() const { return dataset.size(); }
+           bool empty() const { return dataset.empty(); }
            void clear(){
             dataset.clear();
            }
-           std::map<std::string, ExprData> dataset;
+           std::vector<ExprData> dataset;
         };
-        std::map<std::string, ExprData> dataset;
         ~ExprPolicy(){}
         ExprPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners){
             seenAssignment = false;
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+        void Reset() override {
+            EventListener::Reset();
+            Clear();
+            identifiers.clear();
+            currentLine.clear();
+            currentTypeName.clear();
+            currentExprName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+            seenAssignment = false;
+        }
     protected:
+        /* a view of the statement's set, valid during Notify; copy it to keep it, do not delete it */
         void * DataInner() const override {
-            return new ExprDataSet(dataset);
+            return (void *)&dataset;
         }
     private:
-        ExprData data;
+        //identifiers are interned per policy; the table is dropped between statements once it grows past this
+        static const std::size_t MaxIdentifiers = 1 << 16;
+        ExprDataSet dataset;
+        srcSAXEventDispatch::InternTable identifiers;
+        //entry index + 1 in dataset by interned id, 0 for none; ids are those set
+        std::vector<unsigned int> slots, ids;
         std::string currentTypeName, currentExprName, currentModifier, currentSpecifier;
         std::vector<unsigned int> currentLine;
         bool seenAssignment;
+        /* the statement's entry for an interned id, nullptr if it has none */
+        ExprData * Find(unsigned int id){
+            return id < slots.size() && slots[id] ? &dataset.dataset[slots[id] - 1] : nullptr;
+        }
+        ExprData & Insert(unsigned int id, const std::string & name){
+            if(id >= slots.size()) slots.resize(id + 1, 0);
+            dataset.dataset.push_back(ExprData());
+            dataset.dataset.back().nameofidentifier = name;
+            ids.push_back(id);
+            slots[id] = dataset.size();
+            return dataset.dataset.back();
+        }
+        void Clear(){
+            for(unsigned int id : ids){
+                slots[id] = 0;
+            }
+            ids.clear();
+            dataset.clear();
+        }
         void InitializeEventHandlers(){
             using namespace srcSAXEventDispatch;
             closeEventMap[ParserState::op] = [this](srcSAXEventContext& ctx){
                 if(ctx.currentToken == "="){
-                    auto it = dataset.find(currentExprName);
-                    if(it != dataset.end()){
-                        it->second.use.erase(currentLine.back());
-                        it->second.def.insert(currentLine.back());
+                    unsigned int id = identifiers.Find(currentExprName);
+                    ExprData * entry = id == srcSAXEventDispatch::InternTable::npos ? nullptr : Find(id);
+                    if(entry){
+                        entry->use.erase(currentLine.back());
+                        entry->def.insert(currentLine.back());
                     }else{
                         std::cerr<<"No such thing as: "<<currentExprName<<std::endl;
                     }
@@ -85,14 +139,12 @@ class ExprPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEvent
                     currentLine.push_back(ctx.currentLineNumber);
                 }
                 if(ctx.IsOpen({ParserState::exprstmt})){
-                    auto it = dataset.find(currentExprName);
-                    if(it != dataset.end()){
-                        it->second.use.insert(currentLine.back()); //assume it's a use
-                    }else{
-                        data.nameofidentifier = currentExprName;
-                        data.use.insert(currentLine.back());
-                        dataset.insert(std::make_pair(currentExprName, data));
+                    unsigned int id = identifiers.Intern(currentExprName);
+                    ExprData * entry = Find(id);
+                    if(!entry){
+                        entry = &Insert(id, currentExprName);
                     }
+                    entry->use.insert(currentLine.back()); //assume it's a use
                 }
             };
 
@@ -118,8 +170,11 @@ class ExprPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEvent
                 currentLine.pop_back();
                 seenAssignment = false;
                 currentLine.clear();
-                dataset.clear();
-                data.clear();
+                Clear();
+                if(identifiers.size() > MaxIdentifiers){
+                    identifiers.clear();
+                    std::vector<unsigned int>().swap(slots);
+                }
             };
 
         }
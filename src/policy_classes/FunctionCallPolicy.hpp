@@ -48,6 +48,11 @@ class CallPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEvent
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+        void Reset() override {
+            EventListener::Reset();
+            data.clear();
+            fullFuncIdentifier.clear();
+        }
     protected:
         void * DataInner() const override {
             return new CallData(data);
@@ -132,6 +132,22 @@ public:
 
     }
 
+    void Reset() override {
+
+        EventListener::Reset();
+
+        if(typePolicy)     typePolicy->Reset();
+        if(namePolicy)     namePolicy->Reset();
+        if(paramPolicy)    paramPolicy->Reset();
+        if(declstmtPolicy) declstmtPolicy->Reset();
+
+        data = FunctionData{};
+        functionDepth = 0;
+
+        InitializeFunctionPolicyHandlers();
+
+    }
+
 protected:
     void * DataInner() const override {
 
@@ -180,16 +196,16 @@ private:
                 functionDepth = ctx.depth;
                 data = FunctionData{};
 
-                if(ctx.elementStack.back() == "function" || ctx.elementStack.back() == "function_decl") {
+                if(ctx.Element() == ElementId::function || ctx.Element() == ElementId::function_decl) {
 
                     if(ctx.isOperator)
                         data.type = OPERATOR;
                     else
                         data.type = FUNCTION;
 
-                } else if(ctx.elementStack.back() == "constructor" || ctx.elementStack.back() == "constructor_decl") {
+                } else if(ctx.Element() == ElementId::constructor || ctx.Element() == ElementId::constructor_decl) {
                     data.type = CONSTRUCTOR;
-                } else if(ctx.elementStack.back() == "destructor" || ctx.elementStack.back() == "destructor_decl") {
+                } else if(ctx.Element() == ElementId::destructor || ctx.Element() == ElementId::destructor_decl) {
                     data.type = DESTURCTOR;
                 }
 
@@ -62,6 +62,17 @@ class FunctionSignaturePolicy : public srcSAXEventDispatch::EventListener, publi
             parampolicy.AddListener(this);
             InitializeEventHandlers();
         }
+        void Reset() override {
+            EventListener::Reset();
+            parampolicy.Reset();
+            data.clear();
+            seenModifier = false;
+            currentArgPosition = 1;
+            currentTypeName.clear();
+            currentDeclName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+        }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
             paramdata = policy->Data<DeclData>();
             data.parameters.push_back(*paramdata);
@@ -126,6 +126,20 @@ public:
 
     }
 
+    void Reset() override {
+
+        EventListener::Reset();
+
+        if(namePolicy)             namePolicy->Reset();
+        if(templateArgumentPolicy) templateArgumentPolicy->Reset();
+
+        data = NameData{};
+        nameDepth = 0;
+
+        InitializeNamePolicyHandlers();
+
+    }
+
 protected:
     void * DataInner() const override {
 
@@ -161,15 +175,12 @@ private:
                 nameDepth = ctx.depth;
                 data = NameData{};
 
+                SetDepthAnchor(nameDepth);
+                CollectTokenHandlers();
+                CollectNameHandlers();
                 CollectTemplateArgumentsHandlers();
                 CollectArrayIndicesHandlers();
 
-            } else if((nameDepth + 1) == ctx.depth) {
-
-                NopCloseEvents({ParserState::tokenstring});
-                if(!namePolicy) namePolicy = new NamePolicy{this};
-                ctx.dispatcher->AddListenerDispatch(namePolicy); 
-
             }
 
         };
@@ -182,103 +193,98 @@ private:
                 nameDepth = 0;
  
                 NotifyAll(ctx);
+                ClearDepthEvents();
                 InitializeNamePolicyHandlers();
 
             }
            
         };
 
-        closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+    }
 
-            if(nameDepth && nameDepth == ctx.depth) {
+    void CollectTokenHandlers() {
+        using namespace srcSAXEventDispatch;
 
-                data.name += ctx.currentToken;
+        CloseEventAtDepth(ParserState::tokenstring, 0, [this](srcSAXEventContext& ctx) {
 
-            }
+            data.name += ctx.currentToken;
 
-        };
+        });
 
     }
 
-    void CollectTemplateArgumentsHandlers() {
+    void CollectNameHandlers() {
         using namespace srcSAXEventDispatch;
 
-        openEventMap[ParserState::genericargumentlist] = [this](srcSAXEventContext& ctx) {
-
-            if(nameDepth && (nameDepth + 1) == ctx.depth) {
+        OpenEventAtDepth(ParserState::name, 1, [this](srcSAXEventContext& ctx) {
 
-                openEventMap[ParserState::argument] = [this](srcSAXEventContext& ctx) {
+            NopCloseEvents({ParserState::tokenstring});
+            RemoveCloseEventAtDepth(ParserState::tokenstring, 0);
+            if(!namePolicy) namePolicy = new NamePolicy{this};
+            ctx.dispatcher->AddListenerDispatch(namePolicy); 
 
-                    if(nameDepth && (nameDepth + 2) == ctx.depth) {
+        });
 
-                        if(!templateArgumentPolicy) templateArgumentPolicy = new TemplateArgumentPolicy{this};
-                        ctx.dispatcher->AddListenerDispatch(templateArgumentPolicy);
+    }
 
-                    }
+    void CollectTemplateArgumentsHandlers() {
+        using namespace srcSAXEventDispatch;
 
-                };
+        OpenEventAtDepth(ParserState::genericargumentlist, 1, [this](srcSAXEventContext& ctx) {
 
-            }
+            OpenEventAtDepth(ParserState::argument, 2, [this](srcSAXEventContext& ctx) {
 
-        };
+                if(!templateArgumentPolicy) templateArgumentPolicy = new TemplateArgumentPolicy{this};
+                ctx.dispatcher->AddListenerDispatch(templateArgumentPolicy);
 
-        closeEventMap[ParserState::genericargumentlist] = [this](srcSAXEventContext& ctx) {
+            });
 
-            if(nameDepth && (nameDepth + 1) == ctx.depth) {
+        });
 
-                NopOpenEvents({ParserState::argument});
+        CloseEventAtDepth(ParserState::genericargumentlist, 1, [this](srcSAXEventContext& ctx) {
 
-            }
+            RemoveOpenEventAtDepth(ParserState::argument, 2);
 
-        };
+        });
 
     }
 
     void CollectArrayIndicesHandlers() {
         using namespace srcSAXEventDispatch;
 
-        openEventMap[ParserState::index] = [this](srcSAXEventContext& ctx) {
+        OpenEventAtDepth(ParserState::index, 1, [this](srcSAXEventContext& ctx) {
 
-            if(nameDepth && (nameDepth + 1) == ctx.depth) {
+            data.arrayIndices.push_back(std::string());
 
-                data.arrayIndices.push_back(std::string());
+        });
 
-            }
+        CloseEventAtDepth(ParserState::index, 1, [this](srcSAXEventContext& ctx) {
 
-        };
+            RemoveOpenEventAtDepth(ParserState::expr, 2);
+            RemoveCloseEventAtDepth(ParserState::expr, 2);
 
-        closeEventMap[ParserState::index] = [this](srcSAXEventContext& ctx) {
+        });
 
-            if(nameDepth && (nameDepth + 1) == ctx.depth) {
+        OpenEventAtDepth(ParserState::expr, 2, [this](srcSAXEventContext& ctx) {
 
-                NopOpenEvents({ParserState::expr});
-                NopCloseEvents({ParserState::expr});
-
-            }
-
-        };
-
-        openEventMap[ParserState::expr] = [this](srcSAXEventContext& ctx) {
-
-            size_t num_elements = ctx.elementStack.size();
-            if(nameDepth && (nameDepth + 2) == ctx.depth && num_elements > 1 && ctx.elementStack[num_elements - 2] == "index") {
+            if(ctx.Parent(1) == ElementId::index) {
 
+                RemoveCloseEventAtDepth(ParserState::tokenstring, 0);
                 closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) { data.arrayIndices.back() += ctx.currentToken; };
 
             }
 
-        };
+        });
 
-        closeEventMap[ParserState::expr] = [this](srcSAXEventContext& ctx) {
+        CloseEventAtDepth(ParserState::expr, 2, [this](srcSAXEventContext& ctx) {
 
-            size_t num_elements = ctx.elementStack.size();
-            if(nameDepth && (nameDepth + 2) == ctx.depth && num_elements > 0 && ctx.elementStack.back() == "index") {
+            if(ctx.Element() == ElementId::index) {
 
                 NopCloseEvents({ParserState::tokenstring});
 
             }
 
-        };
+        });
 
     }
 
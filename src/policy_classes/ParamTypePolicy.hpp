@@ -30,6 +30,14 @@ class ParamTypePolicy : public srcSAXEventDispatch::EventListener, public srcSAX
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+        void Reset() override {
+            EventListener::Reset();
+            data = DeclData();
+            currentTypeName.clear();
+            currentDeclName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+        }
     protected:
         void * DataInner() const override {
             return new DeclData(data);
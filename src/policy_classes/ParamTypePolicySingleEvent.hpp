@@ -79,6 +79,20 @@ public:
 
     }
 
+    void Reset() override {
+
+        EventListener::Reset();
+
+        if(typePolicy) typePolicy->Reset();
+        if(namePolicy) namePolicy->Reset();
+
+        data = ParamTypeData{};
+        paramDepth = 0;
+
+        InitializeParamTypePolicyHandlers();
+
+    }
+
 protected:
     void * DataInner() const override {
 
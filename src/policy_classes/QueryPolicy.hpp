@@ -0,0 +1,564 @@
+/**
+ * @file QueryPolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+/*
+ * Path queries over srcML element names, evaluated in one pass.
+ *
+ *     query     := ( '/' | '//' ) step ( ( '/' | '//' ) step )*
+ *     step      := ( '*' | name | prefix ':' name ) predicate*
+ *     predicate := '[' '@' attribute ( '=' literal )? ']'
+ *                | '[' '.' '=' literal ']'
+ *                | '[' 'contains' '(' '.' ',' literal ')' ']'
+ *
+ * Paths are evaluated per unit: /unit/function is a top-level function,
+ * //call/name any name directly in a call.  Attribute predicates test the
+ * element's attributes, e.g. //comment[@type='block']; text predicates
+ * test its string value (all text below it) and are allowed on the last
+ * step only.  Literals are quoted with ' or ".
+ *
+ * The queries are compiled into one automaton over element ids: a state
+ * is the set of query steps matched along the current path, and states
+ * and transitions are built lazily, on first use, and cached, so every
+ * open, close and tokenstring event costs a hash lookup however many
+ * queries there are.  Each match is reported at the element's close,
+ * one notification per matching query; Data<QueryMatch>() is valid
+ * during the notification.
+ *
+ * Elements are seen through their dispatch events, so elements named in
+ * a query need an event: call RegisterElements on the dispatcher before
+ * parsing to AddEvent those without a built-in state.  A trailing '*'
+ * only reports elements that have an event, and '*' steps only see the
+ * attributes of such elements.
+ */
+#ifndef QUERYPOLICY
+#define QUERYPOLICY
+class QueryPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher {
+    public:
+        struct QueryMatch {
+            QueryMatch() : query(0), lineNumber(0), depth(0) {}
+            //index AddQuery returned for the query
+            std::size_t query;
+            //string value of the matched element
+            std::string text;
+            std::string filename;
+            unsigned int lineNumber;
+            std::size_t depth;
+        };
+
+        QueryPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {})
+            : srcSAXEventDispatch::PolicyDispatcher(listeners), boundTable(nullptr), pending(false), collecting(0) {
+            attributeSets.push_back(std::vector<std::size_t>());
+            attributeSetIndex[attributeSets.front()] = 0;
+        }
+
+        /**
+         * AddQuery
+         * @param query the path query
+         *
+         * Compile a query; throws std::invalid_argument if it does not
+         * parse.  Add queries before parsing.
+         *
+         * @returns the query's index, reported as QueryMatch::query
+         */
+        std::size_t AddQuery(const std::string & query) {
+
+            CompiledQuery compiled;
+            compiled.source = query;
+            compiled.steps = Parser(query, *this).Parse();
+            compiled.firstState = numberNfaStates;
+            numberNfaStates += compiled.steps.size() + 1;
+            for(std::size_t step = 0; step <= compiled.steps.size(); ++step)
+                nfaStates.push_back(std::make_pair(queries.size(), step));
+            queries.push_back(compiled);
+
+            boundTable = nullptr;
+            return queries.size() - 1;
+
+        }
+
+        const std::string & Query(std::size_t index) const { return queries[index].source; }
+        std::size_t NumberQueries() const { return queries.size(); }
+        /* automaton states built so far */
+        std::size_t NumberStates() const { return states.size(); }
+
+        /**
+         * RegisterElements
+         * @param dispatcher the dispatcher this policy is attached to
+         *
+         * AddEvent every element named in a query that the dispatcher
+         * does not already dispatch.
+         */
+        template<typename Dispatcher>
+        void RegisterElements(Dispatcher & dispatcher) const {
+            for(const CompiledQuery & query : queries) {
+                for(const Step & step : query.steps) {
+                    if(step.wildcard || step.name == "unit") continue;
+                    std::string::size_type colon = step.name.find(':');
+                    std::string localname = colon == std::string::npos ? step.name : step.name.substr(colon + 1);
+                    if(!dispatcher.DispatchesElement(localname)) dispatcher.AddEvent(localname);
+                }
+            }
+        }
+
+        void Reset() override {
+            EventListener::Reset();
+            frames.clear();
+            text.clear();
+            pending = false;
+            collecting = 0;
+        }
+
+        void HandleEvent(srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate, srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+
+            using namespace srcSAXEventDispatch;
+
+            if(dispatched) return;
+            dispatched = true;
+
+            if(boundTable != &ctx.elementTable) Bind(ctx.elementTable);
+
+            if(pstate == ParserState::xmlattribute) {
+                if(pending && frames.back().depth == ctx.depth) AddAttribute(ctx);
+                else Finalize(ctx);
+                return;
+            }
+
+            /* another event opening the pending element (e.g. userdefined); its attributes are still to come */
+            if(estate == ElementState::open && pending && frames.back().depth == ctx.depth) return;
+
+            Finalize(ctx);
+
+            if(pstate == ParserState::tokenstring) {
+                if(collecting) text += ctx.currentToken;
+                return;
+            }
+
+            if(pstate == ParserState::unit || pstate == ParserState::archive) {
+                if(estate == ElementState::open) {
+                    /* a unit nested in an archive starts over; the archive element is not matched */
+                    frames.clear();
+                    text.clear();
+                    collecting = 0;
+                    frames.push_back(Frame(0, startState, ctx.currentLineNumber));
+                    frames.back().state = Transition(startState, ctx.Element(), 0);
+                    Open(frames.back());
+                } else {
+                    while(!frames.empty()) Close(ctx);
+                }
+                return;
+            }
+
+            if(frames.empty()) return;
+
+            if(estate == ElementState::open) {
+
+                /* several events for one element: it already has its frame */
+                if(frames.back().depth >= ctx.depth) return;
+
+                /* elements without events between the parent's frame and this one */
+                std::size_t state = frames.back().state;
+                for(std::size_t depth = frames.back().depth + 1; depth < ctx.depth; ++depth)
+                    state = Transition(state, ctx.Parent(ctx.depth - depth), 0);
+
+                frames.push_back(Frame(ctx.depth, state, ctx.currentLineNumber));
+                pending = true;
+                pendingId = ctx.Element();
+                pendingAttributes.clear();
+
+            } else if(frames.back().depth == ctx.depth) {
+                Close(ctx);
+            }
+
+        }
+
+    protected:
+        void * DataInner() const override {
+            return (void *)&match;
+        }
+
+    private:
+
+        struct TextTest {
+            bool contains;
+            std::string text;
+        };
+
+        struct Step {
+            Step() : descendant(false), wildcard(false), id(srcSAXEventDispatch::ElementId::none) {}
+            bool descendant;
+            bool wildcard;
+            std::string name;
+            srcSAXEventDispatch::ElementId id;
+            //attribute tests the element must pass, sorted
+            std::vector<std::size_t> attributeTests;
+            std::vector<TextTest> textTests;
+        };
+
+        struct CompiledQuery {
+            std::string source;
+            std::vector<Step> steps;
+            std::size_t firstState;
+        };
+
+        /* tests of one attribute name: presence, and value by value */
+        struct AttributeTests {
+            std::vector<std::size_t> present;
+            std::unordered_map<std::string, std::size_t> values;
+        };
+
+        /* a set of (query, steps matched) states, and the queries it completes */
+        struct State {
+            std::vector<std::size_t> nfa;
+            std::vector<std::size_t> accepting;
+        };
+
+        struct TransitionKey {
+            std::size_t state;
+            srcSAXEventDispatch::ElementId id;
+            std::size_t attributes;
+            bool operator==(const TransitionKey & other) const {
+                return state == other.state && id == other.id && attributes == other.attributes;
+            }
+        };
+
+        struct TransitionHash {
+            std::size_t operator()(const TransitionKey & key) const {
+                std::size_t hash = key.state * 0x9E3779B97F4A7C15ull;
+                hash ^= std::size_t(key.id) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+                hash ^= key.attributes + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+                return hash;
+            }
+        };
+
+        /* an open element with an event */
+        struct Frame {
+            Frame(std::size_t depth, std::size_t state, unsigned int lineNumber)
+                : depth(depth), state(state), lineNumber(lineNumber), textStart(0), collecting(false) {}
+            std::size_t depth;
+            std::size_t state;
+            unsigned int lineNumber;
+            std::size_t textStart;
+            bool collecting;
+        };
+
+        class Parser {
+            public:
+                Parser(const std::string & query, QueryPolicy & policy) : query(query), policy(policy), pos(0) {}
+
+                std::vector<Step> Parse() {
+
+                    std::vector<Step> steps;
+                    SkipSpace();
+                    if(pos == query.size()) Error("empty query");
+                    while(pos < query.size()) {
+
+                        if(query[pos] != '/') Error("expected / or //");
+                        Step step;
+                        ++pos;
+                        if(pos < query.size() && query[pos] == '/') {
+                            step.descendant = true;
+                            ++pos;
+                        }
+
+                        SkipSpace();
+                        if(pos < query.size() && query[pos] == '*') {
+                            step.wildcard = true;
+                            ++pos;
+                        } else {
+                            step.name = Name();
+                            if(pos < query.size() && query[pos] == ':') {
+                                ++pos;
+                                step.name += ':' + Name();
+                            }
+                        }
+
+                        SkipSpace();
+                        while(pos < query.size() && query[pos] == '[') {
+                            ++pos;
+                            Predicate(step);
+                        }
+
+                        steps.push_back(step);
+
+                    }
+
+                    for(std::size_t step = 0; step + 1 < steps.size(); ++step) {
+                        if(!steps[step].textTests.empty()) Error("text predicates are only allowed on the last step");
+                    }
+
+                    return steps;
+
+                }
+
+            private:
+
+                void Predicate(Step & step) {
+
+                    SkipSpace();
+                    if(Accept('@')) {
+
+                        std::string attribute = Name();
+                        if(Accept(':')) attribute += ':' + Name();
+                        bool hasValue = Accept('=');
+                        std::size_t test = policy.AttributeTest(attribute, hasValue, hasValue ? Literal() : std::string());
+                        std::vector<std::size_t>::iterator insert = std::lower_bound(step.attributeTests.begin(), step.attributeTests.end(), test);
+                        if(insert == step.attributeTests.end() || *insert != test) step.attributeTests.insert(insert, test);
+
+                    } else if(Accept('.')) {
+
+                        Expect('=');
+                        step.textTests.push_back(TextTest{false, Literal()});
+
+                    } else if(Name() == "contains") {
+
+                        Expect('(');
+                        Expect('.');
+                        Expect(',');
+                        step.textTests.push_back(TextTest{true, Literal()});
+                        Expect(')');
+
+                    } else {
+                        Error("unknown predicate");
+                    }
+
+                    Expect(']');
+
+                }
+
+                std::string Name() {
+                    SkipSpace();
+                    std::size_t start = pos;
+                    while(pos < query.size() && (std::isalnum((unsigned char)query[pos]) || query[pos] == '_' || (pos > start && query[pos] == '-')))
+                        ++pos;
+                    if(pos == start) Error("expected a name");
+                    return query.substr(start, pos - start);
+                }
+
+                std::string Literal() {
+                    SkipSpace();
+                    if(pos == query.size() || (query[pos] != '\'' && query[pos] != '"')) Error("expected a quoted literal");
+                    char quote = query[pos++];
+                    std::string::size_type end = query.find(quote, pos);
+                    if(end == std::string::npos) Error("unterminated literal");
+                    std::string literal = query.substr(pos, end - pos);
+                    pos = end + 1;
+                    return literal;
+                }
+
+                bool Accept(char c) {
+                    SkipSpace();
+                    if(pos == query.size() || query[pos] != c) return false;
+                    ++pos;
+                    return true;
+                }
+
+                void Expect(char c) {
+                    if(!Accept(c)) Error(std::string("expected ") + c);
+                }
+
+                void SkipSpace() {
+                    while(pos < query.size() && std::isspace((unsigned char)query[pos])) ++pos;
+                }
+
+                void Error(const std::string & message) const {
+                    throw std::invalid_argument("QueryPolicy: " + message + " at position " + std::to_string(pos) + " in '" + query + "'");
+                }
+
+                const std::string & query;
+                QueryPolicy & policy;
+                std::size_t pos;
+        };
+
+        /* number of an attribute test, shared by all steps testing the same thing */
+        std::size_t AttributeTest(const std::string & attribute, bool hasValue, const std::string & value) {
+            AttributeTests & tests = attributeTests[attribute];
+            if(!hasValue) {
+                if(tests.present.empty()) tests.present.push_back(numberAttributeTests++);
+                return tests.present.front();
+            }
+            std::unordered_map<std::string, std::size_t>::const_iterator test = tests.values.find(value);
+            if(test != tests.values.end()) return test->second;
+            return tests.values[value] = numberAttributeTests++;
+        }
+
+        /* resolve step names in the dispatcher's element table; the automaton is rebuilt from there */
+        void Bind(srcSAXEventDispatch::ElementTable & table) {
+
+            for(CompiledQuery & query : queries) {
+                for(Step & step : query.steps) {
+                    if(!step.wildcard) step.id = table.Intern(step.name);
+                }
+            }
+
+            states.clear();
+            stateIndex.clear();
+            transitions.clear();
+
+            std::vector<std::size_t> start;
+            for(const CompiledQuery & query : queries)
+                start.push_back(query.firstState);
+            startState = Intern(start);
+
+            boundTable = &table;
+
+        }
+
+        std::size_t Intern(std::vector<std::size_t> & nfa) {
+
+            std::sort(nfa.begin(), nfa.end());
+            nfa.erase(std::unique(nfa.begin(), nfa.end()), nfa.end());
+
+            std::map<std::vector<std::size_t>, std::size_t>::const_iterator existing = stateIndex.find(nfa);
+            if(existing != stateIndex.end()) return existing->second;
+
+            State state;
+            state.nfa = nfa;
+            for(std::size_t nfaState : nfa) {
+                const CompiledQuery & query = queries[nfaStates[nfaState].first];
+                if(nfaStates[nfaState].second == query.steps.size()) state.accepting.push_back(nfaStates[nfaState].first);
+            }
+            states.push_back(state);
+            return stateIndex[nfa] = states.size() - 1;
+
+        }
+
+        /* attributes is an attribute set: the tests an element passed (see Finalize) */
+        std::size_t Transition(std::size_t from, srcSAXEventDispatch::ElementId id, std::size_t attributes) {
+
+            TransitionKey key{from, id, attributes};
+            std::unordered_map<TransitionKey, std::size_t, TransitionHash>::const_iterator cached = transitions.find(key);
+            if(cached != transitions.end()) return cached->second;
+
+            std::vector<std::size_t> next;
+            for(std::size_t nfaState : states[from].nfa) {
+                const CompiledQuery & query = queries[nfaStates[nfaState].first];
+                std::size_t matched = nfaStates[nfaState].second;
+                if(matched == query.steps.size()) continue;
+                const Step & step = query.steps[matched];
+                if(step.descendant) next.push_back(nfaState);
+                if((step.wildcard || step.id == id)
+                    && std::includes(attributeSets[attributes].begin(), attributeSets[attributes].end(), step.attributeTests.begin(), step.attributeTests.end()))
+                    next.push_back(nfaState + 1);
+            }
+
+            std::size_t to = Intern(next);
+            transitions[key] = to;
+            return to;
+
+        }
+
+        void AddAttribute(const srcSAXEventDispatch::srcSAXEventContext & ctx) {
+            std::unordered_map<std::string, AttributeTests>::const_iterator tests = attributeTests.find(ctx.currentAttributeName);
+            if(tests == attributeTests.end()) return;
+            pendingAttributes.insert(pendingAttributes.end(), tests->second.present.begin(), tests->second.present.end());
+            std::unordered_map<std::string, std::size_t>::const_iterator test = tests->second.values.find(ctx.currentAttributeValue);
+            if(test != tests->second.values.end()) pendingAttributes.push_back(test->second);
+        }
+
+        /* intern the tests an element passed; 0 is the empty set */
+        std::size_t AttributeSet(std::vector<std::size_t> & tests) {
+            if(tests.empty()) return 0;
+            std::sort(tests.begin(), tests.end());
+            std::map<std::vector<std::size_t>, std::size_t>::const_iterator set = attributeSetIndex.find(tests);
+            if(set != attributeSetIndex.end()) return set->second;
+            attributeSets.push_back(tests);
+            return attributeSetIndex[tests] = attributeSets.size() - 1;
+        }
+
+        /* the attributes of the newest element are complete: take its transition */
+        void Finalize(const srcSAXEventDispatch::srcSAXEventContext & ctx) {
+            if(!pending) return;
+            pending = false;
+            Frame & frame = frames.back();
+            frame.state = Transition(frame.state, pendingId, AttributeSet(pendingAttributes));
+            Open(frame);
+        }
+
+        void Open(Frame & frame) {
+            if(states[frame.state].accepting.empty()) return;
+            frame.collecting = true;
+            frame.textStart = text.size();
+            ++collecting;
+        }
+
+        void Close(const srcSAXEventDispatch::srcSAXEventContext & ctx) {
+
+            Frame frame = frames.back();
+            frames.pop_back();
+            if(!frame.collecting) return;
+
+            for(std::size_t query : states[frame.state].accepting) {
+
+                bool matches = true;
+                for(const TextTest & test : queries[query].steps.back().textTests) {
+                    std::size_t length = text.size() - frame.textStart;
+                    if(test.contains) matches = text.find(test.text, frame.textStart) != std::string::npos;
+                    else matches = length == test.text.size() && text.compare(frame.textStart, length, test.text) == 0;
+                    if(!matches) break;
+                }
+                if(!matches) continue;
+
+                match.query = query;
+                match.text.assign(text, frame.textStart, std::string::npos);
+                match.filename = ctx.currentFilePath;
+                match.lineNumber = frame.lineNumber;
+                match.depth = frame.depth;
+                NotifyAll(ctx);
+
+            }
+
+            if(!--collecting) text.clear();
+
+        }
+
+        std::vector<CompiledQuery> queries;
+        std::unordered_map<std::string, AttributeTests> attributeTests;
+        std::size_t numberAttributeTests = 0;
+        std::vector<std::vector<std::size_t>> attributeSets;
+        std::map<std::vector<std::size_t>, std::size_t> attributeSetIndex;
+        /* (query, steps matched) of each NFA state */
+        std::vector<std::pair<std::size_t, std::size_t>> nfaStates;
+        std::size_t numberNfaStates = 0;
+
+        const srcSAXEventDispatch::ElementTable * boundTable;
+        std::vector<State> states;
+        std::map<std::vector<std::size_t>, std::size_t> stateIndex;
+        std::unordered_map<TransitionKey, std::size_t, TransitionHash> transitions;
+        std::size_t startState = 0;
+
+        std::vector<Frame> frames;
+        bool pending;
+        srcSAXEventDispatch::ElementId pendingId;
+        std::vector<std::size_t> pendingAttributes;
+        /* text of the unit since the outermost collecting frame opened */
+        std::string text;
+        std::size_t collecting;
+
+        QueryMatch match;
+};
+#endif
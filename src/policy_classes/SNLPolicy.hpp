@@ -40,6 +40,14 @@ class SourceNLPolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+        void Reset() override {
+            EventListener::Reset();
+            data.clear();
+            currentTypeName.clear();
+            currentDeclName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+        }
     protected:
         void * DataInner() const override {
             return new SourceNLData(data);
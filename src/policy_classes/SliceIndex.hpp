@@ -0,0 +1,377 @@
+/**
+ * @file SliceIndex.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SLICE_INDEX_HPP
+#define INCLUDED_SLICE_INDEX_HPP
+
+#include <SliceProfilePolicy.hpp>
+#include <srcSAXInternTable.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * SliceIndex
+ *
+ * The slice profiles of a whole project and the slices computed from
+ * them.  As a listener of SliceProfilePolicy it takes each function as
+ * it is notified; with srcSAXParallelDispatcher the units are profiled in
+ * parallel and the (serialized) notifications land here.
+ *
+ * Profiles are kept in integer-indexed columns: strings are interned,
+ * variables are rows numbered contiguously per function, and lines,
+ * dvars, aliases and called functions are CSR lists (offsets into one
+ * flat array per column).
+ *
+ * Compute derives the slice of every variable: the variables reachable
+ * from it through dvars, aliases and, across functions, from an argument
+ * to the matching parameter of the called function (matched by unqualified
+ * name, preferring the caller's file).  A variable's slice is the sorted
+ * def and use lines of the reachable variables of its own function, and
+ * the reachable variables of other functions.  Functions are sliced in
+ * parallel.
+ */
+class SliceIndex : public srcSAXEventDispatch::PolicyListener {
+
+    public:
+
+        static const unsigned int npos = ~0u;
+
+        SliceIndex() : computed(false) {
+            ClearColumns();
+        }
+
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            Add(*policy->Data<SliceProfilePolicy::SliceFunction>());
+        }
+
+        void Add(const SliceProfilePolicy::SliceFunction & function){
+            computed = false;
+            unsigned int first = variableName.size();
+            FunctionRow row = { strings.Intern(function.file), strings.Intern(function.function), strings.Intern(LastComponent(function.function)), first, first + (unsigned int)function.variables.size() };
+            functionRows.push_back(row);
+            for(const SliceProfilePolicy::SliceProfile & profile : function.variables){
+                variableFunction.push_back(functionRows.size() - 1);
+                variableName.push_back(strings.Intern(profile.name));
+                variableType.push_back(strings.Intern(profile.type));
+                variableParameter.push_back(profile.parameter);
+                Append(defs, profile.defs.begin(), profile.defs.end(), 0);
+                Append(uses, profile.uses.begin(), profile.uses.end(), 0);
+                Append(dvars, profile.dvars.begin(), profile.dvars.end(), first);
+                Append(aliases, profile.aliases.begin(), profile.aliases.end(), first);
+                for(const std::pair<std::string, unsigned int> & call : profile.cfunctions){
+                    cfunctions.values.push_back(strings.Intern(call.first));
+                    cfunctionArguments.push_back(call.second);
+                }
+                cfunctions.offsets.push_back(cfunctions.values.size());
+            }
+            lookup.insert(std::make_pair(ScopeKey(row.file, row.name), functionRows.size() - 1));
+        }
+
+        std::size_t NumberFunctions() const { return functionRows.size(); }
+        std::size_t NumberVariables() const { return variableName.size(); }
+
+        /**
+         * Compute
+         * @param numThreads number of threads, 0 for one per hardware thread
+         */
+        void Compute(std::size_t numThreads = 0){
+
+            BuildEdges();
+
+            std::size_t rows = variableName.size();
+            sliceLines.assign(rows, std::vector<unsigned int>());
+            sliceReach.assign(rows, std::vector<unsigned int>());
+
+            if(!numThreads) numThreads = std::max(1u, std::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, std::max<std::size_t>(1, functionRows.size()));
+            std::atomic<std::size_t> next(0);
+            auto work = [this, &next](){
+                std::vector<unsigned int> stamp(variableName.size(), 0), worklist;
+                unsigned int epoch = 0;
+                for(std::size_t function = next++; function < functionRows.size(); function = next++){
+                    for(unsigned int variable = functionRows[function].first; variable < functionRows[function].last; ++variable){
+                        Slice(variable, ++epoch, stamp, worklist);
+                    }
+                }
+            };
+            std::vector<std::thread> threads;
+            for(std::size_t thread = 1; thread < numThreads; ++thread){
+                threads.emplace_back(work);
+            }
+            work();
+            for(std::thread & thread : threads){
+                thread.join();
+            }
+            computed = true;
+
+        }
+
+        /* the row of a variable, npos if unknown */
+        unsigned int Find(const std::string & file, const std::string & function, const std::string & name) const {
+            unsigned int fileId = strings.Find(file), functionId = strings.Find(function), nameId = strings.Find(name);
+            if(fileId == srcSAXEventDispatch::InternTable::npos || functionId == srcSAXEventDispatch::InternTable::npos || nameId == srcSAXEventDispatch::InternTable::npos) return npos;
+            std::unordered_map<std::uint64_t, unsigned int>::const_iterator found = lookup.find(ScopeKey(fileId, functionId));
+            if(found == lookup.end()) return npos;
+            for(unsigned int variable = functionRows[found->second].first; variable < functionRows[found->second].last; ++variable){
+                if(variableName[variable] == nameId) return variable;
+            }
+            return npos;
+        }
+        /* the slice lines of a variable in its own function; empty before Compute */
+        std::vector<unsigned int> SliceLines(const std::string & file, const std::string & function, const std::string & name) const {
+            unsigned int variable = Find(file, function, name);
+            return variable == npos || !computed ? std::vector<unsigned int>() : sliceLines[variable];
+        }
+        /* the variables of other functions in a variable's slice, as function:name */
+        std::vector<std::string> SliceReach(const std::string & file, const std::string & function, const std::string & name) const {
+            std::vector<std::string> reached;
+            unsigned int variable = Find(file, function, name);
+            if(variable == npos || !computed) return reached;
+            for(unsigned int other : sliceReach[variable]){
+                reached.push_back(QualifiedName(other));
+            }
+            return reached;
+        }
+
+        /**
+         * WriteColumns
+         * @param out stream for the export
+         *
+         * Columnar export, one line per column after a header line
+         * "srcslice-columns <rows>": the column name, then one tab-separated
+         * value per variable.  List values are comma-separated; called
+         * functions are callee:argument and reached variables function:name.
+         * Rows are ordered by file and function, then as profiled, so
+         * the export does not depend on the order units completed in.
+         */
+        void WriteColumns(std::ostream & out) const {
+
+            std::vector<unsigned int> order;
+            std::vector<unsigned int> functionOrder(functionRows.size());
+            for(unsigned int function = 0; function < functionOrder.size(); ++function) functionOrder[function] = function;
+            std::stable_sort(functionOrder.begin(), functionOrder.end(), [this](unsigned int lhs, unsigned int rhs){
+                const std::string & lhsFile = strings.Name(functionRows[lhs].file), & rhsFile = strings.Name(functionRows[rhs].file);
+                if(lhsFile != rhsFile) return lhsFile < rhsFile;
+                return strings.Name(functionRows[lhs].name) < strings.Name(functionRows[rhs].name);
+            });
+            for(unsigned int function : functionOrder){
+                for(unsigned int variable = functionRows[function].first; variable < functionRows[function].last; ++variable){
+                    order.push_back(variable);
+                }
+            }
+
+            out << "srcslice-columns " << order.size() << '\n';
+            WriteColumn(out, "file", order, [this, &out](unsigned int variable){ out << strings.Name(functionRows[variableFunction[variable]].file); });
+            WriteColumn(out, "function", order, [this, &out](unsigned int variable){ out << strings.Name(functionRows[variableFunction[variable]].name); });
+            WriteColumn(out, "name", order, [this, &out](unsigned int variable){ out << strings.Name(variableName[variable]); });
+            WriteColumn(out, "type", order, [this, &out](unsigned int variable){ out << strings.Name(variableType[variable]); });
+            WriteColumn(out, "parameter", order, [this, &out](unsigned int variable){ out << variableParameter[variable]; });
+            WriteColumn(out, "def", order, [this, &out](unsigned int variable){ WriteList(out, defs, variable, [&out](unsigned int line){ out << line; }); });
+            WriteColumn(out, "use", order, [this, &out](unsigned int variable){ WriteList(out, uses, variable, [&out](unsigned int line){ out << line; }); });
+            WriteColumn(out, "dvars", order, [this, &out](unsigned int variable){ WriteList(out, dvars, variable, [this, &out](unsigned int other){ out << strings.Name(variableName[other]); }); });
+            WriteColumn(out, "aliases", order, [this, &out](unsigned int variable){ WriteList(out, aliases, variable, [this, &out](unsigned int other){ out << strings.Name(variableName[other]); }); });
+            WriteColumn(out, "cfunctions", order, [this, &out](unsigned int variable){
+                for(unsigned int call = cfunctions.offsets[variable]; call < cfunctions.offsets[variable + 1]; ++call){
+                    if(call != cfunctions.offsets[variable]) out << ',';
+                    out << strings.Name(cfunctions.values[call]) << ':' << cfunctionArguments[call];
+                }
+            });
+            if(computed){
+                WriteColumn(out, "slice", order, [this, &out](unsigned int variable){ WriteValues(out, sliceLines[variable], [&out](unsigned int line){ out << line; }); });
+                WriteColumn(out, "reach", order, [this, &out](unsigned int variable){ WriteValues(out, sliceReach[variable], [this, &out](unsigned int other){ out << QualifiedName(other); }); });
+            }
+
+        }
+
+        void clear(){
+            strings.clear();
+            functionRows.clear();
+            lookup.clear();
+            functionsByName.clear();
+            ClearColumns();
+            sliceLines.clear();
+            sliceReach.clear();
+            computed = false;
+        }
+
+    private:
+
+        struct FunctionRow {
+            unsigned int file, name, unqualified;
+            /* variable rows [first, last) */
+            unsigned int first, last;
+        };
+        /* row i's values are values[offsets[i], offsets[i + 1]) */
+        struct List {
+            std::vector<unsigned int> offsets, values;
+        };
+
+        static std::uint64_t ScopeKey(unsigned int file, unsigned int function){
+            return (std::uint64_t(file) << 32) | function;
+        }
+
+        /* the last component of a qualified or member name: b of a::b, a.b and a->b */
+        static std::string LastComponent(const std::string & name){
+            std::size_t scope = name.rfind("::"), member = name.rfind('.'), arrow = name.rfind("->");
+            std::size_t start = 0;
+            if(scope != std::string::npos) start = std::max(start, scope + 2);
+            if(member != std::string::npos) start = std::max(start, member + 1);
+            if(arrow != std::string::npos) start = std::max(start, arrow + 2);
+            return name.substr(start);
+        }
+
+        std::string QualifiedName(unsigned int variable) const {
+            return strings.Name(functionRows[variableFunction[variable]].name) + ':' + strings.Name(variableName[variable]);
+        }
+
+        template<typename Iterator>
+        static void Append(List & list, Iterator begin, Iterator end, unsigned int base){
+            for(; begin != end; ++begin){
+                list.values.push_back(*begin + base);
+            }
+            list.offsets.push_back(list.values.size());
+        }
+
+        void ClearColumns(){
+            variableFunction.clear();
+            variableName.clear();
+            variableType.clear();
+            variableParameter.clear();
+            for(List * list : { &defs, &uses, &dvars, &aliases, &cfunctions, &edges }){
+                list->offsets.assign(1, 0);
+                list->values.clear();
+            }
+            cfunctionArguments.clear();
+        }
+
+        /* dvars, aliases and argument-to-parameter bindings, as one list per variable */
+        void BuildEdges(){
+
+            functionsByName.clear();
+            for(unsigned int function = 0; function < functionRows.size(); ++function){
+                functionsByName[functionRows[function].unqualified].push_back(function);
+            }
+
+            edges.offsets.assign(1, 0);
+            edges.values.clear();
+            for(unsigned int variable = 0; variable < variableName.size(); ++variable){
+                edges.values.insert(edges.values.end(), dvars.values.begin() + dvars.offsets[variable], dvars.values.begin() + dvars.offsets[variable + 1]);
+                edges.values.insert(edges.values.end(), aliases.values.begin() + aliases.offsets[variable], aliases.values.begin() + aliases.offsets[variable + 1]);
+                for(unsigned int call = cfunctions.offsets[variable]; call < cfunctions.offsets[variable + 1]; ++call){
+                    unsigned int parameter = BindParameter(functionRows[variableFunction[variable]].file, cfunctions.values[call], cfunctionArguments[call]);
+                    if(parameter != npos) edges.values.push_back(parameter);
+                }
+                edges.offsets.push_back(edges.values.size());
+            }
+
+        }
+
+        unsigned int BindParameter(unsigned int file, unsigned int callee, unsigned int argument){
+            unsigned int unqualified = strings.Find(LastComponent(strings.Name(callee)));
+            if(unqualified == srcSAXEventDispatch::InternTable::npos) return npos;
+            std::unordered_map<unsigned int, std::vector<unsigned int>>::const_iterator candidates = functionsByName.find(unqualified);
+            if(candidates == functionsByName.end()) return npos;
+            unsigned int chosen = candidates->second.front();
+            for(unsigned int function : candidates->second){
+                if(functionRows[function].file == file){
+                    chosen = function;
+                    break;
+                }
+            }
+            for(unsigned int variable = functionRows[chosen].first; variable < functionRows[chosen].last; ++variable){
+                if(variableParameter[variable] == argument) return variable;
+            }
+            return npos;
+        }
+
+        /* worklist closure from variable; stamp marks rows visited in this epoch */
+        void Slice(unsigned int variable, unsigned int epoch, std::vector<unsigned int> & stamp, std::vector<unsigned int> & worklist){
+            unsigned int function = variableFunction[variable];
+            std::vector<unsigned int> & lines = sliceLines[variable];
+            std::vector<unsigned int> & reach = sliceReach[variable];
+            worklist.assign(1, variable);
+            stamp[variable] = epoch;
+            while(!worklist.empty()){
+                unsigned int current = worklist.back();
+                worklist.pop_back();
+                if(variableFunction[current] == function){
+                    lines.insert(lines.end(), defs.values.begin() + defs.offsets[current], defs.values.begin() + defs.offsets[current + 1]);
+                    lines.insert(lines.end(), uses.values.begin() + uses.offsets[current], uses.values.begin() + uses.offsets[current + 1]);
+                }else{
+                    reach.push_back(current);
+                }
+                for(unsigned int edge = edges.offsets[current]; edge < edges.offsets[current + 1]; ++edge){
+                    unsigned int next = edges.values[edge];
+                    if(stamp[next] != epoch){
+                        stamp[next] = epoch;
+                        worklist.push_back(next);
+                    }
+                }
+            }
+            std::sort(lines.begin(), lines.end());
+            lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+            std::sort(reach.begin(), reach.end());
+        }
+
+        template<typename Write>
+        void WriteColumn(std::ostream & out, const char * name, const std::vector<unsigned int> & order, Write write) const {
+            out << name;
+            for(unsigned int variable : order){
+                out << '\t';
+                write(variable);
+            }
+            out << '\n';
+        }
+        template<typename Write>
+        static void WriteList(std::ostream & out, const List & list, unsigned int row, Write write){
+            for(unsigned int value = list.offsets[row]; value < list.offsets[row + 1]; ++value){
+                if(value != list.offsets[row]) out << ',';
+                write(list.values[value]);
+            }
+        }
+        template<typename Write>
+        static void WriteValues(std::ostream & out, const std::vector<unsigned int> & values, Write write){
+            for(std::size_t value = 0; value < values.size(); ++value){
+                if(value) out << ',';
+                write(values[value]);
+            }
+        }
+
+        srcSAXEventDispatch::InternTable strings;
+        std::vector<FunctionRow> functionRows;
+        std::unordered_map<std::uint64_t, unsigned int> lookup;
+        std::unordered_map<unsigned int, std::vector<unsigned int>> functionsByName;
+
+        /* variable columns, indexed by row */
+        std::vector<unsigned int> variableFunction, variableName, variableType, variableParameter;
+        List defs, uses, dvars, aliases, cfunctions, edges;
+        std::vector<unsigned int> cfunctionArguments;
+
+        std::vector<std::vector<unsigned int>> sliceLines, sliceReach;
+        bool computed;
+
+};
+
+#endif
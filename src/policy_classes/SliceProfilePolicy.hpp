@@ -0,0 +1,411 @@
+/**
+ * @file SliceProfilePolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SLICE_PROFILE_POLICY_HPP
+#define INCLUDED_SLICE_PROFILE_POLICY_HPP
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <srcSAXSmallSortedSet.hpp>
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * SliceProfilePolicy
+ *
+ * Collects the srcSlice facts of every variable of a function: the lines
+ * defining and using it, its dvars (variables whose definition uses it),
+ * its aliases (references and pointers bound to it) and the calls it is
+ * passed to, with the argument position.  Listeners are notified at each
+ * function's close with a SliceFunction, a view valid during Notify.
+ *
+ * Facts come from expressions: in an assignment, or a declaration with
+ * an initializer, the assigned variable is defined and every variable on
+ * the right is a use whose dvars gain it; ++ and -- define and use their
+ * operand; any other variable in an expression is a use.  Declarations
+ * and parameters define their variable.  Variables are keyed by name
+ * within the function, so shadowing declarations share a profile, and
+ * names used but not declared there (globals, members) get a profile
+ * with no type.  SliceIndex computes slices from the profiles.
+ */
+class SliceProfilePolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener {
+    public:
+        typedef srcSAXEventDispatch::SmallSortedSet<unsigned int> LineSet;
+        /* variables are referred to by their index in SliceFunction::variables */
+        typedef srcSAXEventDispatch::SmallSortedSet<unsigned int> VariableSet;
+        struct SliceProfile{
+            SliceProfile() : parameter(0), isReference(false), isPointer(false) {}
+            std::string name;
+            std::string type;
+            //position among the function's parameters from 1, 0 if not a parameter
+            unsigned int parameter;
+            bool isReference;
+            bool isPointer;
+            LineSet defs;
+            LineSet uses;
+            VariableSet dvars;
+            VariableSet aliases;
+            //(called function as written, argument position from 1)
+            std::vector<std::pair<std::string, unsigned int>> cfunctions;
+        };
+        struct SliceFunction{
+            void clear(){
+                file.clear();
+                function.clear();
+                variables.clear();
+            }
+            std::string file;
+            std::string function;
+            //in order of first appearance
+            std::vector<SliceProfile> variables;
+        };
+        ~SliceProfilePolicy(){}
+        SliceProfilePolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners), collecting(false), initialized(-1), exprDepth(0), notifying(nullptr){
+            InitializeEventHandlers();
+        }
+        void Reset() override {
+            EventListener::Reset();
+            functions.clear();
+            decls.clear();
+            names.clear();
+            calls.clear();
+            items.clear();
+            collecting = false;
+            notifying = nullptr;
+        }
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+    protected:
+        void * DataInner() const override {
+            return (void *)notifying;
+        }
+    private:
+        struct Function{
+            Function() : inBody(false), inParameters(false), parameters(0) {}
+            SliceFunction data;
+            std::unordered_map<std::string, unsigned int> index;
+            bool inBody, inParameters;
+            unsigned int parameters;
+        };
+        struct Decl{
+            std::size_t depth;
+            bool parameter, inType, isReference, isPointer;
+            std::string type;
+            int variable;
+        };
+        /* an outermost name; tokens of nested names and their operators accumulate in text */
+        struct Name{
+            Name(std::size_t depth = 0, srcSAXEventDispatch::ElementId parent = srcSAXEventDispatch::ElementId::none) : depth(depth), parent(parent), item(-1) {}
+            std::size_t depth;
+            srcSAXEventDispatch::ElementId parent;
+            std::string text, base;
+            //slot reserved in items, so a[i] lists a before i; -1 for none
+            int item;
+        };
+        struct Call{
+            std::size_t depth;
+            std::string callee;
+            unsigned int argument;
+        };
+        /* a variable or operator of the expression being collected */
+        struct Item{
+            bool isVariable;
+            std::string text;
+            unsigned int line;
+            std::size_t callLevel;
+            std::string callee;
+            unsigned int argument;
+        };
+
+        std::vector<Function> functions;
+        std::vector<Decl> decls;
+        std::vector<Name> names;
+        std::vector<Call> calls;
+        //an item that is neither a variable nor an operator marks a slot left unused
+        std::vector<Item> items;
+        bool collecting;
+        //variable the collected expression initializes, -1 for none
+        int initialized;
+        std::size_t exprDepth;
+        const SliceFunction * notifying;
+
+        bool InFunction() const {
+            return !functions.empty() && (functions.back().inBody || functions.back().inParameters);
+        }
+        static bool IsVariableName(const std::string & name){
+            static const std::unordered_set<std::string> keywords = {
+                "this", "true", "false", "nullptr", "NULL", "new", "delete", "sizeof", "auto", "void",
+                "bool", "char", "short", "int", "long", "float", "double", "signed", "unsigned", "const"
+            };
+            return !name.empty() && (std::isalpha((unsigned char)name[0]) || name[0] == '_') && !keywords.count(name);
+        }
+        static bool IsAssignment(const std::string & op){
+            return op == "=" || (op.size() >= 2 && op.back() == '=' && op != "==" && op != "!=" && op != "<=" && op != ">=");
+        }
+        unsigned int Variable(Function & function, const std::string & name){
+            std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> found = function.index.insert(std::make_pair(name, function.data.variables.size()));
+            if(found.second){
+                function.data.variables.push_back(SliceProfile());
+                function.data.variables.back().name = name;
+            }
+            return found.first->second;
+        }
+
+        void Declare(const Name & name, srcSAXEventDispatch::srcSAXEventContext & ctx){
+            Function & function = functions.back();
+            Decl & decl = decls.back();
+            decl.variable = Variable(function, name.text);
+            SliceProfile & profile = function.data.variables[decl.variable];
+            if(!decl.type.empty()) profile.type = decl.type;
+            profile.isReference = profile.isReference || decl.isReference;
+            profile.isPointer = profile.isPointer || decl.isPointer;
+            if(decl.parameter) profile.parameter = ++function.parameters;
+            profile.defs.insert(ctx.currentLineNumber);
+        }
+
+        void Occurrence(const Name & name, srcSAXEventDispatch::srcSAXEventContext & ctx){
+            if(name.item < 0) return;
+            //member of an earlier operand, as in a.b when written as sibling names
+            if(name.item > 0 && !items[name.item - 1].isVariable && (items[name.item - 1].text == "." || items[name.item - 1].text == "->")) return;
+            const std::string & variable = name.text.find("::") != std::string::npos ? name.text : name.base;
+            if(!IsVariableName(variable)) return;
+            Item & item = items[name.item];
+            item.isVariable = true;
+            item.text = variable;
+            item.line = ctx.currentLineNumber;
+            if(!calls.empty() && calls.back().argument){
+                item.callee = calls.back().callee;
+                item.argument = calls.back().argument;
+            }
+        }
+
+        /* the facts of a complete outermost expression */
+        void Collect(){
+            Function & function = functions.back();
+            std::size_t assignment = items.size();
+            for(std::size_t position = 0; position < items.size(); ++position){
+                if(!items[position].isVariable && items[position].callLevel == 0 && IsAssignment(items[position].text)){
+                    assignment = position;
+                    break;
+                }
+            }
+            int defined = initialized;
+            std::size_t definedItem = items.size(), rhs = 0;
+            bool compound = false;
+            if(defined < 0 && assignment < items.size()){
+                for(std::size_t position = 0; position < assignment; ++position){
+                    if(items[position].isVariable && items[position].callLevel == 0){
+                        definedItem = position;
+                        break;
+                    }
+                }
+                rhs = assignment + 1;
+                compound = items[assignment].text != "=";
+            }else if(defined < 0){
+                bool step = false;
+                for(const Item & item : items){
+                    if(!item.isVariable && item.callLevel == 0 && (item.text == "++" || item.text == "--")) step = true;
+                }
+                for(std::size_t position = 0; step && position < items.size(); ++position){
+                    if(items[position].isVariable && items[position].callLevel == 0){
+                        definedItem = position;
+                        break;
+                    }
+                }
+                rhs = items.size();
+                compound = true;
+            }
+            if(definedItem < items.size()){
+                defined = Variable(function, items[definedItem].text);
+                function.data.variables[defined].defs.insert(items[definedItem].line);
+                if(compound) function.data.variables[defined].uses.insert(items[definedItem].line);
+            }
+
+            //a reference initialized from a variable, or a pointer from an address or another pointer, is an alias
+            std::size_t rhsVariables = 0;
+            int aliased = -1;
+            for(std::size_t position = rhs; position < items.size(); ++position){
+                if(items[position].isVariable){
+                    ++rhsVariables;
+                    aliased = position;
+                }
+            }
+            bool alias = false;
+            if(defined >= 0 && rhsVariables == 1){
+                const SliceProfile & target = function.data.variables[defined];
+                bool addressOf = aliased > 0 && !items[aliased - 1].isVariable && items[aliased - 1].text == "&";
+                std::unordered_map<std::string, unsigned int>::const_iterator source = function.index.find(items[aliased].text);
+                bool fromPointer = source != function.index.end() && function.data.variables[source->second].isPointer;
+                alias = (initialized >= 0 && target.isReference) || (target.isPointer && (addressOf || fromPointer));
+            }
+
+            for(std::size_t position = 0; position < items.size(); ++position){
+                const Item & item = items[position];
+                if(!item.isVariable || position == definedItem) continue;
+                unsigned int variable = Variable(function, item.text);
+                SliceProfile & profile = function.data.variables[variable];
+                profile.uses.insert(item.line);
+                if(defined >= 0 && position >= rhs && int(variable) != defined){
+                    if(alias) profile.aliases.insert(defined);
+                    else profile.dvars.insert(defined);
+                }
+                if(item.argument){
+                    std::pair<std::string, unsigned int> call(item.callee, item.argument);
+                    if(std::find(profile.cfunctions.begin(), profile.cfunctions.end(), call) == profile.cfunctions.end()){
+                        profile.cfunctions.push_back(call);
+                    }
+                }
+            }
+        }
+
+        void InitializeEventHandlers(){
+            using namespace srcSAXEventDispatch;
+            std::function<void(srcSAXEventContext&)> openFunction = [this](srcSAXEventContext& ctx) {
+                functions.push_back(Function());
+                functions.back().data.file = ctx.currentFilePath;
+            };
+            std::function<void(srcSAXEventContext&)> closeFunction = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()) return;
+                notifying = &functions.back().data;
+                NotifyAll(ctx);
+                notifying = nullptr;
+                functions.pop_back();
+            };
+            openEventMap[ParserState::function] = openFunction;
+            openEventMap[ParserState::constructor] = openFunction;
+            openEventMap[ParserState::destructor] = openFunction;
+            closeEventMap[ParserState::function] = closeFunction;
+            closeEventMap[ParserState::constructor] = closeFunction;
+            closeEventMap[ParserState::destructor] = closeFunction;
+            openEventMap[ParserState::functionblock] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty()) functions.back().inBody = true;
+            };
+            openEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && !functions.back().inBody && ctx.Parent(1) != ElementId::templates) functions.back().inParameters = true;
+            };
+            closeEventMap[ParserState::parameterlist] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && !functions.back().inBody) functions.back().inParameters = false;
+            };
+
+            openEventMap[ParserState::decl] = [this](srcSAXEventContext& ctx) {
+                if(!InFunction()) return;
+                Decl decl = { ctx.depth, ctx.Parent(1) == ElementId::parameter && !functions.back().inBody, false, false, false, std::string(), -1 };
+                decls.push_back(decl);
+            };
+            closeEventMap[ParserState::decl] = [this](srcSAXEventContext& ctx) {
+                if(!decls.empty() && decls.back().depth == ctx.depth) decls.pop_back();
+            };
+            openEventMap[ParserState::type] = [this](srcSAXEventContext& ctx) {
+                if(!decls.empty() && decls.back().depth + 1 == ctx.depth) decls.back().inType = true;
+            };
+            closeEventMap[ParserState::type] = [this](srcSAXEventContext& ctx) {
+                if(!decls.empty() && decls.back().depth + 1 == ctx.depth) decls.back().inType = false;
+            };
+
+            openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || ctx.Parent(1) == ElementId::name) return;
+                Name name(ctx.depth, ctx.Parent(1));
+                if(collecting && (name.parent == ElementId::expr || name.parent == ElementId::call)){
+                    name.item = items.size();
+                    Item slot = { false, std::string(), 0, calls.size(), std::string(), 0 };
+                    items.push_back(slot);
+                }
+                names.push_back(name);
+            };
+            closeEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(names.empty() || names.back().depth != ctx.depth) return;
+                Name name;
+                std::swap(name, names.back());
+                names.pop_back();
+                if(name.parent == ElementId::function || name.parent == ElementId::constructor || name.parent == ElementId::destructor){
+                    if(!functions.back().inBody) functions.back().data.function = name.text;
+                }else if(name.parent == ElementId::decl){
+                    if(!decls.empty() && decls.back().depth + 1 == name.depth && decls.back().variable < 0) Declare(name, ctx);
+                }else if(name.parent == ElementId::call){
+                    if(collecting && !calls.empty() && calls.back().depth + 1 == name.depth){
+                        calls.back().callee = name.text;
+                        //the object of a member call is used
+                        if(name.text.find('.') != std::string::npos || name.text.find("->") != std::string::npos) Occurrence(name, ctx);
+                    }
+                }else if(name.parent == ElementId::expr && collecting && ctx.IsClosed(ParserState::genericargumentlist)){
+                    Occurrence(name, ctx);
+                }
+            };
+
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()) return;
+                const std::string & token = ctx.currentToken;
+                std::size_t first = token.find_first_not_of(" \t\r\n");
+                if(first == std::string::npos) return;
+                ElementId element = ctx.Element();
+                if(!decls.empty() && decls.back().inType){
+                    decls.back().type.append(token, first, token.find_last_not_of(" \t\r\n") + 1 - first);
+                    if(element == ElementId::modifier){
+                        if(token.find('&') != std::string::npos) decls.back().isReference = true;
+                        if(token.find('*') != std::string::npos) decls.back().isPointer = true;
+                    }
+                }
+                if(!names.empty() && (element == ElementId::name || (element == ElementId::op && ctx.Parent(1) == ElementId::name))){
+                    names.back().text += token;
+                    if(names.back().base.empty() && element == ElementId::name) names.back().base = token;
+                }else if(collecting && element == ElementId::op){
+                    Item item = { false, token.substr(first, token.find_last_not_of(" \t\r\n") + 1 - first), ctx.currentLineNumber, calls.size(), std::string(), 0 };
+                    items.push_back(item);
+                }
+            };
+
+            //the outermost expression of a statement, condition, initializer or argument
+            openEventMap[ParserState::expr] = [this](srcSAXEventContext& ctx) {
+                if(collecting || !InFunction()) return;
+                collecting = true;
+                items.clear();
+                initialized = -1;
+                if(!decls.empty()
+                   && ((ctx.Parent(1) == ElementId::init && ctx.Parent(2) == ElementId::decl && decls.back().depth + 2 == ctx.depth)
+                       || (ctx.Parent(1) == ElementId::argument && ctx.Parent(2) == ElementId::argument_list && ctx.Parent(3) == ElementId::decl && decls.back().depth + 3 == ctx.depth))){
+                    initialized = decls.back().variable;
+                }
+                exprDepth = ctx.depth;
+            };
+            closeEventMap[ParserState::expr] = [this](srcSAXEventContext& ctx) {
+                if(!collecting || ctx.depth != exprDepth) return;
+                Collect();
+                collecting = false;
+                calls.clear();
+            };
+            openEventMap[ParserState::call] = [this](srcSAXEventContext& ctx) {
+                if(!collecting) return;
+                Call call = { ctx.depth, std::string(), 0 };
+                calls.push_back(call);
+            };
+            closeEventMap[ParserState::call] = [this](srcSAXEventContext& ctx) {
+                if(!calls.empty() && calls.back().depth == ctx.depth) calls.pop_back();
+            };
+            openEventMap[ParserState::argument] = [this](srcSAXEventContext& ctx) {
+                if(!calls.empty() && calls.back().depth + 2 == ctx.depth) ++calls.back().argument;
+            };
+        }
+};
+
+#endif
@@ -38,6 +38,11 @@ class StereotypePolicy : public srcSAXEventDispatch::EventListener, public srcSA
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+        void Reset() override {
+            EventListener::Reset();
+            data.clear();
+            currentStereotype.clear();
+        }
     protected:
         void * DataInner() const override {
             return new StereotypeData(data);
@@ -0,0 +1,195 @@
+/**
+ * @file SymbolIndex.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SYMBOL_INDEX_HPP
+#define INCLUDED_SYMBOL_INDEX_HPP
+
+#include <srcSAXInternTable.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * SymbolIndex
+ *
+ * Function definitions and call sites of an archive, joined by name and
+ * arity.  Definitions are kept by qualified name (N::f), call symbols by
+ * the callee as written (f, N::f, a.f, p->f) with the number of sites,
+ * so memory grows with the distinct symbols, not the calls.
+ *
+ * Resolve joins each call symbol to its candidate definitions, those of
+ * the same arity whose last name component matches.  A callee written
+ * with a qualifier only keeps definitions whose qualified name is the
+ * callee or ends in ::callee; a plain or member call keeps them all.
+ * Queries see the definitions and calls added up to the last Resolve.
+ */
+class SymbolIndex {
+
+    public:
+
+        struct Definition {
+            std::string name;
+            std::string file;
+            unsigned int line;
+            unsigned int arity;
+        };
+
+        SymbolIndex() : resolved(true) {
+            candidates.offsets.assign(1, 0);
+        }
+
+        void AddDefinition(const std::string & qualifiedName, unsigned int arity, const std::string & file, unsigned int line){
+            DefinitionRow row = { names.Intern(qualifiedName), names.Intern(file), line, arity };
+            unsigned int last = names.Intern(LastComponent(qualifiedName));
+            definitionsByName[Key(last, arity)].push_back(definitions.size());
+            definitions.push_back(row);
+            resolved = false;
+        }
+        void AddCall(const std::string & callee, unsigned int arity){
+            std::pair<std::unordered_map<std::uint64_t, unsigned int>::iterator, bool> found = callIndex.insert(std::make_pair(Key(names.Intern(callee), arity), calls.size()));
+            if(found.second){
+                CallRow row = { names.Intern(callee), arity, 0 };
+                calls.push_back(row);
+            }
+            ++calls[found.first->second].sites;
+            resolved = false;
+        }
+
+        /* the final join: candidate definitions of every call symbol */
+        void Resolve(){
+            if(resolved) return;
+            candidates.offsets.assign(1, 0);
+            candidates.values.clear();
+            for(const CallRow & call : calls){
+                const std::string & callee = names.Name(call.callee);
+                unsigned int last = names.Find(LastComponent(callee));
+                std::unordered_map<std::uint64_t, std::vector<unsigned int>>::const_iterator found = definitionsByName.find(Key(last, call.arity));
+                if(found != definitionsByName.end()){
+                    bool qualified = callee.find("::") != std::string::npos && !IsMember(callee);
+                    for(unsigned int definition : found->second){
+                        if(!qualified || Qualifies(names.Name(definitions[definition].name), callee)) candidates.values.push_back(definition);
+                    }
+                }
+                candidates.offsets.push_back(candidates.values.size());
+            }
+            resolved = true;
+        }
+
+        std::size_t NumberDefinitions() const { return definitions.size(); }
+        /* distinct (callee, arity) pairs */
+        std::size_t NumberCallSymbols() const { return calls.size(); }
+
+        /* sites calling callee with arity arguments */
+        std::size_t Sites(const std::string & callee, unsigned int arity) const {
+            unsigned int call = Call(callee, arity);
+            return call == npos ? 0 : calls[call].sites;
+        }
+        /* candidate definitions, in the order added; empty if unresolved or before Resolve */
+        std::vector<Definition> Candidates(const std::string & callee, unsigned int arity) const {
+            std::vector<Definition> found;
+            unsigned int call = Call(callee, arity);
+            if(call == npos || call + 1 >= candidates.offsets.size()) return found;
+            for(unsigned int candidate = candidates.offsets[call]; candidate < candidates.offsets[call + 1]; ++candidate){
+                const DefinitionRow & row = definitions[candidates.values[candidate]];
+                Definition definition = { names.Name(row.name), names.Name(row.file), row.line, row.arity };
+                found.push_back(definition);
+            }
+            return found;
+        }
+        /* call symbols with no candidate, as (callee, arity) in order of first call */
+        std::vector<std::pair<std::string, unsigned int>> Unresolved() const {
+            std::vector<std::pair<std::string, unsigned int>> unresolved;
+            for(std::size_t call = 0; call + 1 < candidates.offsets.size(); ++call){
+                if(candidates.offsets[call] == candidates.offsets[call + 1]) unresolved.push_back(std::make_pair(names.Name(calls[call].callee), calls[call].arity));
+            }
+            return unresolved;
+        }
+
+        void clear(){
+            names.clear();
+            definitions.clear();
+            definitionsByName.clear();
+            calls.clear();
+            callIndex.clear();
+            candidates.offsets.assign(1, 0);
+            candidates.values.clear();
+            resolved = true;
+        }
+
+    private:
+
+        static const unsigned int npos = srcSAXEventDispatch::InternTable::npos;
+
+        struct DefinitionRow {
+            unsigned int name, file, line, arity;
+        };
+        struct CallRow {
+            unsigned int callee, arity;
+            std::size_t sites;
+        };
+        /* call i's candidates are values[offsets[i], offsets[i + 1]) */
+        struct List {
+            std::vector<unsigned int> offsets, values;
+        };
+
+        static std::uint64_t Key(unsigned int name, unsigned int arity){
+            return (std::uint64_t(name) << 32) | arity;
+        }
+        static bool IsMember(const std::string & callee){
+            return callee.find('.') != std::string::npos || callee.find("->") != std::string::npos;
+        }
+        /* the last component of a qualified or member name: f of N::f, a.f and p->f */
+        static std::string LastComponent(const std::string & name){
+            std::size_t scope = name.rfind("::"), member = name.rfind('.'), arrow = name.rfind("->");
+            std::size_t start = 0;
+            if(scope != std::string::npos) start = std::max(start, scope + 2);
+            if(member != std::string::npos) start = std::max(start, member + 1);
+            if(arrow != std::string::npos) start = std::max(start, arrow + 2);
+            return name.substr(start);
+        }
+        /* definition is callee, or callee with more qualification in front */
+        static bool Qualifies(const std::string & definition, const std::string & callee){
+            std::string written = callee.compare(0, 2, "::") == 0 ? callee.substr(2) : callee;
+            if(definition == written) return true;
+            return definition.size() > written.size() + 2 && definition.compare(definition.size() - written.size(), written.size(), written) == 0
+                && definition.compare(definition.size() - written.size() - 2, 2, "::") == 0;
+        }
+
+        unsigned int Call(const std::string & callee, unsigned int arity) const {
+            unsigned int name = names.Find(callee);
+            if(name == npos) return npos;
+            std::unordered_map<std::uint64_t, unsigned int>::const_iterator found = callIndex.find(Key(name, arity));
+            return found == callIndex.end() ? npos : found->second;
+        }
+
+        srcSAXEventDispatch::InternTable names;
+        std::vector<DefinitionRow> definitions;
+        /* definitions by (last name component, arity) */
+        std::unordered_map<std::uint64_t, std::vector<unsigned int>> definitionsByName;
+        std::vector<CallRow> calls;
+        std::unordered_map<std::uint64_t, unsigned int> callIndex;
+        List candidates;
+        bool resolved;
+
+};
+
+#endif
@@ -0,0 +1,222 @@
+/**
+ * @file SymbolResolutionPolicy.hpp
+ *
+ * @copyright Copyright (C) 2013-2014 SDML (www.srcML.org)
+ *
+ * The srcML Toolkit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The srcML Toolkit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the srcML Toolkit; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef INCLUDED_SYMBOL_RESOLUTION_POLICY_HPP
+#define INCLUDED_SYMBOL_RESOLUTION_POLICY_HPP
+
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <SymbolIndex.hpp>
+#include <FunctionCallPolicy.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+/**
+ * SymbolResolutionPolicy
+ *
+ * Builds a SymbolIndex as units stream by and resolves it at archive
+ * close, so calls link to definitions in any unit.  Definitions are the
+ * functions, constructors and destructors FunctionSignaturePolicy
+ * reports, with their parameter count, named by their own name element
+ * as written (S::g, S::S, S::~S) behind the enclosing namespaces and
+ * classes.
+ * Call sites are the calls CallPolicy reports, nested calls included;
+ * arity is counted from the call's argument elements, as the flat
+ * argument list does not delimit arguments.
+ *
+ * Listeners are notified with the resolved index at archive close.
+ * Data returns a view valid during Notify; do not delete it.
+ */
+class SymbolResolutionPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener {
+    public:
+        ~SymbolResolutionPolicy(){}
+        SymbolResolutionPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}): srcSAXEventDispatch::PolicyDispatcher(listeners){
+            callpolicy.AddListener(this);
+            signaturepolicy.AddListener(this);
+            InitializeEventHandlers();
+        }
+        void Reset() override {
+            EventListener::Reset();
+            callpolicy.Reset();
+            signaturepolicy.Reset();
+            index.clear();
+            functions.clear();
+            scopes.clear();
+            argumentLists.clear();
+            arities.clear();
+        }
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            if(policy == &signaturepolicy){
+                FunctionSignaturePolicy::SignatureData * signature = policy->Data<FunctionSignaturePolicy::SignatureData>();
+                std::string name = functions.empty() || functions.back().name.empty() ? signature->name : functions.back().name;
+                for(std::size_t k = 1; k < ctx.elementIds.size(); ++k){
+                    std::size_t position = ctx.elementIds.size() - 1 - k;
+                    if(IsScope(ctx.Parent(k)) && position < scopes.size() && !scopes[position].name.empty()) name = scopes[position].name + "::" + name;
+                }
+                index.AddDefinition(name, signature->parameters.size(), ctx.currentFilePath, signature->linenumber);
+                delete signature;
+                return;
+            }
+            //the k-th "(" is the k-th argument list opened since the last call, followed by the callee for a call's
+            CallPolicy::CallData * call = policy->Data<CallPolicy::CallData>();
+            std::size_t list = 0;
+            std::string genericName;
+            for(std::list<std::string>::const_iterator token = call->callargumentlist.begin(); token != call->callargumentlist.end(); ++token){
+                if(*token != "(" || list >= arities.size()) continue;
+                std::list<std::string>::const_iterator name = std::next(token);
+                std::string callee = name == call->callargumentlist.end() ? std::string() : *name;
+                if(arities[list] >= 0){
+                    //f<T>(x) names f ahead of its template arguments
+                    if(callee.empty()) callee = genericName;
+                    if(!callee.empty()) index.AddCall(callee, arities[list]);
+                    genericName.clear();
+                }else{
+                    genericName = callee;
+                }
+                ++list;
+            }
+            delete call;
+            arities.clear();
+            for(ArgumentList & open : argumentLists){
+                open.arity = -1;
+            }
+        }
+        const SymbolIndex & Index() const {
+            return index;
+        }
+    protected:
+        void * DataInner() const override {
+            return (void *)&index;
+        }
+    private:
+        /* the name of a namespace, class or struct */
+        struct Scope{
+            Scope() : fresh(false) {}
+            std::string name;
+            //tokens have been added since the last scope's block opened at this position
+            bool fresh;
+        };
+        struct Function{
+            Function() : nameDepth(0) {}
+            std::string name;
+            //depth of the function's own name element while it is open, 0 otherwise
+            std::size_t nameDepth;
+        };
+        struct ArgumentList{
+            std::size_t depth;
+            //index into arities, -1 when not counted
+            int arity;
+        };
+        CallPolicy callpolicy;
+        FunctionSignaturePolicy signaturepolicy;
+        SymbolIndex index;
+        //enclosing functions with their names as written, innermost last
+        std::vector<Function> functions;
+        //scope names by position in the element stack; stale past the open scopes
+        std::vector<Scope> scopes;
+        std::vector<ArgumentList> argumentLists;
+        //arguments of each argument list opened since CallPolicy last notified, -1 if not a call's
+        std::vector<int> arities;
+
+        static bool IsScope(srcSAXEventDispatch::ElementId element){
+            return element == srcSAXEventDispatch::ElementId::namespacen || element == srcSAXEventDispatch::ElementId::classn || element == srcSAXEventDispatch::ElementId::structn;
+        }
+        Scope & ScopeAt(std::size_t position){
+            if(scopes.size() <= position) scopes.resize(position + 1);
+            return scopes[position];
+        }
+
+        void InitializeEventHandlers(){
+            using namespace srcSAXEventDispatch;
+            //calls anywhere in the archive; signatures of the outermost function and those nested in it
+            openEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx) {
+                ctx.dispatcher->AddListenerDispatch(&callpolicy);
+            };
+            closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx) {
+                ctx.dispatcher->RemoveListenerDispatch(&callpolicy);
+                index.Resolve();
+                NotifyAll(ctx);
+            };
+            std::function<void(srcSAXEventContext&)> openFunction = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()) ctx.dispatcher->AddListenerDispatch(&signaturepolicy);
+                functions.push_back(Function());
+            };
+            std::function<void(srcSAXEventContext&)> closeFunction = [this](srcSAXEventContext& ctx) {
+                if(functions.empty()) return;
+                functions.pop_back();
+                if(functions.empty()) ctx.dispatcher->RemoveListenerDispatch(&signaturepolicy);
+            };
+            openEventMap[ParserState::function] = openFunction;
+            openEventMap[ParserState::constructor] = openFunction;
+            openEventMap[ParserState::destructor] = openFunction;
+            closeEventMap[ParserState::function] = closeFunction;
+            closeEventMap[ParserState::constructor] = closeFunction;
+            closeEventMap[ParserState::destructor] = closeFunction;
+            //a function's name is the name directly under it, not those of its member initializers
+            openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(functions.empty() || !functions.back().name.empty() || functions.back().nameDepth) return;
+                if(ctx.Parent(1) == ElementId::function || ctx.Parent(1) == ElementId::constructor || ctx.Parent(1) == ElementId::destructor) functions.back().nameDepth = ctx.depth;
+            };
+            closeEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
+                if(!functions.empty() && functions.back().nameDepth == ctx.depth) functions.back().nameDepth = 0;
+            };
+            openEventMap[ParserState::block] = [this](srcSAXEventContext& ctx) {
+                //a scope's name is complete; without tokens it is anonymous
+                if(!IsScope(ctx.Parent(1))) return;
+                Scope & scope = ScopeAt(ctx.elementIds.size() - 2);
+                if(!scope.fresh) scope.name.clear();
+                scope.fresh = false;
+            };
+
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(!ctx.IsOpen(ParserState::name) || ctx.IsOpen(ParserState::genericargumentlist)) return;
+                if(!functions.empty() && functions.back().nameDepth){
+                    functions.back().name += ctx.currentToken;
+                }
+                //the name of a scope: tokens of names and operators directly under it
+                std::size_t k = 0;
+                while(ctx.Parent(k) == ElementId::name || ctx.Parent(k) == ElementId::op) ++k;
+                if(k && IsScope(ctx.Parent(k))){
+                    Scope & scope = ScopeAt(ctx.elementIds.size() - 1 - k);
+                    if(!scope.fresh) scope.name.clear();
+                    scope.fresh = true;
+                    scope.name += ctx.currentToken;
+                }
+            };
+
+            openEventMap[ParserState::argumentlist] = [this](srcSAXEventContext& ctx) {
+                ArgumentList list = { ctx.depth, -1 };
+                if(ctx.Parent(1) == ElementId::call) list.arity = arities.size();
+                arities.push_back(list.arity < 0 ? -1 : 0);
+                argumentLists.push_back(list);
+            };
+            closeEventMap[ParserState::argumentlist] = [this](srcSAXEventContext& ctx) {
+                if(!argumentLists.empty() && argumentLists.back().depth == ctx.depth) argumentLists.pop_back();
+            };
+            openEventMap[ParserState::argument] = [this](srcSAXEventContext& ctx) {
+                if(!argumentLists.empty() && argumentLists.back().depth + 1 == ctx.depth && argumentLists.back().arity >= 0) ++arities[argumentLists.back().arity];
+            };
+        }
+};
+
+#endif
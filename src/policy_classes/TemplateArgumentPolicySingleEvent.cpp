@@ -62,6 +62,19 @@ TemplateArgumentPolicy::~TemplateArgumentPolicy() {
 
 }
 
+void TemplateArgumentPolicy::Reset() {
+
+    EventListener::Reset();
+
+    if(namePolicy) namePolicy->Reset();
+
+    data = TemplateArgumentPolicy::TemplateArgumentData{};
+    argumentDepth = 0;
+
+    InitializeTemplateArgumentPolicyHandlers();
+
+}
+
 void TemplateArgumentPolicy::Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) {
 
     data.data.back().first = policy->Data<NamePolicy::NameData>();
@@ -113,8 +126,7 @@ void TemplateArgumentPolicy::CollectNamesHandler() {
     openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
 
         // C++ has depth of 2 others 1
-        std::size_t elementStackSize = ctx.elementStack.size();
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && elementStackSize > 1 && ctx.elementStack[elementStackSize - 2] == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Parent(1) == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             data.data.push_back(std::make_pair(nullptr, TemplateArgumentPolicy::NAME));
@@ -133,8 +145,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
     openEventMap[ParserState::literal] = [this](srcSAXEventContext& ctx) {
 
         // C++ has depth of 2 others 1
-        std::size_t elementStackSize = ctx.elementStack.size();
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && elementStackSize > 1 && ctx.elementStack[elementStackSize - 2] == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Parent(1) == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             data.data.push_back(std::make_pair(new std::string(), LITERAL));
@@ -148,7 +159,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
 
     closeEventMap[ParserState::literal] = [this](srcSAXEventContext& ctx) {
 
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.elementStack.back() == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Element() == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             NopCloseEvents({ParserState::tokenstring});
@@ -160,8 +171,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
     openEventMap[ParserState::op] = [this](srcSAXEventContext& ctx) {
 
         // C++ has depth of 2 others 1
-        std::size_t elementStackSize = ctx.elementStack.size();
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && elementStackSize > 1 && ctx.elementStack[elementStackSize - 2] == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Parent(1) == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             data.data.push_back(std::make_pair(new std::string(), OPERATOR));
@@ -175,7 +185,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
 
     closeEventMap[ParserState::op] = [this](srcSAXEventContext& ctx) {
 
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.elementStack.back() == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Element() == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             NopCloseEvents({ParserState::tokenstring});
@@ -187,8 +197,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
     openEventMap[ParserState::modifier] = [this](srcSAXEventContext& ctx) {
 
         // C++ has depth of 2 others 1
-        std::size_t elementStackSize = ctx.elementStack.size();
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && elementStackSize > 1 && ctx.elementStack[elementStackSize - 2] == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Parent(1) == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             data.data.push_back(std::make_pair(nullptr, MODIFIER));
@@ -209,7 +218,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
 
     closeEventMap[ParserState::modifier] = [this](srcSAXEventContext& ctx) {
 
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.elementStack.back() == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Element() == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             NopCloseEvents({ParserState::tokenstring});
@@ -221,8 +230,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
     openEventMap[ParserState::call] = [this](srcSAXEventContext& ctx) {
 
         // C++ has depth of 2 others 1
-        std::size_t elementStackSize = ctx.elementStack.size();
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && elementStackSize > 1 && ctx.elementStack[elementStackSize - 2] == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Parent(1) == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             data.data.push_back(std::make_pair(new std::string(), CALL));
@@ -236,7 +244,7 @@ void TemplateArgumentPolicy::CollectOthersHandler() {
 
     closeEventMap[ParserState::call] = [this](srcSAXEventContext& ctx) {
 
-        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.elementStack.back() == "expr")
+        if(     argumentDepth && (((argumentDepth + 2) == ctx.depth && ctx.Element() == ElementId::expr)
             || (argumentDepth + 1) == ctx.depth)) {
 
             NopCloseEvents({ParserState::tokenstring});
@@ -44,6 +44,7 @@ public:
     public:
         TemplateArgumentPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners);
         ~TemplateArgumentPolicy();
+        virtual void Reset() override;
         virtual void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override;
     protected:
         virtual void * DataInner() const override;
@@ -90,6 +90,19 @@ TypePolicy::~TypePolicy(){
 
 }
 
+void TypePolicy::Reset() {
+
+    EventListener::Reset();
+
+    if(namePolicy) namePolicy->Reset();
+
+    data = TypePolicy::TypeData{};
+    typeDepth = 0;
+
+    InitializeTypePolicyHandlers();
+
+}
+
 void TypePolicy::Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) {
 
     data.types.back().first = policy->Data<NamePolicy::NameData>();
@@ -112,6 +125,7 @@ void TypePolicy::InitializeTypePolicyHandlers() {
             typeDepth = ctx.depth;
             data = TypePolicy::TypeData{};
 
+            SetDepthAnchor(typeDepth);
             CollectNamesHandler();
             CollectModifersHandler();
             CollectSpecifiersHandler();
@@ -128,6 +142,7 @@ void TypePolicy::InitializeTypePolicyHandlers() {
             typeDepth = 0;
 
             NotifyAll(ctx);
+            ClearDepthEvents();
             InitializeTypePolicyHandlers();
 
         }
@@ -139,83 +154,63 @@ void TypePolicy::InitializeTypePolicyHandlers() {
 void TypePolicy::CollectNamesHandler() {
     using namespace srcSAXEventDispatch;
 
-    openEventMap[ParserState::name] = [this](srcSAXEventContext& ctx) {
-
-        if(typeDepth && (typeDepth + 1) == ctx.depth) {
+    OpenEventAtDepth(ParserState::name, 1, [this](srcSAXEventContext& ctx) {
 
-            data.types.push_back(std::make_pair(nullptr, TypePolicy::NAME));
-            if(!namePolicy) namePolicy = new NamePolicy{this};
-            ctx.dispatcher->AddListenerDispatch(namePolicy);
+        data.types.push_back(std::make_pair(nullptr, TypePolicy::NAME));
+        if(!namePolicy) namePolicy = new NamePolicy{this};
+        ctx.dispatcher->AddListenerDispatch(namePolicy);
 
-        }
-
-    };
+    });
 
 }
 
 void TypePolicy::CollectModifersHandler() {
     using namespace srcSAXEventDispatch;
 
-    openEventMap[ParserState::modifier] = [this](srcSAXEventContext& ctx) {
-
-        if(typeDepth && (typeDepth + 1) == ctx.depth) {
-
-            data.types.push_back(std::make_pair(nullptr, NONE));
+    OpenEventAtDepth(ParserState::modifier, 1, [this](srcSAXEventContext& ctx) {
 
-            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+        data.types.push_back(std::make_pair(nullptr, NONE));
 
-                if(ctx.currentToken == "*")
-                    data.types.back().second = TypePolicy::POINTER;
-                else if(ctx.currentToken == "&")
-                    data.types.back().second = TypePolicy::REFERENCE;
-                else if(ctx.currentToken == "&&")
-                    data.types.back().second = TypePolicy::RVALUE;
+        closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
 
-            };
+            if(ctx.currentToken == "*")
+                data.types.back().second = TypePolicy::POINTER;
+            else if(ctx.currentToken == "&")
+                data.types.back().second = TypePolicy::REFERENCE;
+            else if(ctx.currentToken == "&&")
+                data.types.back().second = TypePolicy::RVALUE;
 
-        }
-
-    };
+        };
 
-    closeEventMap[ParserState::modifier] = [this](srcSAXEventContext& ctx) {
+    });
 
-        if(typeDepth && (typeDepth + 1) == ctx.depth) {
+    CloseEventAtDepth(ParserState::modifier, 1, [this](srcSAXEventContext& ctx) {
 
-            NopCloseEvents({ParserState::tokenstring});
+        NopCloseEvents({ParserState::tokenstring});
 
-        }
-
-    };
+    });
 
 }
 
 void TypePolicy::CollectSpecifiersHandler() {
     using namespace srcSAXEventDispatch;
 
-    openEventMap[ParserState::specifier] = [this](srcSAXEventContext& ctx) {
-
-        if(typeDepth && (typeDepth + 1) == ctx.depth) {
+    OpenEventAtDepth(ParserState::specifier, 1, [this](srcSAXEventContext& ctx) {
 
-            data.types.push_back(std::make_pair(new std::string(), TypePolicy::SPECIFIER));
+        data.types.push_back(std::make_pair(new std::string(), TypePolicy::SPECIFIER));
 
-            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+        closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
 
-                (*static_cast<std::string *>(data.types.back().first)) += ctx.currentToken;
+            (*static_cast<std::string *>(data.types.back().first)) += ctx.currentToken;
 
-            };
+        };
 
-        }
-
-    };
-
-    closeEventMap[ParserState::specifier] = [this](srcSAXEventContext& ctx) {
+    });
 
-        if(typeDepth && (typeDepth + 1) == ctx.depth) {
+    CloseEventAtDepth(ParserState::specifier, 1, [this](srcSAXEventContext& ctx) {
 
-            NopCloseEvents({ParserState::tokenstring});
+        NopCloseEvents({ParserState::tokenstring});
 
-        }
-
-    };
+    });
 
 }
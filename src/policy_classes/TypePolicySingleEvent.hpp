@@ -46,6 +46,7 @@ public:
     public:
         TypePolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners);
         ~TypePolicy();
+        virtual void Reset() override;
         virtual void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override;
     protected:
         virtual void * DataInner() const override;
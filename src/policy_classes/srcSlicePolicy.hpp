@@ -31,6 +31,14 @@ class srcSlicePolicy : public srcSAXEventDispatch::EventListener, public srcSAXE
             InitializeEventHandlers();
         }
         void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {} //doesn't use other parsers
+        void Reset() override {
+            EventListener::Reset();
+            data = DeclTypeData();
+            currentTypeName.clear();
+            currentDeclName.clear();
+            currentModifier.clear();
+            currentSpecifier.clear();
+        }
     protected:
         void * DataInner() const override {
             return new DeclTypeData(data);
@@ -0,0 +1,124 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <cassert>
+#include <set>
+#include <sstream>
+#include <srcml.h>
+/*
+    Allocation accounting needs the counting operator new in the library,
+    so this test only checks something when built with
+    SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS.
+*/
+#ifdef SRCSAX_EVENT_DISPATCH_ALLOCATION_HOOKS
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+class TestAllocations : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestAllocations(){}
+        TestAllocations(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){}
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+    protected:
+        void * DataInner() const override {
+            return (void*)0; //To silence the warning
+        }
+};
+
+class AllocatingListener : public srcSAXEventDispatch::EventListener{
+    public:
+        AllocatingListener(){
+            openEventMap[srcSAXEventDispatch::ParserState::classn] = [this](srcSAXEventDispatch::srcSAXEventContext& ctx){
+                names.push_back(std::string(64, 'x'));
+            };
+        }
+        std::vector<std::string> names;
+};
+
+class QuietListener : public srcSAXEventDispatch::EventListener{
+    public:
+        QuietListener() : classes(0){
+            openEventMap[srcSAXEventDispatch::ParserState::classn] = [this](srcSAXEventDispatch::srcSAXEventContext& ctx){
+                ++classes;
+            };
+        }
+        int classes;
+};
+
+void TestPolicyAndUnitAccounting(const std::string & srcmlstr){
+    TestAllocations listener;
+    std::ostringstream report;
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> handler{&listener};
+    handler.SetAllocationReport(&report);
+    control.parse(&handler); //Start parsing
+
+    const srcSAXEventDispatch::AllocationTracker & allocations = handler.GetAllocations();
+    assert(allocations.Policies().size() >= 1);
+    assert(allocations.Policies()[0].name == "ClassPolicy");
+    assert(allocations.Policies()[0].events > 0);
+    assert(allocations.Policies()[0].counters.allocations > 0);
+    assert(allocations.Units().size() == 1);
+    assert(allocations.Units()[0].filename == "testsrcType.cpp");
+    assert(allocations.Units()[0].counters.allocations >= allocations.Policies()[0].counters.allocations);
+    assert(report.str().find("ClassPolicy") != std::string::npos);
+}
+
+void TestStrictMode(const std::string & srcmlstr){
+    AllocatingListener * allocating = new AllocatingListener();
+    QuietListener * quiet = new QuietListener();
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<> handler({allocating, quiet}); //owns the listeners
+    handler.SetAllocationReport(nullptr);
+
+    std::multiset<std::string> violations;
+    handler.GetAllocations().MarkAllocationFree<AllocatingListener>();
+    handler.GetAllocations().MarkAllocationFree<QuietListener>();
+    handler.GetAllocations().SetStrict(true);
+    handler.GetAllocations().SetViolationHandler([&violations](const srcSAXEventDispatch::AllocationTracker::PolicyAllocations & policy,
+                                                               srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate,
+                                                               const srcSAXEventDispatch::AllocationCounters & counters){
+        assert(pstate == srcSAXEventDispatch::ParserState::classn);
+        assert(counters.bytes >= 64);
+        violations.insert(policy.name);
+    });
+    control.parse(&handler); //Start parsing
+
+    assert(quiet->classes == 2);
+    assert(violations.count("AllocatingListener") == 2);
+    assert(violations.count("QuietListener") == 0);
+}
+
+int main(int argc, char** filename){
+    std::string codestr = "class foo { int x; void bar() { baz(x); } }; class qux { };";
+    std::string srcmlstr = StringToSrcML(codestr);
+    TestPolicyAndUnitAccounting(srcmlstr);
+    TestStrictMode(srcmlstr);
+}
+#else
+int main(int argc, char** filename){
+    return 0;
+}
+#endif
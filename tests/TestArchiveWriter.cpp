@@ -0,0 +1,255 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <srcMLWriter.hpp>
+#include <ClassPolicy.hpp>
+#include <libxml/xmlwriter.h>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <random>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/*
+    Reference output: the xmlTextWriter calls the dispatcher used to make,
+    including the srcML convention of writing " unescaped in content.
+*/
+class ReferenceWriter {
+    public:
+        ReferenceWriter(){
+            buffer = xmlBufferCreate();
+            writer = xmlNewTextWriter(xmlOutputBufferCreateBuffer(buffer, NULL));
+        }
+        ~ReferenceWriter(){
+            xmlFreeTextWriter(writer);
+            xmlBufferFree(buffer);
+        }
+        void StartDocument(){ xmlTextWriterStartDocument(writer, "1.0", "UTF-8", "yes"); }
+        void EndDocument(){ xmlTextWriterEndDocument(writer); }
+        void StartElement(const char * prefix, const char * name){ xmlTextWriterStartElementNS(writer, (const xmlChar *)prefix, (const xmlChar *)name, 0); }
+        void EndElement(){ xmlTextWriterEndElement(writer); }
+        void WriteAttributeNS(const char * prefix, const char * name, const char * uri, const char * value){
+            xmlTextWriterWriteAttributeNS(writer, (const xmlChar *)prefix, (const xmlChar *)name, (const xmlChar *)uri, (const xmlChar *)value);
+        }
+        void WriteString(std::string text){
+            std::string::size_type start = 0, pos;
+            while((pos = text.find('"', start)) != std::string::npos){
+                xmlTextWriterWriteString(writer, (const xmlChar *)text.substr(start, pos - start).c_str());
+                xmlTextWriterWriteRaw(writer, (const xmlChar *)"\"");
+                start = pos + 1;
+            }
+            xmlTextWriterWriteString(writer, (const xmlChar *)text.substr(start).c_str());
+        }
+        std::string Output(){
+            xmlTextWriterFlush(writer);
+            return std::string((const char *)xmlBufferContent(buffer), xmlBufferLength(buffer));
+        }
+    private:
+        xmlBufferPtr buffer;
+        xmlTextWriterPtr writer;
+};
+
+std::string RandomText(std::mt19937 & random){
+    static const char * pieces[] = { "a", "xyz", " ", "<", ">", "&", "\"", "'", "\t", "\r", "\n", ";", "\xc3\xa9" };
+    std::string text;
+    std::size_t length = random() % 40;
+    for(std::size_t count = 0; count < length; ++count){
+        text += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    return text;
+}
+
+void TestWriterMatchesReference(){
+    std::mt19937 random(42);
+    for(int run = 0; run < 200; ++run){
+        srcSAXEventDispatch::srcMLWriter writer;
+        ReferenceWriter reference;
+        writer.StartDocument();
+        reference.StartDocument();
+        writer.StartElement(0, "unit");
+        reference.StartElement(0, "unit");
+        int depth = 1;
+        for(int step = 0; step < 60; ++step){
+            switch(random() % 5){
+                case 0: {
+                    const char * prefix = random() % 3 ? 0 : "cpp";
+                    writer.StartElement(prefix, "name");
+                    reference.StartElement(prefix, "name");
+                    ++depth;
+                    if(random() % 2){
+                        std::string value = RandomText(random);
+                        writer.WriteAttributeNS("pos", "line", "http://www.srcML.org/srcML/position", value.c_str());
+                        reference.WriteAttributeNS("pos", "line", "http://www.srcML.org/srcML/position", value.c_str());
+                    }
+                    if(random() % 2){
+                        std::string value = RandomText(random);
+                        writer.WriteAttributeNS(0, "filename", 0, value.c_str());
+                        reference.WriteAttributeNS(0, "filename", 0, value.c_str());
+                    }
+                    break;
+                }
+                case 1:
+                case 2: {
+                    std::string text = RandomText(random);
+                    if(text.empty()) break;
+                    writer.WriteString(text);
+                    reference.WriteString(text);
+                    break;
+                }
+                default:
+                    if(depth == 1) break;
+                    writer.EndElement();
+                    reference.EndElement();
+                    --depth;
+                    break;
+            }
+        }
+        writer.EndDocument();
+        reference.EndDocument();
+        assert(writer.Buffer() == reference.Output());
+    }
+}
+
+class TestArchive : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestArchive(){}
+        TestArchive(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){}
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+    protected:
+        void * DataInner() const override {
+            return (void*)0; //To silence the warning
+        }
+};
+
+void TestDispatcherArchive(){
+    std::string codestr = "class foo { void bar() { baz(\"a<b\", c & d); } };";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestArchive listener;
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> handler{&listener, true};
+    control.parse(&handler); //Start parsing
+
+    const std::string & archive = handler.GetArchive();
+    assert(archive.find("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n") == 0);
+    assert(archive.find("filename=\"testsrcType.cpp\"") != std::string::npos);
+    assert(archive.find("\"a&lt;b\"") != std::string::npos);
+    assert(archive.find("&amp;") != std::string::npos);
+    assert(archive.compare(archive.size() - 8, 8, "</unit>\n") == 0);
+}
+
+/* leaves output in the writer that has not been flushed */
+class PendingDispatcher : public srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> {
+    public:
+        PendingDispatcher(srcSAXEventDispatch::PolicyListener * listener, srcSAXEventDispatch::srcMLWriter * writer) : srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy>(listener, writer) {}
+        void Pending() { ctx.writer->WriteString("pending"); }
+};
+
+/* a failing sink throws from Flush and SetArchiveWriter, never from a destructor */
+void TestWriterErrors(){
+    srcSAXEventDispatch::srcMLWriter::Sink failing = [](const char *, std::size_t) { throw std::runtime_error("sink failed"); };
+
+    bool threw = false;
+    {
+        srcSAXEventDispatch::srcMLWriter writer(failing);
+        writer.WriteString("text");
+        try { writer.Flush(); } catch(const std::runtime_error &) { threw = true; }
+    }
+    assert(threw);
+
+    //a descriptor open for reading only cannot be written
+    int fd = open("/dev/null", O_RDONLY);
+    assert(fd >= 0);
+    {
+        srcSAXEventDispatch::srcMLWriter writer(fd);
+        writer.StartDocument();
+        writer.StartElement(0, "unit");
+    }
+    close(fd);
+
+    TestArchive listener;
+    PendingDispatcher handler(&listener, new srcSAXEventDispatch::srcMLWriter(failing));
+    handler.Pending();
+    threw = false;
+    try { handler.SetArchiveWriter(new srcSAXEventDispatch::srcMLWriter()); } catch(const std::runtime_error &) { threw = true; }
+    assert(threw);
+    //the dispatcher still owns the failing writer and destroys it quietly
+}
+
+/* exposes the deprecated accessor of the former ctx.archiveBuffer field */
+class LegacyDispatcher : public srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> {
+    public:
+        LegacyDispatcher(srcSAXEventDispatch::PolicyListener * listener) : srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy>(listener, true) {}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+        xmlBufferPtr ArchiveBuffer() { return ctx.ArchiveBuffer(); }
+#pragma GCC diagnostic pop
+};
+
+void TestLegacyArchiveBuffer(){
+    std::string srcmlstr = StringToSrcML("int a;");
+
+    TestArchive listener;
+    LegacyDispatcher handler(&listener);
+    srcSAXController control(srcmlstr);
+    control.parse(&handler);
+
+    xmlBufferPtr buffer = handler.ArchiveBuffer();
+    assert(buffer);
+    assert(std::string((const char *)xmlBufferContent(buffer), xmlBufferLength(buffer)) == handler.GetArchive());
+}
+
+void TestStreamingArchive(){
+    std::string codestr = "int a; void foo() { a = 1; }";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestArchive listener;
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> memory{&listener, true};
+    srcSAXController memorycontrol(srcmlstr);
+    memorycontrol.parse(&memory);
+
+    std::string streamed;
+    int flushes = 0;
+    srcSAXEventDispatch::srcMLWriter * writer = new srcSAXEventDispatch::srcMLWriter([&streamed, &flushes](const char * data, std::size_t size){
+        streamed.append(data, size);
+        ++flushes;
+    });
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> streaming{&listener, writer};
+    srcSAXController streamingcontrol(srcmlstr);
+    streamingcontrol.parse(&streaming);
+
+    assert(streamed == memory.GetArchive());
+    assert(streaming.GetArchive().empty());
+    assert(flushes >= 1);
+}
+
+int main(int argc, char** filename){
+    TestWriterMatchesReference();
+    TestDispatcherArchive();
+    TestStreamingArchive();
+    TestLegacyArchiveBuffer();
+    TestWriterErrors();
+}
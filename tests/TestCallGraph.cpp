@@ -0,0 +1,88 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <CallGraphPolicy.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+	struct srcml_archive* archive;
+	struct srcml_unit* unit;
+	size_t size = 0;
+
+	char *ch = new char[str.size()];
+
+	archive = srcml_archive_create();
+	srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+	srcml_archive_write_open_memory(archive, &ch, &size);
+
+	unit = srcml_unit_create(archive);
+	srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+	srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+	srcml_unit_parse_memory(unit, str.c_str(), str.size());
+	srcml_archive_write_unit(archive, unit);
+	
+	srcml_unit_free(unit);
+	srcml_archive_close(archive);
+	srcml_archive_free(archive);
+	//TrimFromEnd(ch, size);
+	return std::string(ch);
+}
+
+class TestGraph : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestGraph(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            ++notifications;
+            edges = policy->Data<CallGraph>()->NumberEdges();
+        }
+        std::size_t notifications = 0;
+        std::size_t edges = 0;
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "void leaf(){}\nint mid(int a){ leaf(); return a; }\nvoid top(){ mid(1); mid(2); obj.leaf(); }\nvoid N::twice(){ top(); helper(mid(3)); }";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestGraph listener;
+    CallGraphPolicy * policy = new CallGraphPolicy{&listener}; //owned by the dispatcher
+    srcSAXEventDispatch::srcSAXEventDispatcher<> dispatcher({policy}, nullptr);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+    assert(listener.notifications == 1);
+    assert(listener.edges == 6);
+
+    const CallGraph & graph = policy->Graph();
+    assert(graph.NumberNodes() == 5);
+    assert((graph.Callees("top") == std::vector<std::string>{"mid", "leaf"}));
+    assert(graph.Calls("top", "mid") == 2 && graph.Calls("top", "leaf") == 1 && graph.Calls("leaf", "top") == 0);
+    assert(graph.FanOut("twice") == 3 && graph.FanIn("mid") == 2 && graph.FanIn("twice") == 0);
+    assert(graph.FanOut("leaf") == 0 && graph.FanOut("unknown") == 0);
+    assert((graph.Callers("leaf") == std::vector<std::string>{"mid", "top"}));
+    assert((graph.Reachable("twice") == std::vector<std::string>{"mid", "top", "helper", "leaf"}));
+    assert((graph.Reachable("leaf", true) == std::vector<std::string>{"mid", "top", "twice"}));
+
+    //calls in constructors and destructors are attributed to them by unqualified name
+    {
+        std::string structors = StringToSrcML("Foo::Foo(int x){ init(x); }\nFoo::~Foo(){ release(); }\nvoid make(){ Foo(1); }");
+        TestGraph structorListener;
+        CallGraphPolicy * structorPolicy = new CallGraphPolicy{&structorListener};
+        srcSAXEventDispatch::srcSAXEventDispatcher<> structorDispatcher({structorPolicy}, nullptr);
+        srcSAXController structorControl(structors);
+        structorControl.parse(&structorDispatcher);
+        const CallGraph & structorGraph = structorPolicy->Graph();
+        assert(structorListener.edges == 3);
+        assert((structorGraph.Callees("Foo") == std::vector<std::string>{"init"}));
+        assert((structorGraph.Callees("~Foo") == std::vector<std::string>{"release"}));
+        assert((structorGraph.Reachable("make") == std::vector<std::string>{"Foo", "init"}));
+    }
+
+    //edges added after Build are seen at the next Build
+    CallGraph cycle;
+    cycle.AddCall("a", "b");
+    cycle.AddCall("b", "a");
+    cycle.Build();
+    cycle.AddCall("b", "c");
+    assert((cycle.Reachable("a") == std::vector<std::string>{"b", "a"}));
+    cycle.Build();
+    assert((cycle.Reachable("a") == std::vector<std::string>{"b", "a", "c"}));
+}
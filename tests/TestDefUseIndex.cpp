@@ -0,0 +1,107 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <DefUseIndexPolicy.hpp>
+#include <cassert>
+#include <sstream>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+	struct srcml_archive* archive;
+	struct srcml_unit* unit;
+	size_t size = 0;
+
+	char *ch = new char[str.size()];
+
+	archive = srcml_archive_create();
+	srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+	srcml_archive_write_open_memory(archive, &ch, &size);
+
+	unit = srcml_unit_create(archive);
+	srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+	srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+	srcml_unit_parse_memory(unit, str.c_str(), str.size());
+	srcml_archive_write_unit(archive, unit);
+	
+	srcml_unit_free(unit);
+	srcml_archive_close(archive);
+	srcml_archive_free(archive);
+	//TrimFromEnd(ch, size);
+	return std::string(ch);
+}
+
+class TestDefUse : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestDefUse(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            ++notifications;
+            std::ostringstream out;
+            policy->Data<DefUseIndex>()->Save(out);
+            image = out.str();
+        }
+        std::size_t notifications = 0;
+        std::string image;
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "int f(int a){\nint b;\nb = a + 1;\na = b;\n}\nvoid S::g(){ int a; a = 2; }\nFoo::Foo(int x) : bar(x) { y = x; }";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestDefUse defuse;
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<DefUseIndexPolicy> handler {&defuse};
+    control.parse(&handler);
+    assert(defuse.notifications == 1);
+
+    //queried from the saved image, without the parse
+    DefUseIndex index;
+    std::istringstream in(defuse.image);
+    index.Load(in);
+    const std::string file = "testsrcType.cpp";
+    assert(index.size() == 5);
+    assert((index.Functions(file) == std::vector<std::string>{"f", "S::g", "Foo::Foo"}));
+    assert((index.Identifiers(file, "f") == std::vector<std::string>{"a", "b"}));
+    assert((index.Definitions(file, "f", "a") == std::vector<unsigned int>{1, 4}));
+    assert((index.Uses(file, "f", "a") == std::vector<unsigned int>{3}));
+    assert((index.Definitions(file, "f", "b") == std::vector<unsigned int>{2, 3}));
+    assert((index.Uses(file, "f", "b") == std::vector<unsigned int>{4}));
+    assert((index.Definitions(file, "S::g", "a") == std::vector<unsigned int>{6}));
+    assert(index.Uses(file, "S::g", "a").empty());
+    assert(!index.Contains(file, "g", "a"));
+    //a constructor is named by its own name, not its member initializers
+    assert((index.Identifiers(file, "Foo::Foo") == std::vector<std::string>{"x", "y"}));
+    assert((index.Definitions(file, "Foo::Foo", "x") == std::vector<unsigned int>{7}));
+    assert((index.Uses(file, "Foo::Foo", "x") == std::vector<unsigned int>{7}));
+    assert((index.Definitions(file, "Foo::Foo", "y") == std::vector<unsigned int>{7}));
+
+    std::ostringstream again;
+    index.Save(again);
+    assert(again.str() == defuse.image);
+
+    bool threw = false;
+    std::istringstream truncated(defuse.image.substr(0, defuse.image.size() / 2));
+    try{
+        index.Load(truncated);
+    }catch(const std::runtime_error &){
+        threw = true;
+    }
+    assert(threw);
+
+    //sizes past the end of the image are refused before anything is allocated for them
+    const std::string header = defuse.image.substr(0, 5);
+    for(const std::string & corrupt : {header + "\xff\xff\xff\xff\xff\xff\xff\x7f", header + "\x01\xff\xff\xff\xff\x0f" + "x"}){
+        std::istringstream oversized(corrupt);
+        threw = false;
+        try{
+            index.Load(oversized);
+        }catch(const std::runtime_error &){
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    DefUseIndex lines;
+    for(unsigned int line : {100u, 3u, 3u, 70000u, 1u}){
+        lines.AddUse("x.cpp", "", "v", line);
+    }
+    assert((lines.Uses("x.cpp", "", "v") == std::vector<unsigned int>{100, 3, 70000, 1}));
+}
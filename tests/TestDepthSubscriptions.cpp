@@ -0,0 +1,75 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/* counts member declarations (decl_stmt at class + 3) through a depth-scoped subscription */
+class MemberCounter : public srcSAXEventDispatch::EventListener {
+    public:
+        MemberCounter() : classDepth(0), members(0), otherDecls(0) {
+            using namespace srcSAXEventDispatch;
+
+            openEventMap[ParserState::classn] = [this](srcSAXEventContext& ctx) {
+                if(classDepth) return;
+                classDepth = ctx.depth;
+                SetDepthAnchor(classDepth);
+                OpenEventAtDepth(ParserState::declstmt, 3, [this](srcSAXEventContext& ctx) {
+                    assert(ctx.depth == classDepth + 3);
+                    ++members;
+                });
+            };
+
+            closeEventMap[ParserState::classn] = [this](srcSAXEventContext& ctx) {
+                if(classDepth != ctx.depth) return;
+                classDepth = 0;
+                ClearDepthEvents();
+            };
+
+            /* unscoped handler still runs at every other depth */
+            openEventMap[ParserState::declstmt] = [this](srcSAXEventContext& ctx) {
+                ++otherDecls;
+            };
+        }
+        std::size_t classDepth, members, otherDecls;
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "class foo { int x; int y; void bar() { int z; } }; int w;";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    MemberCounter * counter = new MemberCounter();
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<> handler{counter};
+    control.parse(&handler); //Start parsing
+
+    assert(counter->members == 2);
+    assert(counter->otherDecls == 2);
+    assert(counter->FindHandler(srcSAXEventDispatch::ParserState::declstmt, srcSAXEventDispatch::ElementState::open, 4) != nullptr);
+
+    handler.Reset();
+    assert(counter->FindHandler(srcSAXEventDispatch::ParserState::expr, srcSAXEventDispatch::ElementState::close, 0) != nullptr);
+}
@@ -0,0 +1,80 @@
+#ifndef SRCSAX_EVENT_DISPATCH_PROFILE
+#define SRCSAX_EVENT_DISPATCH_PROFILE
+#endif
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <cassert>
+#include <sstream>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+class TestProfile : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestProfile(){}
+        TestProfile(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){}
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+    protected:
+        void * DataInner() const override {
+            return (void*)0; //To silence the warning
+        }
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "class foo { int x; void bar() { baz(x); } }; class qux { };";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestProfile listener;
+    std::ostringstream table, json;
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> handler{&listener};
+    handler.SetProfileOutput(&table, &json);
+    control.parse(&handler); //Start parsing
+
+    const srcSAXEventDispatch::DispatchProfile & profile = handler.GetProfile();
+    assert(profile.Event(srcSAXEventDispatch::ParserState::classn, srcSAXEventDispatch::ElementState::open).count == 2);
+    assert(profile.Event(srcSAXEventDispatch::ParserState::classn, srcSAXEventDispatch::ElementState::close).count == 2);
+    assert(profile.TotalEvents() == handler.GetStats().eventsDispatched);
+
+    bool sawClassPolicy = false;
+    for(const srcSAXEventDispatch::DispatchProfile::ListenerProfile & data : profile.Listeners()){
+        assert(data.calls == data.handled + data.nop + data.missing + data.suppressed);
+        if(data.name == "ClassPolicy"){
+            sawClassPolicy = true;
+            assert(data.handled > 0);
+            assert(data.nop > 0);
+        }
+    }
+    assert(sawClassPolicy);
+
+    assert(table.str().find("classn") != std::string::npos);
+    assert(json.str().find("{\"events\":[") == 0);
+    assert(json.str().find("\"name\":\"ClassPolicy\"") != std::string::npos);
+
+    handler.Reset();
+    assert(profile.TotalEvents() == 0);
+    assert(profile.Listeners().empty());
+}
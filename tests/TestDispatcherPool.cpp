@@ -0,0 +1,105 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXEventDispatcherPool.hpp>
+#include <srcSAXEventRecorder.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+/* the events of every unit and a summary of every class reported */
+class PoolListener : public srcSAXEventDispatch::RecordingListener {
+    public:
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            if(!dynamic_cast<const ClassPolicy *>(policy)){
+                RecordingListener::Notify(policy, ctx);
+                return;
+            }
+            std::unique_ptr<std::vector<ClassPolicy::ClassData>> data(policy->Data<std::vector<ClassPolicy::ClassData>>());
+            for(const ClassPolicy::ClassData & classData : *data){
+                std::string summary = ctx.currentFilePath + ":" + classData.className + (classData.isStruct ? " struct" : " class");
+                for(const FunctionSignaturePolicy::SignatureData & method : classData.methods) summary += " " + method.name;
+                summary += " members " + std::to_string(classData.members.size());
+                classes.push_back(summary);
+            }
+        }
+        void Clear() {
+            RecordingListener::Clear();
+            classes.clear();
+        }
+        std::vector<std::string> classes;
+};
+
+typedef srcSAXEventDispatch::srcSAXEventDispatcher<srcSAXEventDispatch::EventRecorderPolicy, ClassPolicy> Dispatcher;
+
+/* what a dispatcher built for this document alone produces */
+void Fresh(const std::string & srcmlstr, PoolListener & listener, std::string & archive){
+    Dispatcher dispatcher(&listener, true);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+    archive = dispatcher.GetArchive();
+}
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    std::vector<std::string> documents = {
+        StringsToSrcMLArchive({"class foo { int x; void bar() { baz(x); } };", "struct point { int x, y; };"}),
+        StringsToSrcMLArchive({"namespace n { class widget { public: void draw(); private: int width; }; }"}),
+    };
+
+    std::vector<PoolListener> expected(documents.size());
+    std::vector<std::string> expectedArchives(documents.size());
+    for(std::size_t document = 0; document < documents.size(); ++document){
+        Fresh(documents[document], expected[document], expectedArchives[document]);
+        assert(!expected[document].classes.empty());
+    }
+    assert(expected[0].classes != expected[1].classes);
+
+    PoolListener pooled;
+    srcSAXEventDispatcherPool<Dispatcher> pool([&pooled]() { return new Dispatcher(&pooled, true); }, 1);
+
+    /* each document, then the first again, through the one pooled dispatcher */
+    Dispatcher * first = nullptr;
+    for(std::size_t document : {0, 1, 0}){
+        pooled.Clear();
+        {
+            srcSAXEventDispatcherPool<Dispatcher>::Lease dispatcher = pool.Acquire();
+            if(!first) first = dispatcher.get();
+            assert(dispatcher.get() == first);
+            assert(pool.Idle() == 0);
+            srcSAXController control(documents[document]);
+            control.parse(dispatcher.get());
+            assert(dispatcher->GetArchive() == expectedArchives[document]);
+        }
+        assert(pool.Size() == 1 && pool.Idle() == 1);
+        assert(pooled.classes == expected[document].classes);
+        assert(CompareRecordings(expected[document].recordings, pooled.recordings, RecordingComparison::ordered, std::cerr));
+    }
+}
@@ -0,0 +1,83 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/* checks the interned element stack against the string stack at every event */
+class ElementStackChecker : public srcSAXEventDispatch::EventListener {
+    public:
+        ElementStackChecker() : events(0), tokens(0), indexExprs(0), classes(0) {}
+        void HandleEvent(srcSAXEventDispatch::ParserState pstate, srcSAXEventDispatch::ElementState estate, srcSAXEventDispatch::srcSAXEventContext& ctx) override {
+            using namespace srcSAXEventDispatch;
+            if(dispatched) return;
+            dispatched = true;
+
+            ++events;
+            if(pstate == ParserState::tokenstring) ++tokens;
+            assert(ctx.elementIds.size() == ctx.elementStack.size());
+            for(std::size_t k = 0; k < ctx.elementStack.size(); ++k){
+                const std::string & name = ctx.ElementName(ctx.Parent(k));
+                const std::string & expected = ctx.elementStack[ctx.elementStack.size() - 1 - k];
+                assert(name == expected || name.substr(name.find(':') + 1) == expected);
+            }
+            assert(ctx.Parent(ctx.elementStack.size()) == ElementId::none);
+
+            if(pstate == ParserState::classn && estate == ElementState::open){
+                assert(ctx.Element() == ElementId::classn);
+                ++classes;
+            }
+            if(pstate == ParserState::expr && estate == ElementState::open && ctx.Parent(1) == ElementId::index){
+                ++indexExprs;
+            }
+        }
+        std::size_t events, tokens, indexExprs, classes;
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "class foo { int x[4]; void bar() { x[i + 1] = baz<int>(x); } }; struct qux { };";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    ElementStackChecker * checker = new ElementStackChecker();
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<> handler{checker};
+    control.parse(&handler); //Start parsing
+
+    assert(checker->events > 0);
+    //text is dispatched with the stack of the element it belongs to
+    assert(checker->tokens > 0);
+    assert(checker->classes == 1);
+    assert(checker->indexExprs == 2);
+
+    /* unlisted names are interned once per dispatcher */
+    srcSAXEventDispatch::ElementTable table;
+    srcSAXEventDispatch::ElementId id = table.Intern("cpp:define");
+    assert(id >= srcSAXEventDispatch::ElementId::MAXELEMENTID);
+    assert(table.Intern("cpp:define") == id);
+    assert(table.Name(id) == "cpp:define");
+    assert(table.Intern("class") == srcSAXEventDispatch::ElementId::classn);
+}
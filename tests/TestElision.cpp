@@ -0,0 +1,124 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <srcSAXTextUtilities.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/* the whitespace test, one byte at a time */
+bool ScalarWhitespace(const std::string & text){
+    for(char ch : text){
+        if(!srcSAXEventDispatch::IsWhitespaceChar(ch)) return false;
+    }
+    return true;
+}
+
+bool IsWhitespace(const std::string & text){
+    bool whitespace = srcSAXEventDispatch::IsWhitespace(text.data(), text.size());
+    assert(whitespace == ScalarWhitespace(text));
+    return whitespace;
+}
+
+/* counts the tokenstring and xmlattribute events it is dispatched */
+class TokenListener : public srcSAXEventDispatch::EventListener {
+    public:
+        TokenListener() {
+            using namespace srcSAXEventDispatch;
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(ScalarWhitespace(ctx.currentToken)) ++whitespace;
+                else tokens.push_back(ctx.currentToken);
+            };
+            closeEventMap[ParserState::xmlattribute] = [this](srcSAXEventContext& ctx) {
+                ++attributes;
+                if(ctx.currentAttributeName.compare(0, 4, "pos:") == 0) ++positionAttributes;
+            };
+        }
+        std::size_t whitespace = 0, attributes = 0, positionAttributes = 0;
+        std::vector<std::string> tokens;
+};
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    /* IsWhitespace agrees with the scalar test around the 16 byte SSE2 chunks */
+    assert(IsWhitespace(""));
+    assert(IsWhitespace(" \t\r\n"));
+    assert(IsWhitespace(std::string(16, ' ')));
+    assert(IsWhitespace(std::string(47, '\n')));
+    for(std::size_t length = 1; length <= 40; ++length){
+        for(std::size_t pos = 0; pos < length; ++pos){
+            std::string text(length, ' ');
+            for(std::size_t fill = 0; fill < length; ++fill) text[fill] = " \t\r\n"[fill % 4];
+            assert(IsWhitespace(text));
+            //not whitespace wherever the odd byte falls, in a chunk or in the tail
+            for(char odd : {'x', '\0', '\v', '\f', '\x80', '\xa0', '\x89', '\x8a', '\x8d'}){
+                text[pos] = odd;
+                assert(!IsWhitespace(text));
+            }
+        }
+    }
+    //an unaligned start, and a non-breaking space (UTF-8 c2 a0) after a full chunk
+    std::string spaces(40, ' ');
+    assert(IsWhitespace(spaces.substr(3)));
+    assert(!IsWhitespace(std::string(18, ' ') + "\xc2\xa0" + "  "));
+
+    /* elision drops whitespace tokens and position attributes and nothing else */
+    std::string codestr = "int x;\n\n                    \t\nint y; // \xc3\xa9\nx = y;\n";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TokenListener * plainListener = new TokenListener();
+    srcSAXEventDispatcher<> plain{plainListener};
+    srcSAXController plainControl(srcmlstr);
+    plainControl.parse(&plain);
+
+    TokenListener * elidedListener = new TokenListener();
+    srcSAXEventDispatcher<> elided{elidedListener};
+    elided.SetElision(true);
+    srcSAXController elidedControl(srcmlstr);
+    elidedControl.parse(&elided);
+
+    const DispatchStats & plainStats = plain.GetStats(), & elidedStats = elided.GetStats();
+    assert(plainStats.eventsElided == 0 && plainStats.whitespaceElided == 0 && plainStats.positionsElided == 0);
+    assert(plainStats.EventsBeforeElision() == plainStats.EventsAfterElision());
+
+    assert(plainListener->whitespace > 0);
+    assert(elidedListener->whitespace == 0);
+    assert(elidedStats.whitespaceElided == plainListener->whitespace);
+    assert(elidedListener->tokens == plainListener->tokens);
+    assert(std::find(elidedListener->tokens.begin(), elidedListener->tokens.end(), "// \xc3\xa9") != elidedListener->tokens.end());
+
+    //the position elements' attributes are what else was elided
+    assert(elidedStats.eventsElided == elidedStats.whitespaceElided + (plainListener->attributes - elidedListener->attributes));
+    assert(plainListener->attributes - elidedListener->attributes <= plainListener->positionAttributes);
+    assert(elidedStats.positionsElided == 0 || elidedStats.eventsElided > elidedStats.whitespaceElided);
+
+    //elided events are the only difference between the runs
+    assert(elidedStats.EventsBeforeElision() == plainStats.EventsAfterElision());
+    assert(elidedStats.EventsAfterElision() + elidedStats.eventsElided == plainStats.eventsDispatched);
+    assert(elidedStats.textNodes == plainStats.textNodes && elidedStats.elements == plainStats.elements);
+}
@@ -0,0 +1,97 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXParallelDispatcher.hpp>
+#include <srcSAXEventRecorder.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <cassert>
+#include <sstream>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+typedef srcSAXEventDispatch::srcSAXEventDispatcher<srcSAXEventDispatch::EventRecorderPolicy, ClassPolicy> Dispatcher;
+
+int main(int argc, char** filename){
+    std::vector<std::string> codestrs;
+    for(int count = 0; count < 10; ++count){
+        codestrs.push_back("class foo" + std::to_string(count) + " { int x; void bar() { baz(x); } };");
+    }
+    std::string srcmlstr = StringsToSrcMLArchive(codestrs);
+
+    srcSAXEventDispatch::RecordingListener reference;
+    {
+        Dispatcher dispatcher{&reference};
+        srcSAXController control(srcmlstr);
+        control.parse(&dispatcher);
+    }
+    std::size_t leaves = 0;
+    for(const srcSAXEventDispatch::UnitRecording & recording : reference.recordings){
+        if(recording.leaf) ++leaves;
+    }
+    assert(leaves == codestrs.size());
+    assert(reference.recordings.back().filename.empty());
+
+    /* a reused dispatcher sees the same events */
+    {
+        srcSAXEventDispatch::RecordingListener reused;
+        Dispatcher dispatcher{&reused};
+        srcSAXController first(srcmlstr);
+        first.parse(&dispatcher);
+        reused.Clear();
+        dispatcher.Reset();
+        srcSAXController second(srcmlstr);
+        second.parse(&dispatcher);
+
+        std::ostringstream report;
+        assert(srcSAXEventDispatch::CompareRecordings(reference.recordings, reused.recordings, srcSAXEventDispatch::RecordingComparison::ordered, report));
+        assert(report.str().empty());
+    }
+
+    /* the parallel driver sees the same events unit by unit */
+    {
+        srcSAXEventDispatch::RecordingListener parallel;
+        srcSAXEventDispatch::srcSAXParallelDispatcher<srcSAXEventDispatch::EventRecorderPolicy, ClassPolicy> dispatcher(&parallel, nullptr, 4);
+        dispatcher.Parse(srcmlstr);
+
+        std::ostringstream report;
+        assert(srcSAXEventDispatch::CompareRecordings(reference.recordings, parallel.recordings, srcSAXEventDispatch::RecordingComparison::per_unit, report));
+    }
+
+    /* elision drops whitespace and position events, which is reported */
+    {
+        srcSAXEventDispatch::RecordingListener elided;
+        Dispatcher dispatcher{&elided};
+        dispatcher.SetElision(true);
+        srcSAXController control(srcmlstr);
+        control.parse(&dispatcher);
+
+        std::ostringstream report;
+        assert(!srcSAXEventDispatch::CompareRecordings(reference.recordings, elided.recordings, srcSAXEventDispatch::RecordingComparison::ordered, report));
+        assert(report.str().find("first divergence in recording") == 0);
+        assert(report.str().find("reference: ") != std::string::npos);
+        assert(report.str().find("candidate: ") != std::string::npos);
+    }
+}
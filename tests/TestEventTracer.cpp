@@ -0,0 +1,69 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXEventTracer.hpp>
+#include <srcSAXHandler.hpp>
+#include <FunctionSignaturePolicy.hpp>
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+class TestTracer : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestTracer(){}
+        TestTracer(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){}
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {}
+    protected:
+        void * DataInner() const override {
+            return (void*)0; //To silence the warning
+        }
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "class foo {\n  void bar(int x) {\n    int y;\n  }\n};";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestTracer listener;
+    std::ostringstream trace;
+    {
+        srcSAXEventDispatch::srcSAXEventTracer tracer(trace);
+        srcSAXController control(srcmlstr);
+        srcSAXEventDispatch::srcSAXEventDispatcher<FunctionSignaturePolicy> handler{&listener};
+        handler.SetTracer(&tracer);
+        control.parse(&handler); //Start parsing
+    }
+
+    std::string json = trace.str();
+    assert(json.find("{\"traceEvents\":[") == 0);
+    assert(json.compare(json.size() - 2, 2, "}\n") == 0);
+    assert(json.find("\"name\":\"testsrcType.cpp\",\"cat\":\"unit\"") != std::string::npos);
+    assert(json.find("\"name\":\"class\",\"cat\":\"construct\"") != std::string::npos);
+    assert(json.find("\"name\":\"function\",\"cat\":\"construct\"") != std::string::npos);
+    assert(json.find("\"name\":\"decl_stmt\",\"cat\":\"construct\"") != std::string::npos);
+    assert(json.find("\"name\":\"ParamTypePolicy\",\"cat\":\"policy\"") != std::string::npos);
+    assert(json.find("\"file\":\"testsrcType.cpp\",\"line\":3") != std::string::npos);
+    assert(std::count(json.begin(), json.end(), '{') == std::count(json.begin(), json.end(), '}'));
+}
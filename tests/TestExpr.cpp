@@ -40,16 +40,35 @@ class TestExpr : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEven
             datatotest.push_back(exprdata);
         }
 		void RunTest(){
-			
+			assert(datatotest.size() == 6);
+			assert(Lines(datatotest[0], "j", true) == std::vector<unsigned int>{1});
+			assert(Lines(datatotest[1], "k", true) == std::vector<unsigned int>{2});
+			assert(Lines(datatotest[2], "doreme", true) == std::vector<unsigned int>{3});
+			assert(Lines(datatotest[3], "abc", true) == std::vector<unsigned int>{4});
+			assert(Lines(datatotest[3], "abc", false) == std::vector<unsigned int>{4});
+			assert(datatotest[4].size() == 3);
+			assert(datatotest[4].begin()->nameofidentifier == "i"); //source order
+			assert(Lines(datatotest[4], "i", true) == std::vector<unsigned int>{5});
+			assert(Lines(datatotest[4], "j", false) == std::vector<unsigned int>{5});
+			assert(Lines(datatotest[4], "k", true).empty());
+			assert(Lines(datatotest[5], "doreme", false) == std::vector<unsigned int>{6});
 		}
     protected:
         void * DataInner() const override {
             return (void*)0; //To silence the warning
         }
     private:
+        static std::vector<unsigned int> Lines(const ExprPolicy::ExprDataSet & set, const std::string & name, bool def){
+            const ExprPolicy::ExprData * entry = set.find(name);
+            assert(entry);
+            const ExprPolicy::LineSet & lines = def ? entry->def : entry->use;
+            return std::vector<unsigned int>(lines.begin(), lines.end());
+        }
         ExprPolicy::ExprDataSet exprdata;
         std::vector<ExprPolicy::ExprDataSet> datatotest;
 };
+//a copied set carries only its entries, not the policy's lookup table
+static_assert(sizeof(ExprPolicy::ExprDataSet) == sizeof(std::vector<ExprPolicy::ExprData>), "ExprDataSet holds more than its entries");
 
 int main(int argc, char** filename){
 	std::string codestr = "void foo(){j = 0; \nk = 1; \ndoreme = 5; \nabc = abc + 0;\n i = j + k;\n foo(abc+doreme);}";
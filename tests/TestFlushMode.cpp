@@ -0,0 +1,75 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <srcSAXBoundedMap.hpp>
+#include <CollectNLContext.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+class TestFlush : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestFlush(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            NLContextPolicy::NLContextData * data = policy->Data<NLContextPolicy::NLContextData>();
+            files.push_back(ctx.currentFilePath);
+            delete data;
+        }
+        std::vector<std::string> files;
+};
+
+int main(int argc, char** filename){
+    {
+        srcSAXEventDispatch::BoundedMap<std::string, int> map(2);
+        map.insert(std::make_pair("a", 1));
+        map.insert(std::make_pair("b", 2));
+        assert(map.find("a") != map.end()); //a is now the most recently used
+        map.insert(std::make_pair("c", 3));
+        assert(map.size() == 2);
+        assert(map.find("b") == map.end());
+        assert(map.find("a")->second == 1);
+        assert(!map.insert(std::make_pair("c", 4)).second);
+        assert(map.Evictions() == 1);
+        map.SetCapacity(1);
+        assert(map.size() == 1 && map.find("c") != map.end());
+    }
+
+    std::vector<std::string> codestrs = {"int a; a = 1;", "int b; b = 2;", "int c; c = 3;"};
+    std::string srcmlstr = StringsToSrcMLArchive(codestrs);
+
+    TestFlush archiveflush;
+    srcSAXEventDispatch::srcSAXEventDispatcher<NLContextPolicy> archive{&archiveflush};
+    srcSAXController archivecontrol(srcmlstr);
+    archivecontrol.parse(&archive);
+    assert(archiveflush.files.size() == 1);
+
+    TestFlush unitflush;
+    srcSAXEventDispatch::srcSAXEventDispatcher<NLContextPolicy> unit{&unitflush};
+    unit.SetFlushMode(srcSAXEventDispatch::FlushMode::unit);
+    srcSAXController unitcontrol(srcmlstr);
+    unitcontrol.parse(&unit);
+    assert((unitflush.files == std::vector<std::string>{"testsrcType0.cpp", "testsrcType1.cpp", "testsrcType2.cpp"}));
+}
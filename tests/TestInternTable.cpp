@@ -0,0 +1,28 @@
+#include <srcSAXSmallSortedSet.hpp>
+#include <srcSAXInternTable.hpp>
+#include <cassert>
+#include <string>
+#include <vector>
+
+int main(int argc, char** filename){
+    {
+        srcSAXEventDispatch::SmallSortedSet<unsigned int, 2> lines;
+        assert(lines.insert(5) && lines.insert(1) && !lines.insert(5));
+        assert(lines.insert(3)); //past the inline capacity
+        assert((std::vector<unsigned int>(lines.begin(), lines.end()) == std::vector<unsigned int>{1, 3, 5}));
+        assert(lines.erase(3) == 1 && lines.erase(3) == 0 && lines.count(5) == 1);
+        srcSAXEventDispatch::SmallSortedSet<unsigned int, 2> copy = lines;
+        assert(copy == lines && copy.size() == 2);
+        lines.clear();
+        assert(lines.empty() && lines.insert(7) && lines.size() == 1);
+    }
+    {
+        srcSAXEventDispatch::InternTable names;
+        for(unsigned int id = 0; id < 100; ++id){
+            assert(names.Intern("name" + std::to_string(id)) == id);
+        }
+        assert(names.Intern("name42") == 42 && names.Name(42) == "name42");
+        assert(names.Find("name99") == 99); //still found after the table grew
+        assert(names.Find("other") == srcSAXEventDispatch::InternTable::npos && names.size() == 100);
+    }
+}
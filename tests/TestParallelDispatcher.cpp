@@ -0,0 +1,128 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXParallelDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <ClassPolicy.hpp>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+class TestParallel : public srcSAXEventDispatch::PolicyDispatcher, public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestParallel(){}
+        TestParallel(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners){}
+        void Notify(const PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            for(const ClassPolicy::ClassData & data : *policy->Data<std::vector<ClassPolicy::ClassData>>()){
+                classnames.insert(data.className);
+            }
+        }
+        std::multiset<std::string> classnames;
+    protected:
+        void * DataInner() const override {
+            return (void*)0; //To silence the warning
+        }
+};
+
+/* a policy with archive-wide results, which a per-unit parallel parse cannot give */
+class ArchiveCountPolicy : public srcSAXEventDispatch::EventListener, public srcSAXEventDispatch::PolicyDispatcher{
+    public:
+        ArchiveCountPolicy(std::initializer_list<srcSAXEventDispatch::PolicyListener *> listeners = {}) : srcSAXEventDispatch::PolicyDispatcher(listeners), units(0){
+            using namespace srcSAXEventDispatch;
+            closeEventMap[ParserState::unit] = [this](srcSAXEventContext& ctx){ ++units; };
+            closeEventMap[ParserState::archive] = [this](srcSAXEventContext& ctx){ NotifyAll(ctx); };
+        }
+    protected:
+        void * DataInner() const override {
+            return (void *)&units;
+        }
+    private:
+        std::size_t units;
+};
+
+int main(int argc, char** filename){
+    std::vector<std::string> codestrs;
+    for(int count = 0; count < 50; ++count){
+        codestrs.push_back("class foo" + std::to_string(count) + " { int x; void bar() { baz(\"a<b\"); } };");
+    }
+    std::string srcmlstr = StringsToSrcMLArchive(codestrs);
+
+    TestParallel serialdata;
+    srcSAXController control(srcmlstr);
+    srcSAXEventDispatch::srcSAXEventDispatcher<ClassPolicy> serial{&serialdata, true};
+    control.parse(&serial); //Start parsing
+
+    std::string prefix;
+    std::vector<std::pair<std::size_t, std::size_t>> units;
+    assert(srcSAXEventDispatch::srcSAXParallelDispatcher<ClassPolicy>::SplitArchive(srcmlstr, prefix, units));
+    assert(units.size() == codestrs.size());
+
+    for(std::size_t threads = 1; threads <= 4; ++threads){
+        TestParallel paralleldata;
+        srcSAXEventDispatch::srcSAXParallelDispatcher<ClassPolicy> parallel(&paralleldata, new srcSAXEventDispatch::srcMLWriter(), threads);
+        parallel.Parse(srcmlstr);
+        assert(parallel.GetArchive() == serial.GetArchive());
+        assert(paralleldata.classnames == serialdata.classnames);
+        assert(paralleldata.classnames.size() == codestrs.size());
+    }
+
+    //a slow sink is entered by one worker at a time and still receives the units in order
+    {
+        std::string written;
+        std::atomic<int> inside(0);
+        bool overlapped = false;
+        srcSAXEventDispatch::srcMLWriter * slow = new srcSAXEventDispatch::srcMLWriter([&](const char * data, std::size_t size){
+            if(++inside > 1) overlapped = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            written.append(data, size);
+            --inside;
+        }, 1);
+        TestParallel paralleldata;
+        srcSAXEventDispatch::srcSAXParallelDispatcher<ClassPolicy> parallel(&paralleldata, slow, 4);
+        parallel.Parse(srcmlstr);
+        assert(!overlapped);
+        assert(written + parallel.GetArchive() == serial.GetArchive());
+        assert(paralleldata.classnames == serialdata.classnames);
+    }
+
+    //archive events would fire once per unit, so such policies are refused before anything is dispatched
+    {
+        TestParallel paralleldata;
+        srcSAXEventDispatch::srcSAXParallelDispatcher<ClassPolicy, ArchiveCountPolicy> parallel(&paralleldata, nullptr, 4);
+        bool threw = false;
+        try{
+            parallel.Parse(srcmlstr);
+        }catch(const std::runtime_error &){
+            threw = true;
+        }
+        assert(threw);
+        assert(paralleldata.classnames.empty());
+    }
+}
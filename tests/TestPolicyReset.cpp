@@ -0,0 +1,95 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <DeclTypePolicy.hpp>
+#include <ParamTypePolicy.hpp>
+#include <cassert>
+#include <memory>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+/* requests a stop at the first scope operator of a type, while its declaration is still open */
+class StopInTypeListener : public srcSAXEventDispatch::EventListener {
+    public:
+        StopInTypeListener() : armed(true) {
+            using namespace srcSAXEventDispatch;
+            closeEventMap[ParserState::op] = [this](srcSAXEventContext& ctx) {
+                if(armed && ctx.IsOpen(ParserState::type)) ctx.dispatcher->StopParse();
+            };
+        }
+        bool armed;
+};
+
+/* every declaration and parameter reported */
+class DeclCollector : public srcSAXEventDispatch::PolicyListener {
+    public:
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            std::unique_ptr<DeclData> data(policy->Data<DeclData>());
+            if(dynamic_cast<const DeclTypePolicy *>(policy)) decls.push_back(*data);
+            else params.push_back(*data);
+        }
+        std::vector<DeclData> decls;
+        std::vector<DeclData> params;
+};
+
+void Parse(srcSAXEventDispatch::srcSAXEventDispatcher<> & dispatcher, const std::string & srcmlstr){
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+}
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    DeclCollector collector;
+    StopInTypeListener * stopper = new StopInTypeListener();
+    srcSAXEventDispatcher<> dispatcher({new DeclTypePolicy{&collector}, new ParamTypePolicy{&collector}, stopper}, nullptr);
+
+    /* both policies are left mid-declaration, holding a specifier and a namespace */
+    Parse(dispatcher, StringsToSrcMLArchive({"const std::string s;"}));
+    assert(dispatcher.IsStopRequested());
+    dispatcher.Reset();
+    Parse(dispatcher, StringsToSrcMLArchive({"void f(static std::string p);"}));
+    assert(dispatcher.IsStopRequested());
+    assert(collector.decls.empty() && collector.params.empty());
+
+    /* the reset dispatcher reports the next document as if it were the first */
+    stopper->armed = false;
+    dispatcher.Reset();
+    Parse(dispatcher, StringsToSrcMLArchive({"int x; void g(int y);"}));
+    assert(!dispatcher.IsStopRequested());
+
+    assert(collector.decls.size() == 1);
+    const DeclData & decl = collector.decls.front();
+    assert(decl.nameoftype == "int" && decl.nameofidentifier == "x");
+    assert(decl.namespaces.empty());
+    assert(!decl.isConst && !decl.isStatic && !decl.isPointer && !decl.isReference);
+
+    assert(collector.params.size() == 1);
+    const DeclData & param = collector.params.front();
+    assert(param.nameoftype == "int" && param.nameofidentifier == "y");
+    assert(param.namespaces.empty());
+    assert(!param.isConst && !param.isStatic && !param.isPointer && !param.isReference);
+}
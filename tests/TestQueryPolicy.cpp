@@ -0,0 +1,85 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <QueryPolicy.hpp>
+#include <cassert>
+#include <stdexcept>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+class TestQuery : public srcSAXEventDispatch::PolicyListener {
+    public:
+        ~TestQuery(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            const QueryPolicy::QueryMatch * match = policy->Data<QueryPolicy::QueryMatch>();
+            if(matches.size() <= match->query) matches.resize(match->query + 1);
+            matches[match->query].push_back(match->text);
+        }
+        std::vector<std::vector<std::string>> matches;
+};
+
+int main(int argc, char** filename){
+    std::string codestr = "// top\n"
+                          "int f(int a) { return g(a, 1); }\n"
+                          "/* block */\n"
+                          "class A { void h() { f(2); } };\n";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestQuery listener;
+    QueryPolicy * queries = new QueryPolicy({&listener});
+    std::size_t functionNames  = queries->AddQuery("//function/name");
+    std::size_t blockComments  = queries->AddQuery("//comment[@type='block']");
+    std::size_t callsOfF       = queries->AddQuery("//call/name[.='f']");
+    std::size_t topFunctions   = queries->AddQuery("/unit/function");
+    std::size_t callLiterals   = queries->AddQuery("//call//literal[@type='number']");
+    std::size_t classCallsOfG  = queries->AddQuery("//class//call/name[contains(., 'g')]");
+    std::size_t lineComments   = queries->AddQuery("//*[@type='line']");
+    std::size_t first = queries->NumberQueries();
+    for(int fn = 0; fn < 100; ++fn)
+        queries->AddQuery("//call/name[.='f" + std::to_string(fn) + "']");
+
+    bool threw = false;
+    try { queries->AddQuery("//call/name[.='f']/argument"); } catch(const std::invalid_argument &) { threw = true; }
+    assert(threw);
+
+    srcSAXEventDispatch::srcSAXEventDispatcher<> handler{queries};
+    queries->RegisterElements(handler);
+    assert(handler.DispatchesElement("comment"));
+
+    srcSAXController control(srcmlstr);
+    control.parse(&handler); //Start parsing
+
+    listener.matches.resize(queries->NumberQueries());
+    assert((listener.matches[functionNames] == std::vector<std::string>{"f", "h"}));
+    assert((listener.matches[blockComments] == std::vector<std::string>{"/* block */"}));
+    assert((listener.matches[callsOfF] == std::vector<std::string>{"f"}));
+    assert(listener.matches[topFunctions].size() == 1);
+    assert(listener.matches[topFunctions][0].compare(0, 5, "int f") == 0);
+    assert((listener.matches[callLiterals] == std::vector<std::string>{"1", "2"}));
+    assert(listener.matches[classCallsOfG].empty());
+    assert((listener.matches[lineComments] == std::vector<std::string>{"// top"}));
+    for(std::size_t query = first; query < queries->NumberQueries(); ++query)
+        assert(listener.matches[query].empty());
+}
@@ -0,0 +1,110 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <SliceProfilePolicy.hpp>
+#include <SliceIndex.hpp>
+#include <cassert>
+#include <sstream>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+	struct srcml_archive* archive;
+	struct srcml_unit* unit;
+	size_t size = 0;
+
+	char *ch = new char[str.size()];
+
+	archive = srcml_archive_create();
+	srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+	srcml_archive_write_open_memory(archive, &ch, &size);
+
+	unit = srcml_unit_create(archive);
+	srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+	srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+	srcml_unit_parse_memory(unit, str.c_str(), str.size());
+	srcml_archive_write_unit(archive, unit);
+	
+	srcml_unit_free(unit);
+	srcml_archive_close(archive);
+	srcml_archive_free(archive);
+	//TrimFromEnd(ch, size);
+	return std::string(ch);
+}
+
+class TestSliceProfile : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestSliceProfile(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            functions.push_back(*policy->Data<SliceProfilePolicy::SliceFunction>());
+        }
+        const SliceProfilePolicy::SliceProfile & Variable(const std::string & function, const std::string & name) const {
+            for(const SliceProfilePolicy::SliceFunction & slicefunction : functions){
+                if(slicefunction.function != function) continue;
+                for(const SliceProfilePolicy::SliceProfile & profile : slicefunction.variables){
+                    if(profile.name == name) return profile;
+                }
+            }
+            assert(false);
+            return functions.front().variables.front();
+        }
+        std::vector<SliceProfilePolicy::SliceFunction> functions;
+};
+
+template<typename Set>
+std::vector<unsigned int> Values(const Set & set){
+    return std::vector<unsigned int>(set.begin(), set.end());
+}
+
+int main(int argc, char** filename){
+    std::string codestr = "int add(int x, int y){\nint sum = x + y;\nreturn sum;\n}\nvoid run(){\nint a = 1;\nint& r = a;\nint b;\nb = a * 2;\nint c = add(b, 3);\nc += r;\n}";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TestSliceProfile profiles;
+    SliceIndex index;
+    SliceProfilePolicy * policy = new SliceProfilePolicy{&profiles, &index}; //owned by the dispatcher
+    srcSAXEventDispatch::srcSAXEventDispatcher<> dispatcher({policy}, nullptr);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+
+    assert(profiles.functions.size() == 2);
+    assert(profiles.functions[0].function == "add" && profiles.functions[1].function == "run");
+    const SliceProfilePolicy::SliceFunction & run = profiles.functions[1];
+    const SliceProfilePolicy::SliceProfile & x = profiles.Variable("add", "x");
+    assert(x.parameter == 1 && x.type == "int");
+    assert((Values(x.defs) == std::vector<unsigned int>{1}));
+    assert((Values(x.uses) == std::vector<unsigned int>{2}));
+    assert(x.dvars.size() == 1 && profiles.functions[0].variables[*x.dvars.begin()].name == "sum");
+    assert(profiles.Variable("add", "y").parameter == 2);
+    assert(profiles.Variable("add", "sum").parameter == 0);
+
+    const SliceProfilePolicy::SliceProfile & a = profiles.Variable("run", "a");
+    assert((Values(a.defs) == std::vector<unsigned int>{6}));
+    assert((Values(a.uses) == std::vector<unsigned int>{7, 9}));
+    assert(a.aliases.size() == 1 && run.variables[*a.aliases.begin()].name == "r");
+    assert(a.dvars.size() == 1 && run.variables[*a.dvars.begin()].name == "b");
+    assert(profiles.Variable("run", "r").isReference);
+    const SliceProfilePolicy::SliceProfile & b = profiles.Variable("run", "b");
+    assert((Values(b.defs) == std::vector<unsigned int>{8, 9}));
+    assert((Values(b.uses) == std::vector<unsigned int>{10}));
+    assert(b.dvars.size() == 1 && run.variables[*b.dvars.begin()].name == "c");
+    assert((b.cfunctions == std::vector<std::pair<std::string, unsigned int>>{{"add", 1}}));
+    const SliceProfilePolicy::SliceProfile & c = profiles.Variable("run", "c");
+    assert((Values(c.defs) == std::vector<unsigned int>{10, 11}));
+    assert((Values(c.uses) == std::vector<unsigned int>{11}));
+
+    const std::string file = "testsrcType.cpp";
+    assert(index.NumberFunctions() == 2 && index.NumberVariables() == 7);
+    index.Compute(1);
+    assert((index.SliceLines(file, "run", "a") == std::vector<unsigned int>{6, 7, 8, 9, 10, 11}));
+    assert((index.SliceReach(file, "run", "a") == std::vector<std::string>{"add:x", "add:sum"}));
+    assert((index.SliceLines(file, "add", "y") == std::vector<unsigned int>{1, 2, 3}));
+    assert(index.SliceReach(file, "run", "c").empty());
+    assert(index.Find(file, "run", "x") == SliceIndex::npos);
+
+    //slicing in parallel gives the same columns
+    std::ostringstream serial, parallel;
+    index.WriteColumns(serial);
+    index.Compute(4);
+    index.WriteColumns(parallel);
+    assert(serial.str() == parallel.str());
+    assert(serial.str().compare(0, 19, "srcslice-columns 7\n") == 0);
+}
@@ -0,0 +1,109 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <srcSAXSpillAggregator.hpp>
+#include <CollectNLContext.hpp>
+#include <cassert>
+#include <map>
+class TestSpill : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestSpill(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            NLContextPolicy::NLContextData * data = policy->Data<NLContextPolicy::NLContextData>();
+            ++notifications;
+            for(const NLContextPolicy::NLSet & set : data->nlsetmap){
+                sets.push_back(set.name + ":" + set.category + ":" + set.context);
+            }
+            delete data;
+        }
+        std::size_t notifications = 0;
+        std::vector<std::string> sets;
+};
+
+int main(int argc, char** filename){
+    {
+        std::map<std::string, std::string> expected;
+        srcSAXEventDispatch::SpillAggregator<std::string> aggregator(512, [](std::string & into, const std::string & from){ into += from; });
+        for(int pos = 0; pos < 2000; ++pos){
+            std::string key = "key" + std::to_string(pos * 7 % 97);
+            std::string value = std::to_string(pos) + ",";
+            aggregator.Add(key, value);
+            expected[key] += value;
+        }
+        assert(aggregator.Runs() > 1);
+        assert(aggregator.SpilledBytes() > 0);
+
+        std::map<std::string, std::string> merged;
+        std::string key, value, last;
+        std::unique_ptr<srcSAXEventDispatch::SpillAggregator<std::string>::Reader> reader = aggregator.Read();
+        while(reader->Next(key, value)){
+            assert(last < key); //sorted, each key once
+            last = key;
+            merged[key] = value;
+        }
+        assert(merged == expected);
+
+        //more runs than are merged at once
+        srcSAXEventDispatch::SpillAggregator<std::string> many(1, [](std::string & into, const std::string & from){ into += from; });
+        for(std::size_t pos = 0; pos < 3 * many.FAN_IN; ++pos){
+            many.Add("same", std::to_string(pos) + ",");
+        }
+        std::string all;
+        for(std::size_t pos = 0; pos < 3 * many.FAN_IN; ++pos){
+            all += std::to_string(pos) + ",";
+        }
+        reader = many.Read();
+        assert(reader->Next(key, value) && key == "same" && value == all);
+        assert(!reader->Next(key, value));
+        reader.reset();
+
+        many.Clear();
+        assert(many.Empty() && many.Runs() == 0);
+    }
+
+    //identifiers annotated with parts of speech, as SourceNLPolicy expects; a is declared twice, a noun then a verb
+    std::string srcmlstr = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<unit xmlns=\"http://www.srcML.org/srcML/src\" revision=\"0.9.5\">\n"
+        "<unit revision=\"0.9.5\" language=\"C++\" filename=\"a.cpp\"><decl_stmt><decl><type><name>int</name></type> <name><noun>a</noun></name></decl>;</decl_stmt>"
+        "<expr_stmt><expr><name>a</name> <operator>=</operator> <literal type=\"number\">1</literal></expr>;</expr_stmt></unit>\n"
+        "<unit revision=\"0.9.5\" language=\"C++\" filename=\"b.cpp\"><decl_stmt><decl><type><name>int</name></type> <name><noun>b</noun></name></decl>;</decl_stmt>"
+        "<expr_stmt><expr><name>a</name> <operator>=</operator> <literal type=\"number\">2</literal></expr>;</expr_stmt></unit>\n"
+        "<unit revision=\"0.9.5\" language=\"C++\" filename=\"c.cpp\"><decl_stmt><decl><type><name>float</name></type> <name><verb>a</verb></name></decl>;</decl_stmt>"
+        "<expr_stmt><expr><name>b</name> <operator>=</operator> <literal type=\"number\">3</literal></expr>;</expr_stmt></unit>\n"
+        "</unit>\n";
+
+    //in memory, a use takes the category of the declarations before it
+    TestSpill inmemory;
+    srcSAXEventDispatch::srcSAXEventDispatcher<NLContextPolicy> reference{&inmemory};
+    srcSAXController referencecontrol(srcmlstr);
+    referencecontrol.parse(&reference);
+    assert((inmemory.sets == std::vector<std::string>{"a:snoun:none", "a:snoun:none", "b:snoun:none"}));
+    assert(inmemory.notifications == 1);
+
+    //spilling at every addition gives the same sets in the same notification
+    TestSpill spilled;
+    NLContextPolicy * policy = new NLContextPolicy{&spilled}; //owned by the dispatcher
+    policy->SetSpill(1);
+    srcSAXEventDispatch::srcSAXEventDispatcher<> dispatcher({policy}, nullptr);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+    assert(spilled.sets == inmemory.sets);
+    assert(spilled.notifications == 1);
+
+    //batches split the same sets, in the same order
+    TestSpill batched;
+    NLContextPolicy * batchpolicy = new NLContextPolicy{&batched};
+    batchpolicy->SetSpill(1, "", 2);
+    srcSAXEventDispatch::srcSAXEventDispatcher<> batchdispatcher({batchpolicy}, nullptr);
+    srcSAXController batchcontrol(srcmlstr);
+    batchcontrol.parse(&batchdispatcher);
+    assert(batched.sets == inmemory.sets);
+    assert(batched.notifications == 2);
+
+    //a reset dispatcher joins only the next document
+    spilled.sets.clear();
+    spilled.notifications = 0;
+    dispatcher.Reset();
+    srcSAXController again(srcmlstr);
+    again.parse(&dispatcher);
+    assert(spilled.sets == inmemory.sets && spilled.notifications == 1);
+}
@@ -0,0 +1,101 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+/* records events, and requests a stop when the declaration of stopAt closes */
+class StopListener : public srcSAXEventDispatch::EventListener {
+    public:
+        StopListener(const std::string & stopAt) : stopAt(stopAt), stopIndex(0) {
+            using namespace srcSAXEventDispatch;
+            for(ParserState state : {ParserState::archive, ParserState::unit, ParserState::declstmt, ParserState::decl, ParserState::exprstmt, ParserState::name}){
+                openEventMap[state] = [this, state](srcSAXEventContext& ctx) {
+                    events.push_back("open " + std::to_string(state));
+                };
+                closeEventMap[state] = [this, state](srcSAXEventContext& ctx) {
+                    events.push_back("close " + std::to_string(state));
+                };
+            }
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                events.push_back("token " + ctx.currentToken);
+                if(ctx.IsOpen(ParserState::decl) && ctx.IsOpen(ParserState::name) && ctx.currentToken == this->stopAt) declaration = true;
+            };
+            closeEventMap[ParserState::decl] = [this](srcSAXEventContext& ctx) {
+                events.push_back("close " + std::to_string(ParserState::decl));
+                if(!declaration) return;
+                declaration = false;
+                stopIndex = events.size();
+                ctx.dispatcher->StopParse();
+            };
+        }
+        std::string stopAt;
+        bool declaration = false;
+        std::size_t stopIndex;
+        std::vector<std::string> events;
+};
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    std::vector<std::string> codestrs = {"int a; a = 1;", "int b; b = 2;", "int c; c = 3;"};
+    std::string srcmlstr = StringsToSrcMLArchive(codestrs);
+
+    /* stopped in the middle of the second unit: the ";" buffered after the
+       declaration, the rest of the unit and the third unit are not dispatched */
+    StopListener * listener = new StopListener("b");
+    srcSAXEventDispatcher<> handler{listener};
+    srcSAXController control(srcmlstr);
+    control.parse(&handler);
+
+    assert(handler.IsStopRequested());
+    assert(listener->stopIndex != 0);
+    std::vector<std::string> after(listener->events.begin() + listener->stopIndex, listener->events.end());
+    assert((after == std::vector<std::string>{
+        "close " + std::to_string(ParserState::unit),
+        "close " + std::to_string(ParserState::unit),
+        "close " + std::to_string(ParserState::archive)}));
+    std::size_t units = 0;
+    for(const std::string & event : listener->events){
+        if(event == "open " + std::to_string(ParserState::unit)) ++units;
+    }
+    assert(units == 3); //the root and two source units
+
+    /* a reset dispatcher parses the whole archive again */
+    listener->stopAt = "none";
+    listener->events.clear();
+    handler.Reset();
+    assert(!handler.IsStopRequested());
+    srcSAXController again(srcmlstr);
+    again.parse(&handler);
+    assert(listener->events.back() == "close " + std::to_string(ParserState::archive));
+    units = 0;
+    for(const std::string & event : listener->events){
+        if(event == "open " + std::to_string(ParserState::unit)) ++units;
+    }
+    assert(units == 4);
+}
@@ -0,0 +1,109 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <SymbolResolutionPolicy.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringsToSrcMLArchive(std::vector<std::string> strs){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(std::size_t pos = 0; pos < strs.size(); ++pos){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+        srcml_unit_set_filename(unit, ("testsrcType" + std::to_string(pos) + ".cpp").c_str());
+
+        srcml_unit_parse_memory(unit, strs[pos].c_str(), strs[pos].size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+class TestResolution : public srcSAXEventDispatch::PolicyListener{
+    public:
+        ~TestResolution(){}
+        void Notify(const srcSAXEventDispatch::PolicyDispatcher * policy, const srcSAXEventDispatch::srcSAXEventContext & ctx) override {
+            ++notifications;
+            unresolved = policy->Data<SymbolIndex>()->Unresolved();
+        }
+        std::size_t notifications = 0;
+        std::vector<std::pair<std::string, unsigned int>> unresolved;
+};
+
+//the candidates of a call, as name@file:line
+std::vector<std::string> Candidates(const SymbolIndex & index, const std::string & callee, unsigned int arity){
+    std::vector<std::string> candidates;
+    for(const SymbolIndex::Definition & definition : index.Candidates(callee, arity)){
+        assert(definition.arity == arity);
+        candidates.push_back(definition.name + "@" + definition.file + ":" + std::to_string(definition.line));
+    }
+    return candidates;
+}
+
+int main(int argc, char** filename){
+    std::vector<std::string> codestrs = {
+        "int add(int a, int b){ return a + b; }\nnamespace N {\nint add(int a){ return a; }\n}\nstruct S {\nint get(){ return add(1, 2); }\nvoid set(int v);\n};",
+        "void S::set(int v){ get(); }\nvoid run(S s){\nadd(1, 2);\nadd(3);\nN::add(4);\ns.get();\ns.set(add(5, 6));\nmissing();\n}"
+    };
+    std::string srcmlstr = StringsToSrcMLArchive(codestrs);
+
+    TestResolution listener;
+    SymbolResolutionPolicy * policy = new SymbolResolutionPolicy{&listener}; //owned by the dispatcher
+    srcSAXEventDispatch::srcSAXEventDispatcher<> dispatcher({policy}, nullptr);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+    assert(listener.notifications == 1);
+    assert((listener.unresolved == std::vector<std::pair<std::string, unsigned int>>{{"missing", 0}}));
+
+    const SymbolIndex & index = policy->Index();
+    assert(index.NumberDefinitions() == 5);
+    assert(index.NumberCallSymbols() == 7);
+    assert(index.Sites("add", 2) == 3 && index.Sites("add", 1) == 1 && index.Sites("add", 3) == 0);
+    //calls in the second unit resolve to definitions in the first
+    assert((Candidates(index, "add", 2) == std::vector<std::string>{"add@testsrcType0.cpp:1"}));
+    assert((Candidates(index, "add", 1) == std::vector<std::string>{"N::add@testsrcType0.cpp:3"}));
+    assert((Candidates(index, "N::add", 1) == std::vector<std::string>{"N::add@testsrcType0.cpp:3"}));
+    assert((Candidates(index, "get", 0) == std::vector<std::string>{"S::get@testsrcType0.cpp:6"}));
+    assert((Candidates(index, "s.get", 0) == std::vector<std::string>{"S::get@testsrcType0.cpp:6"}));
+    assert((Candidates(index, "s.set", 1) == std::vector<std::string>{"S::set@testsrcType1.cpp:1"}));
+    assert(Candidates(index, "missing", 0).empty());
+
+    //constructors and destructors are definitions, named without their member initializers
+    {
+        std::string structors = StringsToSrcMLArchive({"struct T {\nT(int a, int b) : base(a) {}\n~T(){}\n};\nvoid make(){ T(1, 2); }"});
+        TestResolution structorListener;
+        SymbolResolutionPolicy * structorPolicy = new SymbolResolutionPolicy{&structorListener};
+        srcSAXEventDispatch::srcSAXEventDispatcher<> structorDispatcher({structorPolicy}, nullptr);
+        srcSAXController structorControl(structors);
+        structorControl.parse(&structorDispatcher);
+        const SymbolIndex & structorIndex = structorPolicy->Index();
+        assert(structorIndex.NumberDefinitions() == 3);
+        assert((Candidates(structorIndex, "T", 2) == std::vector<std::string>{"T::T@testsrcType0.cpp:2"}));
+        assert((structorListener.unresolved == std::vector<std::pair<std::string, unsigned int>>{{"base", 1}}));
+        SymbolIndex destructor = structorIndex;
+        destructor.AddCall("~T", 0);
+        destructor.Resolve();
+        assert((Candidates(destructor, "~T", 0) == std::vector<std::string>{"T::~T@testsrcType0.cpp:3"}));
+    }
+
+    //qualified calls keep only definitions in that scope
+    SymbolIndex scoped;
+    scoped.AddDefinition("A::B::f", 1, "x.cpp", 1);
+    scoped.AddDefinition("C::f", 1, "x.cpp", 2);
+    scoped.AddDefinition("AB::f", 1, "x.cpp", 3);
+    scoped.AddCall("B::f", 1);
+    scoped.AddCall("p->f", 1);
+    scoped.Resolve();
+    assert((Candidates(scoped, "B::f", 1) == std::vector<std::string>{"A::B::f@x.cpp:1"}));
+    assert(Candidates(scoped, "p->f", 1).size() == 3);
+}
@@ -0,0 +1,76 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <cassert>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/* collects the tokens of string literals and comments */
+class TextListener : public srcSAXEventDispatch::EventListener {
+    public:
+        TextListener() {
+            using namespace srcSAXEventDispatch;
+            closeEventMap[ParserState::tokenstring] = [this](srcSAXEventContext& ctx) {
+                if(ctx.Element() == ElementId::literal) literals.push_back(ctx.currentToken);
+                else if(ctx.Element() == ElementId::comment) comments.push_back(ctx.currentToken);
+            };
+        }
+        std::vector<std::string> literals, comments;
+};
+
+/* counts the character callbacks srcSAX makes */
+class CountingDispatcher : public srcSAXEventDispatch::srcSAXEventDispatcher<> {
+    public:
+        CountingDispatcher(srcSAXEventDispatch::EventListener * listener) : srcSAXEventDispatch::srcSAXEventDispatcher<>({listener}, nullptr), callbacks(0) {}
+        void charactersUnit(const char * ch, int len) override {
+            ++callbacks;
+            srcSAXEventDispatch::srcSAXEventDispatcher<>::charactersUnit(ch, len);
+        }
+        std::size_t callbacks;
+};
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    //entities split the literal's text; a long comment spans the parser's character chunks
+    std::string literal = "\"a<b&c>d\"";
+    std::string comment = "/*";
+    for(int line = 0; line < 200; ++line){
+        comment += " line " + std::to_string(line) + " < & >\n";
+    }
+    comment += "*/";
+    std::string codestr = "const char * s = " + literal + ";\n" + comment + "\n";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    TextListener * listener = new TextListener();
+    CountingDispatcher handler(listener);
+    srcSAXController control(srcmlstr);
+    control.parse(&handler);
+
+    assert((listener->literals == std::vector<std::string>{literal}));
+    assert((listener->comments == std::vector<std::string>{comment}));
+    //the split callbacks were joined, one tokenstring per text run; the literal alone arrives in seven
+    assert(handler.callbacks >= handler.GetStats().textNodes + 6);
+}
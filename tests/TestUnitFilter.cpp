@@ -0,0 +1,110 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXEventRecorder.hpp>
+#include <srcSAXHandler.hpp>
+#include <cassert>
+#include <iostream>
+#include <srcml.h>
+
+struct Source {
+    std::string filename, language, code;
+};
+
+std::string SourcesToSrcMLArchive(std::vector<Source> sources){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = 0;
+
+    archive = srcml_archive_create();
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    for(const Source & source : sources){
+        unit = srcml_unit_create(archive);
+        srcml_unit_set_language(unit, source.language.c_str());
+        srcml_unit_set_filename(unit, source.filename.c_str());
+
+        srcml_unit_parse_memory(unit, source.code.c_str(), source.code.size());
+        srcml_archive_write_unit(archive, unit);
+        srcml_unit_free(unit);
+    }
+
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    return std::string(ch, size);
+}
+
+typedef srcSAXEventDispatch::srcSAXEventDispatcher<srcSAXEventDispatch::EventRecorderPolicy> Dispatcher;
+
+/* one filtered parse: the units dispatched, their events and the regenerated archive */
+struct Run {
+    std::vector<std::string> files;
+    std::vector<srcSAXEventDispatch::UnitRecording> recordings;
+    std::string archive;
+    srcSAXEventDispatch::DispatchStats stats;
+};
+
+Run Parse(const std::string & srcmlstr, const srcSAXEventDispatch::UnitFilter & filter){
+    Run run;
+    srcSAXEventDispatch::RecordingListener listener;
+    Dispatcher dispatcher(&listener, true);
+    dispatcher.SetUnitFilter(filter);
+    srcSAXController control(srcmlstr);
+    control.parse(&dispatcher);
+    for(const srcSAXEventDispatch::UnitRecording & recording : listener.recordings){
+        if(recording.leaf) run.files.push_back(recording.filename);
+    }
+    run.recordings = listener.recordings;
+    run.archive = dispatcher.GetArchive();
+    run.stats = dispatcher.GetStats();
+    return run;
+}
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    std::vector<Source> sources = {
+        { "src/a.cpp", "C++", "int a; a = 1;" },
+        { "src/b.java", "Java", "class B { }" },
+        { "vendor/c.cpp", "C++", "int c; c = 3;" },
+        { "src/big.cpp", "C++", "int d; d = 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8;" },
+    };
+    std::string srcmlstr = SourcesToSrcMLArchive(sources);
+
+    Run all = Parse(srcmlstr, UnitFilter());
+    assert((all.files == std::vector<std::string>{"src/a.cpp", "src/b.java", "vendor/c.cpp", "src/big.cpp"}));
+
+    Run included = Parse(srcmlstr, UnitFilter().Include({"src/*"}));
+    assert((included.files == std::vector<std::string>{"src/a.cpp", "src/b.java", "src/big.cpp"}));
+    assert(included.stats.unitsSkipped == 1);
+    assert(included.archive.find("vendor/c.cpp") == std::string::npos);
+
+    Run excluded = Parse(srcmlstr, UnitFilter().Include({"src/*"}).Exclude({"*.java", "src/?ig.cpp"}));
+    assert((excluded.files == std::vector<std::string>{"src/a.cpp"}));
+    assert(excluded.stats.unitsSkipped == 3);
+
+    Run language = Parse(srcmlstr, UnitFilter().Languages({"C++"}));
+    assert((language.files == std::vector<std::string>{"src/a.cpp", "vendor/c.cpp", "src/big.cpp"}));
+    assert(language.archive.find("class B") == std::string::npos);
+
+    /* the oversized unit is dropped whole, from the events and the archive;
+       units that fit are dispatched exactly as if there were no size limit */
+    Run sized = Parse(srcmlstr, UnitFilter().MaxUnitSize(20));
+    Run withoutBig = Parse(srcmlstr, UnitFilter().Exclude({"src/big.cpp"}));
+    assert((sized.files == std::vector<std::string>{"src/a.cpp", "src/b.java", "vendor/c.cpp"}));
+    assert(sized.stats.unitsOversized == 1 && sized.stats.unitsSkipped == 0);
+    assert(sized.archive.find("big.cpp") == std::string::npos);
+    assert(sized.archive.find("<literal type=\"number\">8</literal>") == std::string::npos);
+    assert(sized.archive == withoutBig.archive);
+    assert(CompareRecordings(withoutBig.recordings, sized.recordings, RecordingComparison::ordered, std::cerr));
+
+    /* every unit fits: same as unfiltered */
+    Run roomy = Parse(srcmlstr, UnitFilter().MaxUnitSize(1000));
+    assert(roomy.archive == all.archive);
+    assert(CompareRecordings(all.recordings, roomy.recordings, RecordingComparison::ordered, std::cerr));
+
+    /* criteria combine */
+    Run combined = Parse(srcmlstr, UnitFilter().Languages({"C++"}).Exclude({"vendor/*"}).MaxUnitSize(20));
+    assert((combined.files == std::vector<std::string>{"src/a.cpp"}));
+    assert(combined.stats.unitsSkipped == 2 && combined.stats.unitsOversized == 1);
+}
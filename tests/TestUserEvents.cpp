@@ -0,0 +1,114 @@
+#include <srcSAXEventDispatcher.hpp>
+#include <srcSAXHandler.hpp>
+#include <cassert>
+#include <stdexcept>
+#include <srcml.h>
+std::string StringToSrcML(std::string str){
+    struct srcml_archive* archive;
+    struct srcml_unit* unit;
+    size_t size = 0;
+
+    char *ch = new char[str.size()];
+
+    archive = srcml_archive_create();
+    srcml_archive_enable_option(archive, SRCML_OPTION_POSITION);
+    srcml_archive_write_open_memory(archive, &ch, &size);
+
+    unit = srcml_unit_create(archive);
+    srcml_unit_set_language(unit, SRCML_LANGUAGE_CXX);
+    srcml_unit_set_filename(unit, "testsrcType.cpp");
+
+    srcml_unit_parse_memory(unit, str.c_str(), str.size());
+    srcml_archive_write_unit(archive, unit);
+
+    srcml_unit_free(unit);
+    srcml_archive_close(archive);
+    srcml_archive_free(archive);
+    //TrimFromEnd(ch, size);
+    return std::string(ch);
+}
+
+/* collects the text of comments through a user-defined event */
+class CommentListener : public srcSAXEventDispatch::EventListener {
+    public:
+        CommentListener() : opened(0) {}
+        void Subscribe(srcSAXEventDispatch::ParserState comment) {
+            using namespace srcSAXEventDispatch;
+            openEventMap[comment] = [this, comment](srcSAXEventContext& ctx) {
+                assert(ctx.triggerField[comment] == 1);
+                assert(ctx.currentTag == "comment");
+                ++opened;
+                comments.push_back("");
+            };
+            closeEventMap[ParserState::tokenstring] = [this, comment](srcSAXEventContext& ctx) {
+                if(ctx.triggerField[comment]) comments.back() += ctx.currentToken;
+            };
+        }
+        std::size_t opened;
+        std::vector<std::string> comments;
+};
+
+/* a listener written against ParserState::userdefined, telling elements apart by tag */
+class UserDefinedListener : public srcSAXEventDispatch::EventListener {
+    public:
+        UserDefinedListener() : opened(0), closed(0) {
+            using namespace srcSAXEventDispatch;
+            openEventMap[ParserState::userdefined] = [this](srcSAXEventContext& ctx) {
+                assert(ctx.triggerField[ParserState::userdefined] == 1);
+                tags.push_back(ctx.currentTag);
+                ++opened;
+            };
+            closeEventMap[ParserState::userdefined] = [this](srcSAXEventContext& ctx) {
+                ++closed;
+            };
+        }
+        std::size_t opened, closed;
+        std::vector<std::string> tags;
+};
+
+int main(int argc, char** filename){
+    using namespace srcSAXEventDispatch;
+
+    std::string codestr = "int x; // one\n/* two */ int y;";
+    std::string srcmlstr = StringToSrcML(codestr);
+
+    CommentListener * listener = new CommentListener();
+    srcSAXEventDispatcher<> handler{listener};
+
+    ParserState comment = handler.AddEvent("comment");
+    assert(comment == FIRSTUSEREVENT);
+    assert(handler.AddEvent("comment") == comment);
+    assert(handler.EventId("comment") == comment);
+    assert(handler.AddEvents({"comment", "escape"})[1] == ParserState(FIRSTUSEREVENT + 1));
+
+    bool threw = false;
+    try { handler.AddEvent("literal"); } catch(const std::invalid_argument &) { threw = true; }
+    assert(threw);
+
+    listener->Subscribe(comment);
+    srcSAXController control(srcmlstr);
+    control.parse(&handler); //Start parsing
+
+    assert(listener->opened == 2);
+    assert(listener->comments[0] == "// one");
+    assert(listener->comments[1] == "/* two */");
+
+    /* added events are still raised as userdefined */
+    {
+        UserDefinedListener * generic = new UserDefinedListener();
+        srcSAXEventDispatcher<> userdefined{generic};
+        userdefined.AddEvent("comment");
+        srcSAXController genericControl(srcmlstr);
+        genericControl.parse(&userdefined);
+        assert(generic->opened == 2 && generic->closed == 2);
+        assert((generic->tags == std::vector<std::string>{"comment", "comment"}));
+    }
+
+    /* removed events are not dispatched but keep their id */
+    handler.RemoveEvent("comment");
+    handler.Reset();
+    srcSAXController again(srcmlstr);
+    again.parse(&handler);
+    assert(listener->opened == 2);
+    assert(handler.AddEvent("comment") == comment);
+}